@@ -0,0 +1,471 @@
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "array/array.h"
+#include "array/gap_array.h"
+#include "array/small_array.h"
+#include "array/soa_array.h"
+#include "utils/bench.h"
+
+// Number of malloc, calloc and realloc calls. These replace glibc's
+// functions for the whole program, operator new included, and forward to
+// them.
+static std::size_t allocation_count = 0;
+
+extern "C" {
+void* __libc_malloc(std::size_t size);
+void* __libc_calloc(std::size_t count, std::size_t size);
+void* __libc_realloc(void* pointer, std::size_t size);
+
+void* malloc(std::size_t size) {
+  ++allocation_count;
+  return __libc_malloc(size);
+}
+
+void* calloc(std::size_t count, std::size_t size) {
+  ++allocation_count;
+  return __libc_calloc(count, size);
+}
+
+void* realloc(void* pointer, std::size_t size) {
+  ++allocation_count;
+  return __libc_realloc(pointer, size);
+}
+}
+
+namespace {
+
+using namespace td;
+
+// A record of two strings, both too long for small string optimization.
+struct Record {
+  std::string name;
+  std::string value;
+};
+
+Record make_record(std::size_t i) {
+  return {"name of record number " + std::to_string(i),
+          "value of record number " + std::to_string(i)};
+}
+
+// Run |function| in a child process, so its peak RSS is measured alone, and
+// print its time per operation and peak RSS.
+template <typename Function>
+void run_isolated(const char* name, std::size_t operations,
+                  Function&& function) {
+  std::fflush(stdout);
+  pid_t pid = fork();
+  if (pid == 0) {
+    bench::report(name, bench::elapsed_ns(function), operations);
+    std::fflush(stdout);
+    _exit(0);
+  }
+
+  int status = 0;
+  struct rusage usage {};
+  wait4(pid, &status, 0, &usage);
+  std::printf("%-48s %10ld KiB peak RSS\n", name, usage.ru_maxrss);
+}
+
+// Measure appending |count| integers and |count| / 50 records one by one,
+// against std::vector.
+void bench_append(std::size_t count) {
+  run_isolated("append int, Array", count, [&] {
+    Array<std::uint32_t> array;
+    for (std::size_t i = 0; i < count; ++i)
+      array.append(static_cast<std::uint32_t>(i));
+    bench::do_not_optimize(array[count - 1]);
+  });
+  run_isolated("append int, std::vector", count, [&] {
+    std::vector<std::uint32_t> vector;
+    for (std::size_t i = 0; i < count; ++i)
+      vector.push_back(static_cast<std::uint32_t>(i));
+    bench::do_not_optimize(vector[count - 1]);
+  });
+
+  std::size_t record_count = count / 50;
+  run_isolated("append record, Array", record_count, [&] {
+    Array<Record> array;
+    for (std::size_t i = 0; i < record_count; ++i)
+      array.append(make_record(i));
+    bench::do_not_optimize(array[record_count - 1]);
+  });
+  run_isolated("append record, std::vector", record_count, [&] {
+    std::vector<Record> vector;
+    for (std::size_t i = 0; i < record_count; ++i)
+      vector.push_back(make_record(i));
+    bench::do_not_optimize(vector[record_count - 1]);
+  });
+}
+
+// Measure appending |count| integers with each growth policy.
+void bench_growth_policies(std::size_t count) {
+  run_isolated("append int, Array HalfGrowth", count, [&] {
+    Array<std::uint32_t, MallocAllocator<std::uint32_t>, array::HalfGrowth>
+        array;
+    for (std::size_t i = 0; i < count; ++i)
+      array.append(static_cast<std::uint32_t>(i));
+    bench::do_not_optimize(array[count - 1]);
+  });
+  run_isolated("append int, Array PageGrowth", count, [&] {
+    Array<std::uint32_t, MallocAllocator<std::uint32_t>, array::PageGrowth<>>
+        array;
+    for (std::size_t i = 0; i < count; ++i)
+      array.append(static_cast<std::uint32_t>(i));
+    bench::do_not_optimize(array[count - 1]);
+  });
+  run_isolated("append record, Array HalfGrowth", count / 50, [&] {
+    Array<Record, MallocAllocator<Record>, array::HalfGrowth> array;
+    for (std::size_t i = 0; i < count / 50; ++i)
+      array.append(make_record(i));
+    bench::do_not_optimize(array[count / 50 - 1]);
+  });
+}
+
+// Measure |cycles| rounds of appending |burst| items and popping them all:
+// time and allocations per item.
+template <typename ItemType>
+void bench_push_pop(const char* name, std::size_t burst, std::size_t cycles) {
+  Array<ItemType> array;
+  std::size_t allocations = allocation_count;
+  double ns = bench::elapsed_ns([&] {
+    for (std::size_t cycle = 0; cycle < cycles; ++cycle) {
+      for (std::size_t i = 0; i < burst; ++i)
+        array.append(ItemType());
+      for (std::size_t i = 0; i < burst; ++i)
+        bench::do_not_optimize(array.pop());
+    }
+  });
+  allocations = allocation_count - allocations;
+
+  bench::report(name, ns, 2 * burst * cycles);
+  std::printf("%-48s %10.4f allocations/op\n", name,
+              static_cast<double>(allocations) / (2 * burst * cycles));
+}
+
+void bench_push_pop_cycles(std::size_t count) {
+  bench_push_pop<int>("push/pop 1000, int", 1000, count / 2000);
+  bench_push_pop<std::string>("push/pop 1000, string", 1000, count / 20000);
+}
+
+// Measure summing and transforming |count| integers through checked |at|,
+// unchecked |operator[]| and iterators.
+void bench_access(std::size_t count) {
+  Array<std::uint32_t> array;
+  for (std::size_t i = 0; i < count; ++i)
+    array.append(static_cast<std::uint32_t>(i));
+
+  std::uint64_t sum = 0;
+  double ns = bench::elapsed_ns([&] {
+    for (std::size_t i = 0; i < array.size(); ++i)
+      sum += array.at(i);
+  });
+  bench::do_not_optimize(sum);
+  bench::report("sum, at", ns, count);
+
+  ns = bench::elapsed_ns([&] {
+    for (std::size_t i = 0; i < array.size(); ++i)
+      sum += array[i];
+  });
+  bench::do_not_optimize(sum);
+  bench::report("sum, operator[]", ns, count);
+
+  ns = bench::elapsed_ns([&] {
+    sum += std::accumulate(array.begin(), array.end(), std::uint64_t{0});
+  });
+  bench::do_not_optimize(sum);
+  bench::report("sum, iterators", ns, count);
+
+  ns = bench::elapsed_ns([&] {
+    for (std::size_t i = 0; i < array.size(); ++i)
+      array.at(i) = array.at(i) * 3 + 1;
+  });
+  bench::do_not_optimize(array[count - 1]);
+  bench::report("transform, at", ns, count);
+
+  ns = bench::elapsed_ns([&] {
+    for (std::size_t i = 0; i < array.size(); ++i)
+      array[i] = array[i] * 3 + 1;
+  });
+  bench::do_not_optimize(array[count - 1]);
+  bench::report("transform, operator[]", ns, count);
+
+  ns = bench::elapsed_ns([&] {
+    std::transform(array.begin(), array.end(), array.begin(),
+                   [](std::uint32_t item) { return item * 3 + 1; });
+  });
+  bench::do_not_optimize(array[count - 1]);
+  bench::report("transform, iterators", ns, count);
+}
+
+// Return |count| integers where each value in [0, 64) appears in turn.
+Array<std::int32_t> make_cycle(std::size_t count) {
+  Array<std::int32_t> array;
+  for (std::size_t i = 0; i < count; ++i)
+    array.append(static_cast<std::int32_t>(i % 64));
+  return array;
+}
+
+// Measure |find| of a missing value and |count| against scalar standard
+// algorithms, and removing one value in 64 against removing matches one by
+// one with |remove_at|, which is quadratic so it runs on |count| / 1000
+// items.
+void bench_find_remove(std::size_t count) {
+  Array<std::int32_t> array = make_cycle(count);
+  std::size_t index = 0;
+  double ns = bench::elapsed_ns([&] {
+    index = std::find(array.begin(), array.end(), -1) - array.begin();
+  });
+  bench::do_not_optimize(index);
+  bench::report("find, std::find", ns, count);
+
+  ns = bench::elapsed_ns([&] { index = array.find(-1); });
+  bench::do_not_optimize(index);
+  bench::report("find, Array::find", ns, count);
+
+  ns = bench::elapsed_ns(
+      [&] { index = std::count(array.begin(), array.end(), 7); });
+  bench::do_not_optimize(index);
+  bench::report("count, std::count", ns, count);
+
+  ns = bench::elapsed_ns([&] { index = array.count(7); });
+  bench::do_not_optimize(index);
+  bench::report("count, Array::count", ns, count);
+
+  ns = bench::elapsed_ns([&] { index = array.remove(7); });
+  bench::do_not_optimize(index);
+  bench::report("remove, Array::remove", ns, count);
+
+  ns = bench::elapsed_ns([&] {
+    index = array.remove_if([](std::int32_t item) { return item % 2; });
+  });
+  bench::do_not_optimize(index);
+  bench::report("remove odd, Array::remove_if", ns, count - count / 64);
+
+  std::size_t small_count = count / 1000;
+  Array<std::int32_t> small_array = make_cycle(small_count);
+  ns = bench::elapsed_ns([&] {
+    for (std::size_t i = 0; i < small_array.size(); ++i) {
+      if (small_array[i] == 7)
+        small_array.remove_at(i--);
+    }
+  });
+  bench::do_not_optimize(small_array[0]);
+  bench::report("remove, remove_at loop (1/1000 items)", ns, small_count);
+}
+
+// Measure |edits| edits of an array of |size| integers: inserts at random
+// positions, and inserts and removes in a 2:1 mix at a cursor which moves
+// by up to 16 items either way.
+template <typename ArrayType>
+void bench_edits(const char* name, std::size_t size, std::size_t edits) {
+  std::mt19937 random(42);
+  ArrayType array;
+  for (std::size_t i = 0; i < size; ++i)
+    array.append(static_cast<int>(i));
+
+  double ns = bench::elapsed_ns([&] {
+    for (std::size_t i = 0; i < edits; ++i)
+      array.insert(static_cast<int>(i), random() % (array.size() + 1));
+  });
+  char label[64];
+  std::snprintf(label, sizeof(label), "random insert, %s", name);
+  bench::report(label, ns, edits);
+
+  std::size_t cursor = array.size() / 2;
+  ns = bench::elapsed_ns([&] {
+    for (std::size_t i = 0; i < edits; ++i) {
+      std::size_t step = random() % 33;
+      cursor = cursor + step > 16 ? cursor + step - 16 : 0;
+      cursor = std::min(cursor, array.size() - 1);
+      if (i % 3 == 2)
+        array.remove_at(cursor);
+      else
+        array.insert(static_cast<int>(i), cursor);
+    }
+  });
+  bench::do_not_optimize(array[0]);
+  std::snprintf(label, sizeof(label), "cursor insert/remove, %s", name);
+  bench::report(label, ns, edits);
+}
+
+void bench_gap_array(std::size_t size, std::size_t edits) {
+  bench_edits<Array<int>>("Array", size, edits);
+  bench_edits<GapArray<int>>("GapArray", size, edits);
+}
+
+// Measure inserting |inserted| items in the middle of an array of |size|
+// items, then removing them, one by one and as a range.
+template <typename ItemType>
+void bench_range(const char* name, std::size_t size, std::size_t inserted,
+                 ItemType (*make_item)(std::size_t)) {
+  Array<ItemType> items;
+  for (std::size_t i = 0; i < inserted; ++i)
+    items.append(make_item(i));
+  Array<ItemType> array;
+  for (std::size_t i = 0; i < size; ++i)
+    array.append(make_item(i));
+  std::size_t middle = size / 2;
+
+  double ns = bench::elapsed_ns([&] {
+    for (std::size_t i = 0; i < inserted; ++i)
+      array.insert(items[i], middle + i);
+  });
+  char label[64];
+  std::snprintf(label, sizeof(label), "insert loop, %s", name);
+  bench::report(label, ns, inserted);
+
+  ns = bench::elapsed_ns([&] {
+    for (std::size_t i = 0; i < inserted; ++i)
+      array.remove_at(middle);
+  });
+  std::snprintf(label, sizeof(label), "remove_at loop, %s", name);
+  bench::report(label, ns, inserted);
+
+  ns = bench::elapsed_ns(
+      [&] { array.insert_range(items.begin(), items.end(), middle); });
+  std::snprintf(label, sizeof(label), "insert_range, %s", name);
+  bench::report(label, ns, inserted);
+
+  ns = bench::elapsed_ns([&] { array.erase_range(middle, middle + inserted); });
+  bench::do_not_optimize(array[0]);
+  std::snprintf(label, sizeof(label), "erase_range, %s", name);
+  bench::report(label, ns, inserted);
+}
+
+void bench_ranges(std::size_t size, std::size_t inserted) {
+  bench_range<int>("int", size, inserted,
+                   [](std::size_t i) { return static_cast<int>(i); });
+  bench_range<std::string>("string", size / 10, inserted, [](std::size_t i) {
+    return "a string too long for small string optimization " +
+           std::to_string(i);
+  });
+}
+
+// A record of four fields, of which column kernels read one.
+struct Trade {
+  std::uint32_t id;
+  float price;
+  std::uint32_t quantity;
+  std::uint64_t timestamp;
+};
+
+// Return sum of quantities of at least |threshold|, read through |quantity|.
+template <typename Rows, typename Quantity>
+std::uint64_t sum_large(const Rows& rows, std::uint32_t threshold,
+                        Quantity quantity) {
+  std::uint64_t sum = 0;
+  for (const auto& row : rows) {
+    std::uint32_t value = quantity(row);
+    sum += value >= threshold ? value : 0;
+  }
+  return sum;
+}
+
+// Measure filtering and summing one field of |rows| records, |passes| times
+// over each layout: time per row.
+void bench_columns(std::size_t rows, std::size_t passes) {
+  constexpr std::uint32_t threshold = 50;
+  std::uint64_t sum = 0;
+  {
+    Array<Trade> trades;
+    for (std::size_t i = 0; i < rows; ++i) {
+      trades.append({static_cast<std::uint32_t>(i), 1.5f,
+                     static_cast<std::uint32_t>(i % 100), i});
+    }
+    double ns = bench::elapsed_ns([&] {
+      for (std::size_t pass = 0; pass < passes; ++pass) {
+        sum += sum_large(trades, threshold,
+                         [](const Trade& trade) { return trade.quantity; });
+        bench::do_not_optimize(sum);
+      }
+    });
+    bench::report("filter and sum column, Array<struct>", ns, rows * passes);
+  }
+  {
+    SoaArray<std::uint32_t, float, std::uint32_t, std::uint64_t> trades;
+    for (std::size_t i = 0; i < rows; ++i) {
+      trades.append(static_cast<std::uint32_t>(i), 1.5f,
+                    static_cast<std::uint32_t>(i % 100), i);
+    }
+    double ns = bench::elapsed_ns([&] {
+      for (std::size_t pass = 0; pass < passes; ++pass) {
+        sum += sum_large(trades.column<2>(), threshold,
+                         [](std::uint32_t quantity) { return quantity; });
+        bench::do_not_optimize(sum);
+      }
+    });
+    bench::report("filter and sum column, SoaArray", ns, rows * passes);
+  }
+}
+
+// Measure building, summing and destroying |iterations| arrays of |size|
+// integers: time and allocations per array.
+template <typename ArrayType>
+void bench_short_lived(const char* name, std::size_t size,
+                       std::size_t iterations) {
+  std::size_t allocations = allocation_count;
+  std::uint64_t sum = 0;
+  double ns = bench::elapsed_ns([&] {
+    for (std::size_t i = 0; i < iterations; ++i) {
+      ArrayType array;
+      for (std::size_t j = 0; j < size; ++j)
+        array.push_back(static_cast<int>(i + j));
+      for (int item : array)
+        sum += item;
+      bench::do_not_optimize(array);
+    }
+  });
+  bench::do_not_optimize(sum);
+  allocations = allocation_count - allocations;
+
+  char label[64];
+  std::snprintf(label, sizeof(label), "%zu items, %s", size, name);
+  bench::report(label, ns, iterations);
+  std::printf("%-48s %10.2f allocations/op\n", label,
+              static_cast<double>(allocations) / iterations);
+}
+
+// |Array| and |SmallArray| with the |push_back| of std::vector.
+template <typename ArrayType>
+struct PushBack : ArrayType {
+  void push_back(int item) { ArrayType::append(item); }
+};
+
+void bench_small_arrays(std::size_t iterations) {
+  for (std::size_t size : {0, 1, 4, 8, 16}) {
+    bench_short_lived<PushBack<Array<int>>>("Array", size, iterations);
+    bench_short_lived<PushBack<SmallArray<int, 8>>>("SmallArray<8>", size,
+                                                    iterations);
+    bench_short_lived<std::vector<int>>("std::vector", size, iterations);
+  }
+}
+
+}  // namespace
+
+// Usage: array_bench [item count]
+int main(int argc, char** argv) {
+  std::size_t count =
+      argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100000000;
+
+  bench_append(count);
+  bench_growth_policies(count);
+  bench_push_pop_cycles(count);
+  bench_access(count);
+  bench_find_remove(count / 2);
+  bench_small_arrays(count / 10);
+  bench_columns(count / 2, 5);
+  bench_gap_array(count / 100, 10000);
+  bench_ranges(count / 100, 10000);
+  return 0;
+}
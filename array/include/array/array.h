@@ -1,56 +1,134 @@
 #pragma once
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "array/growth_policy.h"
+#include "array/simd.h"
+#include "utils/allocator.h"
 #include "utils/utils.h"
 
 namespace td {
 
 constexpr int min_capacity = 16;
-// https://stackoverflow.com/questions/1100311/what-is-the-ideal-growth-rate-for-a-dynamically-allocated-array
-constexpr int growth_factor = 2;
-constexpr int shrink_factor = 4;
 
-template <typename ItemType>
+template <typename ItemType,
+          typename Allocator = MallocAllocator<ItemType>,
+          typename GrowthPolicy = array::DoublingGrowth>
 class Array;
 
-template <typename ItemType>
-void swap(Array<ItemType>& lhs, Array<ItemType>& rhs);
-
-// A dynamic array template
-template <typename ItemType>
+template <typename ItemType, typename Allocator, typename GrowthPolicy>
+void swap(Array<ItemType, Allocator, GrowthPolicy>& lhs,
+          Array<ItemType, Allocator, GrowthPolicy>& rhs);
+
+// A dynamic array template. Items live in raw storage and are constructed
+// only when added, so growth moves items instead of default-constructing new
+// slots and copying into them. Storage of trivially copyable items is grown
+// with |realloc|, which may extend it in place.
+//
+// Storage comes from |Allocator|, a standard allocator. Only the default
+// |MallocAllocator| allows |realloc|, any other one gets new storage on
+// growth. The allocator is copied, moved and swapped along with items.
+//
+// |GrowthPolicy| decides capacity when array is full, see growth_policy.h.
+// Storage never shrinks on its own, so items can be removed and added
+// again without reallocation; |shrink_to_fit| returns unused storage.
+template <typename ItemType, typename Allocator, typename GrowthPolicy>
 class Array {
+  static_assert(alignof(ItemType) <= alignof(std::max_align_t),
+                "over-aligned items are not supported");
+
  public:
+  // Items are contiguous, so pointers serve as random access iterators.
+  using iterator = ItemType*;
+  using const_iterator = const ItemType*;
+
   Array();
-  Array(std::size_t capacity);
+  explicit Array(const Allocator& allocator);
+  Array(std::size_t capacity, const Allocator& allocator = Allocator());
   Array(std::initializer_list<ItemType>&& il);
 
-  Array(const Array<ItemType>& other);
-  Array(Array<ItemType>&& other);
+  Array(const Array<ItemType, Allocator, GrowthPolicy>& other);
+  Array(Array<ItemType, Allocator, GrowthPolicy>&& other) noexcept;
 
-  Array<ItemType>& operator=(const Array<ItemType>& other);
-  Array<ItemType>& operator=(Array<ItemType>&& other);
+  Array<ItemType, Allocator, GrowthPolicy>& operator=(
+      const Array<ItemType, Allocator, GrowthPolicy>& other);
+  Array<ItemType, Allocator, GrowthPolicy>& operator=(
+      Array<ItemType, Allocator, GrowthPolicy>&& other) noexcept;
 
+  // Return item at |index|. |index| isn't checked, it must be less than
+  // |size()|.
   ItemType& operator[](std::size_t index);
+  const ItemType& operator[](std::size_t index) const;
 
   ~Array();
 
+  // Return item at |index|. Throw std::out_of_range if |index| isn't less
+  // than |size()|.
+  ItemType& at(std::size_t index);
+  const ItemType& at(std::size_t index) const;
+
+  // Return pointer to first item. Items are stored contiguously.
+  ItemType* data();
+  const ItemType* data() const;
+
+  // Return iterators to first item and past last item. They are invalidated
+  // when array grows or shrinks.
+  iterator begin();
+  iterator end();
+  const_iterator begin() const;
+  const_iterator end() const;
+
   // Return number of items are currently stored in array.
-  std::size_t size();
+  std::size_t size() const;
 
   // Return number of items array can hold.
-  std::size_t capacity();
+  std::size_t capacity() const;
+
+  // Make room for at least |capacity| items, so adding up to that many
+  // items doesn't reallocate.
+  void reserve(std::size_t capacity);
+
+  // Reduce capacity to size of array.
+  void shrink_to_fit();
+
+  // Change size of array to |size|, removing items from the end or adding
+  // value-initialized items or copies of |item|.
+  void resize(std::size_t size);
+  void resize(std::size_t size, const ItemType& item);
 
   // Return array is empty or not.
-  bool is_empty();
+  bool is_empty() const;
 
-  // Return item at |index|.
-  ItemType item_at(std::size_t index);
+  // Return copy of item at |index|. Throw std::out_of_range if |index| isn't
+  // less than |size()|.
+  ItemType item_at(std::size_t index) const;
 
   // Append |item| to the end of array.
   void append(const ItemType& item);
+  void append(ItemType&& item);
+
+  // Append items in [first, last), forward iterators which don't point into
+  // this array. Storage grows at most once.
+  template <typename Iterator>
+  void append_range(Iterator first, Iterator last);
 
   // Insert |item| at |index|.
   void insert(const ItemType& item, std::size_t index);
 
+  // Insert items in [first, last) at |index|, like |append_range|. Items
+  // after |index| are shifted in one pass.
+  template <typename Iterator>
+  void insert_range(Iterator first, Iterator last, std::size_t index);
+
   // Prepend |item| to the array.
   void prepend(const ItemType& item);
 
@@ -60,28 +138,78 @@ class Array {
   // Remove item at |index|
   void remove_at(std::size_t index);
 
-  // Look for |item|, remove indexs holding it.
-  void remove(const ItemType& item);
+  // Remove items at indexes in [first, last). Items after them are shifted
+  // in one pass.
+  void erase_range(std::size_t first, std::size_t last);
+
+  // Look for |item|, remove indexs holding it. Return number of removed
+  // items.
+  std::size_t remove(const ItemType& item);
+
+  // Remove items for which |predicate| returns true, keeping order of the
+  // rest. Each kept item is moved at most once. Return number of removed
+  // items.
+  template <typename Predicate>
+  std::size_t remove_if(Predicate predicate);
 
   // Look for |item|, return first index with this
   // value, returns |kIndexNotFound| if not found
-  std::size_t find(const ItemType& item);
+  std::size_t find(const ItemType& item) const;
+
+  // Return number of items equal to |item|.
+  std::size_t count(const ItemType& item) const;
+
+  // Return true if some item is equal to |item|.
+  bool contains(const ItemType& item) const;
 
   // Swap values inside |lhs| and |rhs|.
   // Follow copy-and-swap idiom
   // https://stackoverflow.com/questions/3279543/what-is-the-copy-and-swap-idiom
-  friend void swap<ItemType>(Array<ItemType>& lhs, Array<ItemType>& rhs);
+  friend void swap<ItemType, Allocator, GrowthPolicy>(
+      Array<ItemType, Allocator, GrowthPolicy>& lhs,
+      Array<ItemType, Allocator, GrowthPolicy>& rhs);
 
  private:
-  // If |new_size| is equal or greater than |capacity_|, allocate
-  // new array with double capacity. If |new_size| is equal or less
-  // than |capacity_| / 4, allocate new array with half of capacity.
-  void reallocate_if_needed(std::size_t new_size);
+  using AllocatorTraits = std::allocator_traits<Allocator>;
+
+  // True if storage can be grown by |realloc|.
+  static constexpr bool is_reallocatable =
+      std::is_trivially_copyable<ItemType>::value &&
+      std::is_same<Allocator, MallocAllocator<ItemType>>::value;
+
+  // True if storage for |capacity| items is mapped pages, see
+  // |GrowthPolicy|.
+  static bool maps_pages(std::size_t capacity);
+
+  // If |new_size| is greater than |capacity_|, allocate new storage with
+  // capacity given by |GrowthPolicy|.
+  void grow_if_needed(std::size_t new_size);
+
+  // Remove items from |first| on for which |predicate| returns true.
+  template <typename Predicate>
+  std::size_t remove_from(std::size_t first, Predicate& predicate);
+
+  // Move items to new storage for |new_capacity| items, which is at least
+  // |size_|. If moving an item may throw, items are copied instead, so
+  // array is left unchanged on failure.
+  void reallocate(std::size_t new_capacity);
 
   // Deep copy |items_| from |array|
-  void deep_copy(const Array<ItemType>& array);
+  void deep_copy(const Array<ItemType, Allocator, GrowthPolicy>& array);
+
+  // Return raw storage for |capacity| items, none of them constructed.
+  ItemType* allocate(std::size_t capacity);
+
+  // Free |items|, storage for |capacity| items.
+  void deallocate(ItemType* items, std::size_t capacity);
+
+  // Destroy items in [first, last).
+  static void destroy(ItemType* first, ItemType* last);
+
+  Allocator allocator_;
 
-  // Raw array where items are stored.
+  // Raw storage where items are stored. Only first |size_| items are
+  // constructed.
   ItemType* items_{nullptr};
 
   // Number of items are currently stored in array.
@@ -96,148 +224,367 @@ class Array {
 /****************  Array implementation ****************/
 namespace td {
 
-template <typename ItemType>
-void swap(Array<ItemType>& lhs, Array<ItemType>& rhs) {
+template <typename ItemType, typename Allocator, typename GrowthPolicy>
+void swap(Array<ItemType, Allocator, GrowthPolicy>& lhs,
+          Array<ItemType, Allocator, GrowthPolicy>& rhs) {
   using std::swap;
 
+  swap(lhs.allocator_, rhs.allocator_);
   swap(lhs.size_, rhs.size_);
   swap(lhs.capacity_, rhs.capacity_);
   swap(lhs.items_, rhs.items_);
 }
 
 // Public
-template <typename ItemType>
-Array<ItemType>::Array() : Array(min_capacity) {}
-
-template <typename ItemType>
-Array<ItemType>::Array(std::size_t capacity) : capacity_(capacity) {
-  items_ = new ItemType[capacity_];
+template <typename ItemType, typename Allocator, typename GrowthPolicy>
+Array<ItemType, Allocator, GrowthPolicy>::Array() : Array(min_capacity) {}
+
+template <typename ItemType, typename Allocator, typename GrowthPolicy>
+Array<ItemType, Allocator, GrowthPolicy>::Array(const Allocator& allocator)
+    : Array(min_capacity, allocator) {}
+
+template <typename ItemType, typename Allocator, typename GrowthPolicy>
+Array<ItemType, Allocator, GrowthPolicy>::Array(
+    std::size_t capacity,
+    const Allocator& allocator)
+    : allocator_(allocator), capacity_(capacity) {
+  items_ = allocate(capacity_);
 }
 
-template <typename ItemType>
-Array<ItemType>::Array(std::initializer_list<ItemType>&& il) : Array() {
-  for (const ItemType& data : il) {
-    append(data);
-  }
+template <typename ItemType, typename Allocator, typename GrowthPolicy>
+Array<ItemType, Allocator, GrowthPolicy>::Array(
+    std::initializer_list<ItemType>&& il)
+    : Array() {
+  append_range(il.begin(), il.end());
 }
 
-template <typename ItemType>
-Array<ItemType>::Array(const Array<ItemType>& other) {
+template <typename ItemType, typename Allocator, typename GrowthPolicy>
+Array<ItemType, Allocator, GrowthPolicy>::Array(
+    const Array<ItemType, Allocator, GrowthPolicy>& other)
+    : allocator_(AllocatorTraits::select_on_container_copy_construction(
+          other.allocator_)) {
   deep_copy(other);
 }
 
-template <typename ItemType>
-Array<ItemType>::Array(Array<ItemType>&& other)
-    : items_(other.items_), size_(other.size_), capacity_(other.capacity_) {
+template <typename ItemType, typename Allocator, typename GrowthPolicy>
+Array<ItemType, Allocator, GrowthPolicy>::Array(
+    Array<ItemType, Allocator, GrowthPolicy>&& other) noexcept
+    : allocator_(std::move(other.allocator_)),
+      items_(other.items_),
+      size_(other.size_),
+      capacity_(other.capacity_) {
   other.items_ = nullptr;
+  other.size_ = 0;
+  other.capacity_ = 0;
 }
 
-template <typename ItemType>
-Array<ItemType>& Array<ItemType>::operator=(const Array<ItemType>& other) {
-  Array<ItemType> temp_array(other);
+template <typename ItemType, typename Allocator, typename GrowthPolicy>
+Array<ItemType, Allocator, GrowthPolicy>&
+Array<ItemType, Allocator, GrowthPolicy>::operator=(
+    const Array<ItemType, Allocator, GrowthPolicy>& other) {
+  Array<ItemType, Allocator, GrowthPolicy> temp_array(other);
   swap(*this, temp_array);
   return *this;
 }
 
-template <typename ItemType>
-Array<ItemType>& Array<ItemType>::operator=(Array<ItemType>&& other) {
+template <typename ItemType, typename Allocator, typename GrowthPolicy>
+Array<ItemType, Allocator, GrowthPolicy>&
+Array<ItemType, Allocator, GrowthPolicy>::operator=(
+    Array<ItemType, Allocator, GrowthPolicy>&& other) noexcept {
   // Maybe shouldn't use |swap| method for move assignment operator
   // https://stackoverflow.com/questions/6687388/why-do-some-people-use-swap-for-move-assignments
-  Array<ItemType> temp_array = std::move(other);
+  Array<ItemType, Allocator, GrowthPolicy> temp_array = std::move(other);
   swap(*this, temp_array);
   return *this;
 }
 
-template <typename ItemType>
-ItemType& Array<ItemType>::operator[](std::size_t index) {
+template <typename ItemType, typename Allocator, typename GrowthPolicy>
+ItemType& Array<ItemType, Allocator, GrowthPolicy>::operator[](
+    std::size_t index) {
+  return items_[index];
+}
+
+template <typename ItemType, typename Allocator, typename GrowthPolicy>
+const ItemType& Array<ItemType, Allocator, GrowthPolicy>::operator[](
+    std::size_t index) const {
+  return items_[index];
+}
+
+template <typename ItemType, typename Allocator, typename GrowthPolicy>
+Array<ItemType, Allocator, GrowthPolicy>::~Array() {
+  destroy(items_, items_ + size_);
+  deallocate(items_, capacity_);
+}
+
+template <typename ItemType, typename Allocator, typename GrowthPolicy>
+ItemType& Array<ItemType, Allocator, GrowthPolicy>::at(std::size_t index) {
+  utils::validate(index, size_, utils::Action::kNone);
+  return items_[index];
+}
+
+template <typename ItemType, typename Allocator, typename GrowthPolicy>
+const ItemType& Array<ItemType, Allocator, GrowthPolicy>::at(
+    std::size_t index) const {
   utils::validate(index, size_, utils::Action::kNone);
   return items_[index];
 }
 
-template <typename ItemType>
-Array<ItemType>::~Array() {
-  delete[] items_;
+template <typename ItemType, typename Allocator, typename GrowthPolicy>
+ItemType* Array<ItemType, Allocator, GrowthPolicy>::data() {
+  return items_;
 }
 
-template <typename ItemType>
-std::size_t Array<ItemType>::size() {
+template <typename ItemType, typename Allocator, typename GrowthPolicy>
+const ItemType* Array<ItemType, Allocator, GrowthPolicy>::data() const {
+  return items_;
+}
+
+template <typename ItemType, typename Allocator, typename GrowthPolicy>
+typename Array<ItemType, Allocator, GrowthPolicy>::iterator
+Array<ItemType, Allocator, GrowthPolicy>::begin() {
+  return items_;
+}
+
+template <typename ItemType, typename Allocator, typename GrowthPolicy>
+typename Array<ItemType, Allocator, GrowthPolicy>::iterator
+Array<ItemType, Allocator, GrowthPolicy>::end() {
+  return items_ + size_;
+}
+
+template <typename ItemType, typename Allocator, typename GrowthPolicy>
+typename Array<ItemType, Allocator, GrowthPolicy>::const_iterator
+Array<ItemType, Allocator, GrowthPolicy>::begin() const {
+  return items_;
+}
+
+template <typename ItemType, typename Allocator, typename GrowthPolicy>
+typename Array<ItemType, Allocator, GrowthPolicy>::const_iterator
+Array<ItemType, Allocator, GrowthPolicy>::end() const {
+  return items_ + size_;
+}
+
+template <typename ItemType, typename Allocator, typename GrowthPolicy>
+std::size_t Array<ItemType, Allocator, GrowthPolicy>::size() const {
   return size_;
 }
 
-template <typename ItemType>
-std::size_t Array<ItemType>::capacity() {
+template <typename ItemType, typename Allocator, typename GrowthPolicy>
+std::size_t Array<ItemType, Allocator, GrowthPolicy>::capacity() const {
   return capacity_;
 }
 
-template <typename ItemType>
-bool Array<ItemType>::is_empty() {
+template <typename ItemType, typename Allocator, typename GrowthPolicy>
+void Array<ItemType, Allocator, GrowthPolicy>::reserve(std::size_t capacity) {
+  if (capacity > capacity_) {
+    reallocate(capacity);
+  }
+}
+
+template <typename ItemType, typename Allocator, typename GrowthPolicy>
+void Array<ItemType, Allocator, GrowthPolicy>::shrink_to_fit() {
+  if (size_ < capacity_) {
+    reallocate(size_);
+  }
+}
+
+template <typename ItemType, typename Allocator, typename GrowthPolicy>
+void Array<ItemType, Allocator, GrowthPolicy>::resize(std::size_t size) {
+  if (size <= size_) {
+    erase_range(size, size_);
+    return;
+  }
+
+  grow_if_needed(size);
+  std::uninitialized_value_construct(items_ + size_, items_ + size);
+  size_ = size;
+}
+
+template <typename ItemType, typename Allocator, typename GrowthPolicy>
+void Array<ItemType, Allocator, GrowthPolicy>::resize(std::size_t size,
+                                                      const ItemType& item) {
+  if (size <= size_) {
+    erase_range(size, size_);
+    return;
+  }
+
+  // |item| may be stored in this array, copy it before storage moves.
+  ItemType value(item);
+  grow_if_needed(size);
+  std::uninitialized_fill(items_ + size_, items_ + size, value);
+  size_ = size;
+}
+
+template <typename ItemType, typename Allocator, typename GrowthPolicy>
+bool Array<ItemType, Allocator, GrowthPolicy>::is_empty() const {
   return size_ == 0;
 }
 
-template <typename ItemType>
-ItemType Array<ItemType>::item_at(std::size_t index) {
-  utils::validate(index, size_, utils::Action::kNone);
-  return items_[index];
+template <typename ItemType, typename Allocator, typename GrowthPolicy>
+ItemType Array<ItemType, Allocator, GrowthPolicy>::item_at(
+    std::size_t index) const {
+  return at(index);
 }
 
-template <typename ItemType>
-void Array<ItemType>::append(const ItemType& item) {
-  reallocate_if_needed(size_ + 1);
-  items_[size_++] = item;
+template <typename ItemType, typename Allocator, typename GrowthPolicy>
+void Array<ItemType, Allocator, GrowthPolicy>::append(const ItemType& item) {
+  if (size_ == capacity_) {
+    // |item| may be stored in this array, copy it before storage moves.
+    append(ItemType(item));
+    return;
+  }
+
+  new (items_ + size_) ItemType(item);
+  ++size_;
 }
 
-template <typename ItemType>
-void Array<ItemType>::insert(const ItemType& item, std::size_t index) {
+template <typename ItemType, typename Allocator, typename GrowthPolicy>
+void Array<ItemType, Allocator, GrowthPolicy>::append(ItemType&& item) {
+  if (size_ == capacity_) {
+    ItemType value(std::move(item));
+    grow_if_needed(size_ + 1);
+    new (items_ + size_) ItemType(std::move(value));
+  } else {
+    new (items_ + size_) ItemType(std::move(item));
+  }
+  ++size_;
+}
+
+template <typename ItemType, typename Allocator, typename GrowthPolicy>
+template <typename Iterator>
+void Array<ItemType, Allocator, GrowthPolicy>::append_range(Iterator first,
+                                                            Iterator last) {
+  insert_range(first, last, size_);
+}
+
+template <typename ItemType, typename Allocator, typename GrowthPolicy>
+void Array<ItemType, Allocator, GrowthPolicy>::insert(
+    const ItemType& item,
+    std::size_t index) {
   utils::validate(index, size_, utils::Action::kInsert);
-  reallocate_if_needed(++size_);
+  if (index == size_) {
+    append(item);
+    return;
+  }
+
+  // |item| may be stored in this array, copy it before items shift.
+  ItemType value(item);
+  grow_if_needed(size_ + 1);
 
+  new (items_ + size_) ItemType(std::move(items_[size_ - 1]));
   for (std::size_t i = size_ - 1; i > index; --i) {
-    items_[i] = items_[i - 1];
+    items_[i] = std::move(items_[i - 1]);
   }
+  ++size_;
 
-  items_[index] = item;
+  items_[index] = std::move(value);
 }
 
-template <typename ItemType>
-void Array<ItemType>::prepend(const ItemType& item) {
+template <typename ItemType, typename Allocator, typename GrowthPolicy>
+template <typename Iterator>
+void Array<ItemType, Allocator, GrowthPolicy>::insert_range(Iterator first,
+                                                            Iterator last,
+                                                            std::size_t index) {
+  static_assert(
+      std::is_base_of<
+          std::forward_iterator_tag,
+          typename std::iterator_traits<Iterator>::iterator_category>::value,
+      "insert_range needs forward iterators");
+  utils::validate(index, size_, utils::Action::kInsert);
+
+  std::size_t count = std::distance(first, last);
+  if (count == 0) {
+    return;
+  }
+  grow_if_needed(size_ + count);
+
+  if constexpr (std::is_trivially_copyable<ItemType>::value) {
+    std::memmove(static_cast<void*>(items_ + index + count), items_ + index,
+                 (size_ - index) * sizeof(ItemType));
+    std::copy(first, last, items_ + index);
+    size_ += count;
+  } else {
+    // New items are constructed past the end, then rotated into place, so
+    // tail is shifted in one pass and no slot is left unconstructed if a
+    // copy throws.
+    std::uninitialized_copy(first, last, items_ + size_);
+    size_ += count;
+    std::rotate(items_ + index, items_ + size_ - count, items_ + size_);
+  }
+}
+
+template <typename ItemType, typename Allocator, typename GrowthPolicy>
+void Array<ItemType, Allocator, GrowthPolicy>::prepend(const ItemType& item) {
   insert(item, 0);
 }
 
-template <typename ItemType>
-ItemType Array<ItemType>::pop() {
+template <typename ItemType, typename Allocator, typename GrowthPolicy>
+ItemType Array<ItemType, Allocator, GrowthPolicy>::pop() {
   std::size_t last_index = size_ - 1;
   utils::validate(last_index, size_, utils::Action::kRemove);
 
-  ItemType& last_item = items_[last_index];
+  ItemType last_item = std::move(items_[last_index]);
+  destroy(items_ + last_index, items_ + size_);
 
-  reallocate_if_needed(--size_);
+  --size_;
   return last_item;
 }
 
-template <typename ItemType>
-void Array<ItemType>::remove_at(std::size_t index) {
+template <typename ItemType, typename Allocator, typename GrowthPolicy>
+void Array<ItemType, Allocator, GrowthPolicy>::remove_at(std::size_t index) {
   utils::validate(index, size_, utils::Action::kRemove);
 
   for (std::size_t i = index; i < size_ - 1; ++i) {
-    items_[i] = items_[i + 1];
+    items_[i] = std::move(items_[i + 1]);
   }
+  destroy(items_ + size_ - 1, items_ + size_);
 
-  reallocate_if_needed(--size_);
+  --size_;
 }
 
-template <typename ItemType>
-void Array<ItemType>::remove(const ItemType& item) {
-  for (std::size_t i = 0; i < size_; ++i) {
-    if (items_[i] != item) {
-      continue;
-    }
+template <typename ItemType, typename Allocator, typename GrowthPolicy>
+void Array<ItemType, Allocator, GrowthPolicy>::erase_range(std::size_t first,
+                                                           std::size_t last) {
+  utils::validate(last, size_, utils::Action::kInsert);
+  utils::validate(first, last, utils::Action::kInsert);
 
-    remove_at(i--);
+  std::size_t count = last - first;
+  if constexpr (std::is_trivially_copyable<ItemType>::value) {
+    std::memmove(static_cast<void*>(items_ + first), items_ + last,
+                 (size_ - last) * sizeof(ItemType));
+  } else {
+    std::move(items_ + last, items_ + size_, items_ + first);
+    destroy(items_ + size_ - count, items_ + size_);
   }
+  size_ -= count;
+}
+
+template <typename ItemType, typename Allocator, typename GrowthPolicy>
+std::size_t Array<ItemType, Allocator, GrowthPolicy>::remove(
+    const ItemType& item) {
+  std::size_t first = find(item);
+  if (first == index_not_found) {
+    return 0;
+  }
+
+  // |item| may be stored in this array, copy it before items move.
+  auto equal = [value = item](const ItemType& other) { return other == value; };
+  return remove_from(first, equal);
 }
 
-template <typename ItemType>
-std::size_t Array<ItemType>::find(const ItemType& item) {
+template <typename ItemType, typename Allocator, typename GrowthPolicy>
+template <typename Predicate>
+std::size_t Array<ItemType, Allocator, GrowthPolicy>::remove_if(
+    Predicate predicate) {
+  return remove_from(0, predicate);
+}
+
+template <typename ItemType, typename Allocator, typename GrowthPolicy>
+std::size_t Array<ItemType, Allocator, GrowthPolicy>::find(
+    const ItemType& item) const {
+  if constexpr (array::is_vectorizable<ItemType>) {
+    return array::find(items_, size_, item);
+  }
+
   for (std::size_t i = 0; i < size_; ++i) {
     if (item == items_[i]) {
       return i;
@@ -247,41 +594,181 @@ std::size_t Array<ItemType>::find(const ItemType& item) {
   return index_not_found;
 }
 
-template <typename ItemType>
-void Array<ItemType>::reallocate_if_needed(std::size_t new_size) {
-  std::size_t new_capacity = capacity_;
+template <typename ItemType, typename Allocator, typename GrowthPolicy>
+std::size_t Array<ItemType, Allocator, GrowthPolicy>::count(
+    const ItemType& item) const {
+  if constexpr (array::is_vectorizable<ItemType>) {
+    return array::count(items_, size_, item);
+  }
+
+  std::size_t result = 0;
+  for (std::size_t i = 0; i < size_; ++i) {
+    if (item == items_[i]) {
+      ++result;
+    }
+  }
 
+  return result;
+}
+
+template <typename ItemType, typename Allocator, typename GrowthPolicy>
+bool Array<ItemType, Allocator, GrowthPolicy>::contains(
+    const ItemType& item) const {
+  return find(item) != index_not_found;
+}
+
+// Private
+
+template <typename ItemType, typename Allocator, typename GrowthPolicy>
+bool Array<ItemType, Allocator, GrowthPolicy>::maps_pages(
+    std::size_t capacity) {
+  if constexpr (is_reallocatable) {
+    return GrowthPolicy::maps_pages(capacity, sizeof(ItemType));
+  }
+  return false;
+}
+
+template <typename ItemType, typename Allocator, typename GrowthPolicy>
+void Array<ItemType, Allocator, GrowthPolicy>::grow_if_needed(
+    std::size_t new_size) {
   if (new_size > capacity_) {
-    new_capacity *= growth_factor;
-  } else if (new_size <= capacity_ / shrink_factor &&
-             capacity_ / growth_factor >= min_capacity) {
-    new_capacity /= growth_factor;
-  } else {
-    return;
+    reallocate(GrowthPolicy::grow(capacity_, new_size, sizeof(ItemType)));
   }
+}
 
-  ItemType* new_items = new ItemType[new_capacity];
+template <typename ItemType, typename Allocator, typename GrowthPolicy>
+template <typename Predicate>
+std::size_t Array<ItemType, Allocator, GrowthPolicy>::remove_from(
+    std::size_t first,
+    Predicate& predicate) {
+  std::size_t kept = first;
+  for (std::size_t i = first; i < size_; ++i) {
+    if (predicate(items_[i])) {
+      continue;
+    }
 
-  for (std::size_t i = 0; i < size_; ++i) {
-    new_items[i] = items_[i];
+    if (kept != i) {
+      items_[kept] = std::move(items_[i]);
+    }
+    ++kept;
   }
 
-  delete[] items_;
+  std::size_t removed = size_ - kept;
+  destroy(items_ + kept, items_ + size_);
+  size_ = kept;
+
+  return removed;
+}
+
+template <typename ItemType, typename Allocator, typename GrowthPolicy>
+void Array<ItemType, Allocator, GrowthPolicy>::reallocate(
+    std::size_t new_capacity) {
+  // Storage is resized in place unless it moves between memory of
+  // |allocator_| and mapped pages.
+  if constexpr (is_reallocatable) {
+    bool mapped = maps_pages(capacity_);
+    if (new_capacity > 0 && mapped == maps_pages(new_capacity)) {
+      void* new_items =
+          mapped ? remap_pages(items_, capacity_ * sizeof(ItemType),
+                               new_capacity * sizeof(ItemType))
+                 : std::realloc(items_, new_capacity * sizeof(ItemType));
+      if (!new_items) {
+        throw std::bad_alloc();
+      }
+
+      items_ = static_cast<ItemType*>(new_items);
+      capacity_ = new_capacity;
+      return;
+    }
+  }
+
+  ItemType* new_items = allocate(new_capacity);
+  if constexpr (std::is_trivially_copyable<ItemType>::value) {
+    if (size_ > 0) {
+      std::memcpy(static_cast<void*>(new_items), items_,
+                  size_ * sizeof(ItemType));
+    }
+  } else {
+    std::size_t constructed = 0;
+    try {
+      for (; constructed < size_; ++constructed) {
+        new (new_items + constructed)
+            ItemType(std::move_if_noexcept(items_[constructed]));
+      }
+    } catch (...) {
+      destroy(new_items, new_items + constructed);
+      deallocate(new_items, new_capacity);
+      throw;
+    }
+  }
+
+  destroy(items_, items_ + size_);
+  deallocate(items_, capacity_);
   items_ = new_items;
 
   capacity_ = new_capacity;
 }
 
-template <typename ItemType>
-void Array<ItemType>::deep_copy(const Array<ItemType>& array) {
-  size_ = array.size_;
+template <typename ItemType, typename Allocator, typename GrowthPolicy>
+void Array<ItemType, Allocator, GrowthPolicy>::deep_copy(
+    const Array<ItemType, Allocator, GrowthPolicy>& array) {
+  items_ = allocate(array.capacity_);
   capacity_ = array.capacity_;
 
-  delete[] items_;
+  if constexpr (std::is_trivially_copyable<ItemType>::value) {
+    if (array.size_ > 0) {
+      std::memcpy(static_cast<void*>(items_), array.items_,
+                  array.size_ * sizeof(ItemType));
+    }
+  } else {
+    try {
+      std::uninitialized_copy(array.items_, array.items_ + array.size_,
+                              items_);
+    } catch (...) {
+      deallocate(items_, capacity_);
+      items_ = nullptr;
+      capacity_ = 0;
+      throw;
+    }
+  }
+
+  size_ = array.size_;
+}
 
-  items_ = new ItemType[capacity_];
-  for (std::size_t i = 0; i < size_; ++i) {
-    items_[i] = array.items_[i];
+template <typename ItemType, typename Allocator, typename GrowthPolicy>
+ItemType* Array<ItemType, Allocator, GrowthPolicy>::allocate(
+    std::size_t capacity) {
+  if (capacity == 0) {
+    return nullptr;
+  }
+  if (maps_pages(capacity)) {
+    return static_cast<ItemType*>(map_pages(capacity * sizeof(ItemType)));
+  }
+  return AllocatorTraits::allocate(allocator_, capacity);
+}
+
+template <typename ItemType, typename Allocator, typename GrowthPolicy>
+void Array<ItemType, Allocator, GrowthPolicy>::deallocate(
+    ItemType* items,
+    std::size_t capacity) {
+  if (!items) {
+    return;
+  }
+
+  if (maps_pages(capacity)) {
+    unmap_pages(items, capacity * sizeof(ItemType));
+  } else {
+    AllocatorTraits::deallocate(allocator_, items, capacity);
+  }
+}
+
+template <typename ItemType, typename Allocator, typename GrowthPolicy>
+void Array<ItemType, Allocator, GrowthPolicy>::destroy(ItemType* first,
+                                                       ItemType* last) {
+  if constexpr (!std::is_trivially_destructible<ItemType>::value) {
+    for (; first != last; ++first) {
+      first->~ItemType();
+    }
   }
 }
 
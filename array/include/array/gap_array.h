@@ -0,0 +1,478 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "array/array.h"
+#include "array/growth_policy.h"
+#include "utils/utils.h"
+
+namespace td {
+
+// A dynamic array for edits near a moving cursor, stored as a gap buffer:
+// free slots form one gap inside storage, with items before it packed at the
+// start and items after it packed at the end. Inserting or removing at
+// |index| first moves the gap there, which moves only items between the old
+// and new position of the gap. A run of edits near one position costs O(1)
+// each, an edit far from the previous one costs O(distance), while
+// |Array::insert| always shifts every item after |index|.
+//
+// Indexed access costs one comparison more than in |Array|. Items aren't
+// contiguous, so there's no |data()|. Storage grows by |GrowthPolicy| and
+// never shrinks on its own.
+template <typename ItemType, typename GrowthPolicy = array::DoublingGrowth>
+class GapArray {
+  static_assert(alignof(ItemType) <= alignof(std::max_align_t),
+                "over-aligned items are not supported");
+
+ public:
+  GapArray();
+  explicit GapArray(std::size_t capacity);
+  GapArray(std::initializer_list<ItemType>&& il);
+
+  GapArray(const GapArray& other);
+  GapArray(GapArray&& other) noexcept;
+
+  GapArray& operator=(const GapArray& other);
+  GapArray& operator=(GapArray&& other) noexcept;
+
+  // Return item at |index|. |index| isn't checked, it must be less than
+  // |size()|.
+  ItemType& operator[](std::size_t index);
+  const ItemType& operator[](std::size_t index) const;
+
+  ~GapArray();
+
+  // Return item at |index|. Throw std::out_of_range if |index| isn't less
+  // than |size()|.
+  ItemType& at(std::size_t index);
+  const ItemType& at(std::size_t index) const;
+
+  // Return number of items are currently stored in array.
+  std::size_t size() const;
+
+  // Return number of items array can hold.
+  std::size_t capacity() const;
+
+  // Return array is empty or not.
+  bool is_empty() const;
+
+  // Return copy of item at |index|. Throw std::out_of_range if |index| isn't
+  // less than |size()|.
+  ItemType item_at(std::size_t index) const;
+
+  // Make room for at least |capacity| items.
+  void reserve(std::size_t capacity);
+
+  // Reduce capacity to size of array.
+  void shrink_to_fit();
+
+  // Append |item| to the end of array.
+  void append(const ItemType& item);
+  void append(ItemType&& item);
+
+  // Insert |item| at |index|.
+  void insert(const ItemType& item, std::size_t index);
+  void insert(ItemType&& item, std::size_t index);
+
+  // Prepend |item| to the array.
+  void prepend(const ItemType& item);
+
+  // Remove last item and return it.
+  ItemType pop();
+
+  // Remove item at |index|.
+  void remove_at(std::size_t index);
+
+ private:
+  // Return number of free slots.
+  std::size_t gap_size() const;
+
+  // Move gap so that it starts at item |index|, moving items between old
+  // and new position across it.
+  void move_gap(std::size_t index);
+
+  // If |new_size| is greater than |capacity_|, move items to new storage
+  // with capacity given by |GrowthPolicy|.
+  void grow_if_needed(std::size_t new_size);
+
+  // Move items to new storage for |new_capacity| items, which is at least
+  // size of array, keeping position of the gap. If moving an item may
+  // throw, items are copied instead, so array is left unchanged on failure.
+  void reallocate(std::size_t new_capacity);
+
+  // Destroy all items and free storage, leaving array empty.
+  void reset();
+
+  // Return raw storage for |capacity| items.
+  static ItemType* allocate(std::size_t capacity);
+
+  // Construct items at |destination| from items in [first, last), moved if
+  // that can't throw. If it throws, constructed items are destroyed.
+  static void move_construct(ItemType* first,
+                             ItemType* last,
+                             ItemType* destination);
+
+  // Destroy items in [first, last).
+  static void destroy(ItemType* first, ItemType* last);
+
+  // Raw storage. Items are in [0, |gap_begin_|) and
+  // [|gap_end_|, |capacity_|), slots of the gap aren't constructed.
+  ItemType* items_{nullptr};
+
+  std::size_t gap_begin_{0};
+  std::size_t gap_end_{0};
+
+  // Represent how many total items array can store without reallocation.
+  std::size_t capacity_{0};
+};
+
+}  // namespace td
+
+/****************  Gap array implementation ****************/
+namespace td {
+
+// Public
+
+template <typename ItemType, typename GrowthPolicy>
+GapArray<ItemType, GrowthPolicy>::GapArray() : GapArray(min_capacity) {}
+
+template <typename ItemType, typename GrowthPolicy>
+GapArray<ItemType, GrowthPolicy>::GapArray(std::size_t capacity)
+    : items_(allocate(capacity)), gap_end_(capacity), capacity_(capacity) {}
+
+template <typename ItemType, typename GrowthPolicy>
+GapArray<ItemType, GrowthPolicy>::GapArray(
+    std::initializer_list<ItemType>&& il)
+    : GapArray(std::max<std::size_t>(il.size(), min_capacity)) {
+  for (const ItemType& data : il) {
+    append(data);
+  }
+}
+
+template <typename ItemType, typename GrowthPolicy>
+GapArray<ItemType, GrowthPolicy>::GapArray(const GapArray& other)
+    : items_(allocate(other.capacity_)) {
+  try {
+    std::uninitialized_copy(other.items_, other.items_ + other.gap_begin_,
+                            items_);
+    try {
+      std::uninitialized_copy(other.items_ + other.gap_end_,
+                              other.items_ + other.capacity_,
+                              items_ + other.gap_end_);
+    } catch (...) {
+      destroy(items_, items_ + other.gap_begin_);
+      throw;
+    }
+  } catch (...) {
+    std::free(items_);
+    throw;
+  }
+
+  gap_begin_ = other.gap_begin_;
+  gap_end_ = other.gap_end_;
+  capacity_ = other.capacity_;
+}
+
+template <typename ItemType, typename GrowthPolicy>
+GapArray<ItemType, GrowthPolicy>::GapArray(GapArray&& other) noexcept
+    : items_(other.items_),
+      gap_begin_(other.gap_begin_),
+      gap_end_(other.gap_end_),
+      capacity_(other.capacity_) {
+  other.items_ = nullptr;
+  other.gap_begin_ = 0;
+  other.gap_end_ = 0;
+  other.capacity_ = 0;
+}
+
+template <typename ItemType, typename GrowthPolicy>
+GapArray<ItemType, GrowthPolicy>& GapArray<ItemType, GrowthPolicy>::operator=(
+    const GapArray& other) {
+  if (this != &other) {
+    *this = GapArray(other);
+  }
+  return *this;
+}
+
+template <typename ItemType, typename GrowthPolicy>
+GapArray<ItemType, GrowthPolicy>& GapArray<ItemType, GrowthPolicy>::operator=(
+    GapArray&& other) noexcept {
+  if (this != &other) {
+    reset();
+    std::swap(items_, other.items_);
+    std::swap(gap_begin_, other.gap_begin_);
+    std::swap(gap_end_, other.gap_end_);
+    std::swap(capacity_, other.capacity_);
+  }
+  return *this;
+}
+
+template <typename ItemType, typename GrowthPolicy>
+ItemType& GapArray<ItemType, GrowthPolicy>::operator[](std::size_t index) {
+  return items_[index < gap_begin_ ? index : index + gap_size()];
+}
+
+template <typename ItemType, typename GrowthPolicy>
+const ItemType& GapArray<ItemType, GrowthPolicy>::operator[](
+    std::size_t index) const {
+  return items_[index < gap_begin_ ? index : index + gap_size()];
+}
+
+template <typename ItemType, typename GrowthPolicy>
+GapArray<ItemType, GrowthPolicy>::~GapArray() {
+  reset();
+}
+
+template <typename ItemType, typename GrowthPolicy>
+ItemType& GapArray<ItemType, GrowthPolicy>::at(std::size_t index) {
+  utils::validate(index, size(), utils::Action::kNone);
+  return (*this)[index];
+}
+
+template <typename ItemType, typename GrowthPolicy>
+const ItemType& GapArray<ItemType, GrowthPolicy>::at(
+    std::size_t index) const {
+  utils::validate(index, size(), utils::Action::kNone);
+  return (*this)[index];
+}
+
+template <typename ItemType, typename GrowthPolicy>
+std::size_t GapArray<ItemType, GrowthPolicy>::size() const {
+  return capacity_ - gap_size();
+}
+
+template <typename ItemType, typename GrowthPolicy>
+std::size_t GapArray<ItemType, GrowthPolicy>::capacity() const {
+  return capacity_;
+}
+
+template <typename ItemType, typename GrowthPolicy>
+bool GapArray<ItemType, GrowthPolicy>::is_empty() const {
+  return size() == 0;
+}
+
+template <typename ItemType, typename GrowthPolicy>
+ItemType GapArray<ItemType, GrowthPolicy>::item_at(std::size_t index) const {
+  return at(index);
+}
+
+template <typename ItemType, typename GrowthPolicy>
+void GapArray<ItemType, GrowthPolicy>::reserve(std::size_t capacity) {
+  if (capacity > capacity_) {
+    reallocate(capacity);
+  }
+}
+
+template <typename ItemType, typename GrowthPolicy>
+void GapArray<ItemType, GrowthPolicy>::shrink_to_fit() {
+  if (size() < capacity_) {
+    reallocate(size());
+  }
+}
+
+template <typename ItemType, typename GrowthPolicy>
+void GapArray<ItemType, GrowthPolicy>::append(const ItemType& item) {
+  insert(item, size());
+}
+
+template <typename ItemType, typename GrowthPolicy>
+void GapArray<ItemType, GrowthPolicy>::append(ItemType&& item) {
+  insert(std::move(item), size());
+}
+
+template <typename ItemType, typename GrowthPolicy>
+void GapArray<ItemType, GrowthPolicy>::insert(const ItemType& item,
+                                              std::size_t index) {
+  // |item| may be stored in this array, copy it before items move.
+  insert(ItemType(item), index);
+}
+
+template <typename ItemType, typename GrowthPolicy>
+void GapArray<ItemType, GrowthPolicy>::insert(ItemType&& item,
+                                              std::size_t index) {
+  utils::validate(index, size(), utils::Action::kInsert);
+
+  ItemType value(std::move(item));
+  grow_if_needed(size() + 1);
+  move_gap(index);
+
+  new (items_ + gap_begin_) ItemType(std::move(value));
+  ++gap_begin_;
+}
+
+template <typename ItemType, typename GrowthPolicy>
+void GapArray<ItemType, GrowthPolicy>::prepend(const ItemType& item) {
+  insert(item, 0);
+}
+
+template <typename ItemType, typename GrowthPolicy>
+ItemType GapArray<ItemType, GrowthPolicy>::pop() {
+  std::size_t last_index = size() - 1;
+  utils::validate(last_index, size(), utils::Action::kRemove);
+
+  move_gap(size());
+  ItemType last_item = std::move(items_[last_index]);
+  destroy(items_ + last_index, items_ + gap_begin_);
+  --gap_begin_;
+  return last_item;
+}
+
+template <typename ItemType, typename GrowthPolicy>
+void GapArray<ItemType, GrowthPolicy>::remove_at(std::size_t index) {
+  utils::validate(index, size(), utils::Action::kRemove);
+
+  move_gap(index);
+  destroy(items_ + gap_end_, items_ + gap_end_ + 1);
+  ++gap_end_;
+}
+
+// Private
+
+template <typename ItemType, typename GrowthPolicy>
+std::size_t GapArray<ItemType, GrowthPolicy>::gap_size() const {
+  return gap_end_ - gap_begin_;
+}
+
+template <typename ItemType, typename GrowthPolicy>
+void GapArray<ItemType, GrowthPolicy>::move_gap(std::size_t index) {
+  // Without free slots, items are already where they'd be on either side.
+  if (gap_begin_ == gap_end_) {
+    gap_begin_ = index;
+    gap_end_ = index;
+    return;
+  }
+
+  if constexpr (std::is_trivially_copyable<ItemType>::value) {
+    if (index < gap_begin_) {
+      std::size_t count = gap_begin_ - index;
+      std::memmove(static_cast<void*>(items_ + gap_end_ - count),
+                   items_ + index, count * sizeof(ItemType));
+      gap_begin_ -= count;
+      gap_end_ -= count;
+    } else if (index > gap_begin_) {
+      std::size_t count = index - gap_begin_;
+      std::memmove(static_cast<void*>(items_ + gap_begin_), items_ + gap_end_,
+                   count * sizeof(ItemType));
+      gap_begin_ += count;
+      gap_end_ += count;
+    }
+    return;
+  }
+
+  // One item at a time, so array stays whole if a move throws.
+  while (gap_begin_ > index) {
+    new (items_ + gap_end_ - 1) ItemType(std::move(items_[gap_begin_ - 1]));
+    destroy(items_ + gap_begin_ - 1, items_ + gap_begin_);
+    --gap_begin_;
+    --gap_end_;
+  }
+  while (gap_begin_ < index) {
+    new (items_ + gap_begin_) ItemType(std::move(items_[gap_end_]));
+    destroy(items_ + gap_end_, items_ + gap_end_ + 1);
+    ++gap_begin_;
+    ++gap_end_;
+  }
+}
+
+template <typename ItemType, typename GrowthPolicy>
+void GapArray<ItemType, GrowthPolicy>::grow_if_needed(std::size_t new_size) {
+  if (new_size > capacity_) {
+    reallocate(GrowthPolicy::grow(capacity_, new_size, sizeof(ItemType)));
+  }
+}
+
+template <typename ItemType, typename GrowthPolicy>
+void GapArray<ItemType, GrowthPolicy>::reallocate(std::size_t new_capacity) {
+  std::size_t back_count = capacity_ - gap_end_;
+  std::size_t new_gap_end = new_capacity - back_count;
+  ItemType* new_items = allocate(new_capacity);
+
+  try {
+    move_construct(items_, items_ + gap_begin_, new_items);
+    try {
+      move_construct(items_ + gap_end_, items_ + capacity_,
+                     new_items + new_gap_end);
+    } catch (...) {
+      destroy(new_items, new_items + gap_begin_);
+      throw;
+    }
+  } catch (...) {
+    std::free(new_items);
+    throw;
+  }
+
+  destroy(items_, items_ + gap_begin_);
+  destroy(items_ + gap_end_, items_ + capacity_);
+  std::free(items_);
+
+  items_ = new_items;
+  gap_end_ = new_gap_end;
+  capacity_ = new_capacity;
+}
+
+template <typename ItemType, typename GrowthPolicy>
+void GapArray<ItemType, GrowthPolicy>::reset() {
+  destroy(items_, items_ + gap_begin_);
+  destroy(items_ + gap_end_, items_ + capacity_);
+  std::free(items_);
+
+  items_ = nullptr;
+  gap_begin_ = 0;
+  gap_end_ = 0;
+  capacity_ = 0;
+}
+
+template <typename ItemType, typename GrowthPolicy>
+ItemType* GapArray<ItemType, GrowthPolicy>::allocate(std::size_t capacity) {
+  if (capacity == 0) {
+    return nullptr;
+  }
+
+  void* items = std::malloc(capacity * sizeof(ItemType));
+  if (!items) {
+    throw std::bad_alloc();
+  }
+  return static_cast<ItemType*>(items);
+}
+
+template <typename ItemType, typename GrowthPolicy>
+void GapArray<ItemType, GrowthPolicy>::move_construct(ItemType* first,
+                                                      ItemType* last,
+                                                      ItemType* destination) {
+  if constexpr (std::is_trivially_copyable<ItemType>::value) {
+    if (first != last) {
+      std::memcpy(static_cast<void*>(destination), first,
+                  (last - first) * sizeof(ItemType));
+    }
+  } else {
+    ItemType* constructed = destination;
+    try {
+      for (; first != last; ++first, ++constructed) {
+        new (constructed) ItemType(std::move_if_noexcept(*first));
+      }
+    } catch (...) {
+      destroy(destination, constructed);
+      throw;
+    }
+  }
+}
+
+template <typename ItemType, typename GrowthPolicy>
+void GapArray<ItemType, GrowthPolicy>::destroy(ItemType* first,
+                                               ItemType* last) {
+  if constexpr (!std::is_trivially_destructible<ItemType>::value) {
+    for (; first != last; ++first) {
+      first->~ItemType();
+    }
+  }
+}
+
+}  // namespace td
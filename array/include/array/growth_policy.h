@@ -0,0 +1,116 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+
+#include "utils/allocator.h"
+
+namespace td {
+
+// https://stackoverflow.com/questions/1100311/what-is-the-ideal-growth-rate-for-a-dynamically-allocated-array
+constexpr int growth_factor = 2;
+
+namespace array {
+
+// Growth policies decide capacity of |Array| storage. A policy has two
+// static functions:
+//
+//   std::size_t grow(std::size_t capacity, std::size_t required,
+//                    std::size_t item_size);
+//
+// returns capacity for at least |required| items, when storage for
+// |capacity| items of |item_size| bytes is full, and
+//
+//   bool maps_pages(std::size_t capacity, std::size_t item_size);
+//
+// returns true if storage for |capacity| items should be pages mapped from
+// the system instead of memory of the allocator. It only applies to items
+// which are grown by realloc.
+
+// Double capacity. Fewest reallocations, but up to half of storage is
+// unused, and freed blocks never add up to the next, larger one.
+struct DoublingGrowth {
+  static std::size_t grow(std::size_t capacity,
+                          std::size_t required,
+                          std::size_t item_size);
+  static bool maps_pages(std::size_t capacity, std::size_t item_size);
+};
+
+// Grow capacity by half. More reallocations than doubling, but less unused
+// storage, and after a few steps freed blocks add up to the next one, so
+// the allocator can reuse them.
+struct HalfGrowth {
+  static std::size_t grow(std::size_t capacity,
+                          std::size_t required,
+                          std::size_t item_size);
+  static bool maps_pages(std::size_t capacity, std::size_t item_size);
+};
+
+// Double capacity until storage reaches |huge_size| bytes, then grow it by
+// a quarter, rounded to whole pages. Huge storage of items grown by realloc
+// is mapped directly and resized with |remap_pages|, which moves page
+// tables instead of copying items, so the smaller factor costs little and
+// at most a quarter of storage is unused.
+template <std::size_t huge_size = 1 << 21>
+struct PageGrowth {
+  static std::size_t grow(std::size_t capacity,
+                          std::size_t required,
+                          std::size_t item_size);
+  static bool maps_pages(std::size_t capacity, std::size_t item_size);
+};
+
+}  // namespace array
+}  // namespace td
+
+/****************  Growth policy implementation ****************/
+namespace td {
+namespace array {
+
+// Doubling growth
+
+inline std::size_t DoublingGrowth::grow(std::size_t capacity,
+                                        std::size_t required,
+                                        std::size_t) {
+  return std::max(capacity * growth_factor, required);
+}
+
+inline bool DoublingGrowth::maps_pages(std::size_t, std::size_t) {
+  return false;
+}
+
+// Half growth
+
+inline std::size_t HalfGrowth::grow(std::size_t capacity,
+                                    std::size_t required,
+                                    std::size_t) {
+  return std::max(capacity + capacity / 2, required);
+}
+
+inline bool HalfGrowth::maps_pages(std::size_t, std::size_t) {
+  return false;
+}
+
+// Page growth
+
+template <std::size_t huge_size>
+std::size_t PageGrowth<huge_size>::grow(std::size_t capacity,
+                                        std::size_t required,
+                                        std::size_t item_size) {
+  if (capacity * item_size < huge_size) {
+    return DoublingGrowth::grow(capacity, required, item_size);
+  }
+
+  std::size_t bytes = std::max(capacity + capacity / 4, required) * item_size;
+  std::size_t page = page_size();
+  bytes = (bytes + page - 1) / page * page;
+  return bytes / item_size;
+}
+
+template <std::size_t huge_size>
+bool PageGrowth<huge_size>::maps_pages(std::size_t capacity,
+                                       std::size_t item_size) {
+  return capacity * item_size >= huge_size;
+}
+
+}  // namespace array
+}  // namespace td
@@ -0,0 +1,314 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+
+#include "utils/utils.h"
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// AVX2 kernels are compiled for AVX2 by a target attribute, so a default
+// build has them too and picks them at run time on CPUs which support AVX2.
+// A build with -mavx2 uses them unconditionally.
+#if defined(__AVX2__)
+#define TD_TARGET_AVX2
+#elif defined(__SSE2__)
+#define TD_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace td {
+namespace array {
+
+// True if items of type |T| can be compared a register at a time: integers,
+// booleans and floating point numbers up to 8 bytes.
+template <typename T>
+constexpr bool is_vectorizable = std::is_arithmetic<T>::value && sizeof(T) <= 8;
+
+// Return index of first of |size| items equal to |item|, or
+// |index_not_found|. Items are compared 32 bytes at a time with AVX2, 16
+// bytes with SSE2, otherwise one by one.
+template <typename T>
+std::size_t find(const T* items, std::size_t size, T item);
+
+// Return number of |size| items equal to |item|, compared like |find|.
+template <typename T>
+std::size_t count(const T* items, std::size_t size, T item);
+
+#if defined(__SSE2__)
+
+// Return true if CPU supports AVX2.
+bool has_avx2();
+
+// |find| and |count| with one instruction set. |avx2| ones may only be
+// called if |has_avx2|.
+namespace sse2 {
+template <typename T>
+std::size_t find(const T* items, std::size_t size, T item);
+template <typename T>
+std::size_t count(const T* items, std::size_t size, T item);
+}  // namespace sse2
+
+namespace avx2 {
+template <typename T>
+TD_TARGET_AVX2 std::size_t find(const T* items, std::size_t size, T item);
+template <typename T>
+TD_TARGET_AVX2 std::size_t count(const T* items, std::size_t size, T item);
+}  // namespace avx2
+
+#endif
+
+}  // namespace array
+}  // namespace td
+
+/****************  SIMD implementation ****************/
+namespace td {
+namespace array {
+
+// Return index of first item equal to |item| among items in [first, size),
+// comparing one by one.
+template <typename T>
+std::size_t scalar_find(const T* items,
+                        std::size_t first,
+                        std::size_t size,
+                        T item) {
+  for (std::size_t i = first; i < size; ++i) {
+    if (items[i] == item)
+      return i;
+  }
+  return index_not_found;
+}
+
+// Return number of items equal to |item| among items in [first, size),
+// comparing one by one.
+template <typename T>
+std::size_t scalar_count(const T* items,
+                         std::size_t first,
+                         std::size_t size,
+                         T item) {
+  std::size_t result = 0;
+  for (std::size_t i = first; i < size; ++i)
+    result += items[i] == item;
+  return result;
+}
+
+template <typename T>
+std::size_t find(const T* items, std::size_t size, T item) {
+#if defined(__SSE2__)
+  return has_avx2() ? avx2::find(items, size, item)
+                    : sse2::find(items, size, item);
+#else
+  return scalar_find(items, 0, size, item);
+#endif
+}
+
+template <typename T>
+std::size_t count(const T* items, std::size_t size, T item) {
+#if defined(__SSE2__)
+  return has_avx2() ? avx2::count(items, size, item)
+                    : sse2::count(items, size, item);
+#else
+  return scalar_count(items, 0, size, item);
+#endif
+}
+
+#if defined(__SSE2__)
+
+inline bool has_avx2() {
+#if defined(__AVX2__)
+  return true;
+#else
+  static const bool supported =
+      (__builtin_cpu_init(), __builtin_cpu_supports("avx2"));
+  return supported;
+#endif
+}
+
+// SSE2
+
+namespace sse2 {
+
+using Register = __m128i;
+constexpr std::size_t register_width = 16;
+
+inline Register load(const void* bytes) {
+  return _mm_loadu_si128(static_cast<const __m128i*>(bytes));
+}
+
+// Return sign bit of each byte of |value|.
+inline std::uint32_t byte_mask(Register value) {
+  return static_cast<std::uint32_t>(_mm_movemask_epi8(value));
+}
+
+// Return all bits of an item set where items of |lhs| and |rhs| are equal.
+template <typename T>
+Register equal(Register lhs, Register rhs) {
+  if constexpr (std::is_same<T, float>::value) {
+    return _mm_castps_si128(
+        _mm_cmpeq_ps(_mm_castsi128_ps(lhs), _mm_castsi128_ps(rhs)));
+  } else if constexpr (std::is_same<T, double>::value) {
+    return _mm_castpd_si128(
+        _mm_cmpeq_pd(_mm_castsi128_pd(lhs), _mm_castsi128_pd(rhs)));
+  } else if constexpr (sizeof(T) == 1) {
+    return _mm_cmpeq_epi8(lhs, rhs);
+  } else if constexpr (sizeof(T) == 2) {
+    return _mm_cmpeq_epi16(lhs, rhs);
+  } else if constexpr (sizeof(T) == 4) {
+    return _mm_cmpeq_epi32(lhs, rhs);
+  } else {
+    // SSE2 has no 64-bit compare, both 32-bit halves must be equal.
+    Register halves = _mm_cmpeq_epi32(lhs, rhs);
+    return _mm_and_si128(halves,
+                         _mm_shuffle_epi32(halves, _MM_SHUFFLE(2, 3, 0, 1)));
+  }
+}
+
+// Return register with |item| in every lane.
+template <typename T>
+Register broadcast(T item) {
+  T items[register_width / sizeof(T)];
+  std::fill(std::begin(items), std::end(items), item);
+  return load(items);
+}
+
+// Return byte mask of items in the register at |items| which are equal to
+// |pattern|. Each matching item sets |sizeof(T)| consecutive bits.
+template <typename T>
+std::uint32_t match(const T* items, Register pattern) {
+  return byte_mask(equal<T>(load(items), pattern));
+}
+
+template <typename T>
+std::size_t find(const T* items, std::size_t size, T item) {
+  constexpr std::size_t lanes = register_width / sizeof(T);
+  Register pattern = broadcast(item);
+  std::size_t i = 0;
+  for (; i + lanes <= size; i += lanes) {
+    std::uint32_t mask = match(items + i, pattern);
+    if (mask)
+      return i + __builtin_ctz(mask) / sizeof(T);
+  }
+  return scalar_find(items, i, size, item);
+}
+
+template <typename T>
+std::size_t count(const T* items, std::size_t size, T item) {
+  constexpr std::size_t lanes = register_width / sizeof(T);
+  // Masks of several registers are joined into one 64-bit word, so there is
+  // one popcount per word, which is a long sequence without POPCNT.
+  constexpr std::size_t registers_per_word = 64 / register_width;
+  Register pattern = broadcast(item);
+  std::size_t matched_bits = 0;
+  std::size_t i = 0;
+  for (; i + lanes * registers_per_word <= size;
+       i += lanes * registers_per_word) {
+    std::uint64_t word = 0;
+    for (std::size_t j = 0; j < registers_per_word; ++j) {
+      word |= static_cast<std::uint64_t>(match(items + i + j * lanes, pattern))
+              << (j * register_width);
+    }
+    matched_bits += __builtin_popcountll(word);
+  }
+  for (; i + lanes <= size; i += lanes)
+    matched_bits += __builtin_popcount(match(items + i, pattern));
+  return matched_bits / sizeof(T) + scalar_count(items, i, size, item);
+}
+
+}  // namespace sse2
+
+// AVX2, every function which touches a register must be compiled for AVX2.
+
+namespace avx2 {
+
+using Register = __m256i;
+constexpr std::size_t register_width = 32;
+
+TD_TARGET_AVX2 inline Register load(const void* bytes) {
+  return _mm256_loadu_si256(static_cast<const __m256i*>(bytes));
+}
+
+// Return sign bit of each byte of |value|.
+TD_TARGET_AVX2 inline std::uint32_t byte_mask(Register value) {
+  return static_cast<std::uint32_t>(_mm256_movemask_epi8(value));
+}
+
+// Return all bits of an item set where items of |lhs| and |rhs| are equal.
+template <typename T>
+TD_TARGET_AVX2 Register equal(Register lhs, Register rhs) {
+  if constexpr (std::is_same<T, float>::value) {
+    return _mm256_castps_si256(_mm256_cmp_ps(
+        _mm256_castsi256_ps(lhs), _mm256_castsi256_ps(rhs), _CMP_EQ_OQ));
+  } else if constexpr (std::is_same<T, double>::value) {
+    return _mm256_castpd_si256(_mm256_cmp_pd(
+        _mm256_castsi256_pd(lhs), _mm256_castsi256_pd(rhs), _CMP_EQ_OQ));
+  } else if constexpr (sizeof(T) == 1) {
+    return _mm256_cmpeq_epi8(lhs, rhs);
+  } else if constexpr (sizeof(T) == 2) {
+    return _mm256_cmpeq_epi16(lhs, rhs);
+  } else if constexpr (sizeof(T) == 4) {
+    return _mm256_cmpeq_epi32(lhs, rhs);
+  } else {
+    return _mm256_cmpeq_epi64(lhs, rhs);
+  }
+}
+
+// Return register with |item| in every lane.
+template <typename T>
+TD_TARGET_AVX2 Register broadcast(T item) {
+  T items[register_width / sizeof(T)];
+  std::fill(std::begin(items), std::end(items), item);
+  return load(items);
+}
+
+// Return byte mask of items in the register at |items| which are equal to
+// |pattern|. Each matching item sets |sizeof(T)| consecutive bits.
+template <typename T>
+TD_TARGET_AVX2 std::uint32_t match(const T* items, Register pattern) {
+  return byte_mask(equal<T>(load(items), pattern));
+}
+
+template <typename T>
+TD_TARGET_AVX2 std::size_t find(const T* items, std::size_t size, T item) {
+  constexpr std::size_t lanes = register_width / sizeof(T);
+  Register pattern = broadcast(item);
+  std::size_t i = 0;
+  for (; i + lanes <= size; i += lanes) {
+    std::uint32_t mask = match(items + i, pattern);
+    if (mask)
+      return i + __builtin_ctz(mask) / sizeof(T);
+  }
+  return scalar_find(items, i, size, item);
+}
+
+template <typename T>
+TD_TARGET_AVX2 std::size_t count(const T* items, std::size_t size, T item) {
+  constexpr std::size_t lanes = register_width / sizeof(T);
+  // Masks of two registers are joined into one 64-bit word, see |sse2|.
+  constexpr std::size_t registers_per_word = 64 / register_width;
+  Register pattern = broadcast(item);
+  std::size_t matched_bits = 0;
+  std::size_t i = 0;
+  for (; i + lanes * registers_per_word <= size;
+       i += lanes * registers_per_word) {
+    std::uint64_t word = 0;
+    for (std::size_t j = 0; j < registers_per_word; ++j) {
+      word |= static_cast<std::uint64_t>(match(items + i + j * lanes, pattern))
+              << (j * register_width);
+    }
+    matched_bits += __builtin_popcountll(word);
+  }
+  for (; i + lanes <= size; i += lanes)
+    matched_bits += __builtin_popcount(match(items + i, pattern));
+  return matched_bits / sizeof(T) + scalar_count(items, i, size, item);
+}
+
+}  // namespace avx2
+
+#endif
+
+}  // namespace array
+}  // namespace td
@@ -0,0 +1,530 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <initializer_list>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "array/array.h"
+#include "array/simd.h"
+#include "utils/utils.h"
+
+namespace td {
+
+// A dynamic array which stores up to |inline_capacity| items inside itself
+// and moves them to the heap only when more are added, for short-lived arrays
+// which usually stay small. It has the interface of |Array|, except that it
+// never shrinks: once on the heap, items stay there until array is
+// destroyed.
+//
+// Moving an array whose items are inline moves every item, unlike |Array|
+// where a move only takes the pointer.
+template <typename ItemType, std::size_t inline_capacity>
+class SmallArray {
+  static_assert(inline_capacity > 0, "inline_capacity must be positive");
+  static_assert(alignof(ItemType) <= alignof(std::max_align_t),
+                "over-aligned items are not supported");
+
+ public:
+  // Items are contiguous, so pointers serve as random access iterators.
+  using iterator = ItemType*;
+  using const_iterator = const ItemType*;
+
+  SmallArray();
+  SmallArray(std::initializer_list<ItemType>&& il);
+
+  SmallArray(const SmallArray& other);
+  SmallArray(SmallArray&& other)
+      noexcept(std::is_nothrow_move_constructible<ItemType>::value);
+
+  SmallArray& operator=(const SmallArray& other);
+  SmallArray& operator=(SmallArray&& other)
+      noexcept(std::is_nothrow_move_constructible<ItemType>::value);
+
+  // Return item at |index|. |index| isn't checked, it must be less than
+  // |size()|.
+  ItemType& operator[](std::size_t index);
+  const ItemType& operator[](std::size_t index) const;
+
+  ~SmallArray();
+
+  // Return item at |index|. Throw std::out_of_range if |index| isn't less
+  // than |size()|.
+  ItemType& at(std::size_t index);
+  const ItemType& at(std::size_t index) const;
+
+  // Return pointer to first item. Items are stored contiguously.
+  ItemType* data();
+  const ItemType* data() const;
+
+  // Return iterators to first item and past last item. They are invalidated
+  // when array grows or is moved.
+  iterator begin();
+  iterator end();
+  const_iterator begin() const;
+  const_iterator end() const;
+
+  // Return number of items are currently stored in array.
+  std::size_t size() const;
+
+  // Return number of items array can hold without allocating.
+  std::size_t capacity() const;
+
+  // Return array is empty or not.
+  bool is_empty() const;
+
+  // Return true if items are stored inside array rather than on the heap.
+  bool is_inline() const;
+
+  // Return copy of item at |index|. Throw std::out_of_range if |index| isn't
+  // less than |size()|.
+  ItemType item_at(std::size_t index) const;
+
+  // Append |item| to the end of array.
+  void append(const ItemType& item);
+  void append(ItemType&& item);
+
+  // Insert |item| at |index|.
+  void insert(const ItemType& item, std::size_t index);
+
+  // Prepend |item| to the array.
+  void prepend(const ItemType& item);
+
+  // Remove last item and return it.
+  ItemType pop();
+
+  // Remove item at |index|
+  void remove_at(std::size_t index);
+
+  // Look for |item|, remove indexs holding it. Return number of removed
+  // items.
+  std::size_t remove(const ItemType& item);
+
+  // Remove items for which |predicate| returns true, keeping order of the
+  // rest. Return number of removed items.
+  template <typename Predicate>
+  std::size_t remove_if(Predicate predicate);
+
+  // Look for |item|, return first index with this
+  // value, returns |kIndexNotFound| if not found
+  std::size_t find(const ItemType& item) const;
+
+  // Return number of items equal to |item|.
+  std::size_t count(const ItemType& item) const;
+
+  // Return true if some item is equal to |item|.
+  bool contains(const ItemType& item) const;
+
+ private:
+  // Return start of inline storage.
+  ItemType* inline_items();
+
+  // If |new_size| is greater than |capacity_|, move items to heap storage
+  // with double capacity.
+  void grow_if_needed(std::size_t new_size);
+
+  // Take items of |other|, leaving it empty. Array must hold no items.
+  void take(SmallArray&& other);
+
+  // Destroy all items and free heap storage, leaving array empty and inline.
+  void reset();
+
+  // Destroy items in [first, last).
+  static void destroy(ItemType* first, ItemType* last);
+
+  // Points to |inline_storage_| or to heap storage. Only first |size_| items
+  // are constructed.
+  ItemType* items_;
+
+  // Number of items are currently stored in array.
+  std::size_t size_{0};
+
+  // Represent how many total items array can store without allocation.
+  std::size_t capacity_{inline_capacity};
+
+  alignas(ItemType) unsigned char inline_storage_[inline_capacity *
+                                                  sizeof(ItemType)];
+};
+
+}  // namespace td
+
+/****************  Small array implementation ****************/
+namespace td {
+
+// Public
+
+template <typename ItemType, std::size_t inline_capacity>
+SmallArray<ItemType, inline_capacity>::SmallArray() : items_(inline_items()) {}
+
+template <typename ItemType, std::size_t inline_capacity>
+SmallArray<ItemType, inline_capacity>::SmallArray(
+    std::initializer_list<ItemType>&& il)
+    : SmallArray() {
+  grow_if_needed(il.size());
+  for (const ItemType& data : il) {
+    append(data);
+  }
+}
+
+template <typename ItemType, std::size_t inline_capacity>
+SmallArray<ItemType, inline_capacity>::SmallArray(const SmallArray& other)
+    : SmallArray() {
+  grow_if_needed(other.size_);
+  std::uninitialized_copy(other.begin(), other.end(), items_);
+  size_ = other.size_;
+}
+
+template <typename ItemType, std::size_t inline_capacity>
+SmallArray<ItemType, inline_capacity>::SmallArray(SmallArray&& other)
+    noexcept(std::is_nothrow_move_constructible<ItemType>::value)
+    : SmallArray() {
+  take(std::move(other));
+}
+
+template <typename ItemType, std::size_t inline_capacity>
+SmallArray<ItemType, inline_capacity>&
+SmallArray<ItemType, inline_capacity>::operator=(const SmallArray& other) {
+  if (this != &other) {
+    SmallArray temp_array(other);
+    reset();
+    take(std::move(temp_array));
+  }
+  return *this;
+}
+
+template <typename ItemType, std::size_t inline_capacity>
+SmallArray<ItemType, inline_capacity>&
+SmallArray<ItemType, inline_capacity>::operator=(SmallArray&& other)
+    noexcept(std::is_nothrow_move_constructible<ItemType>::value) {
+  if (this != &other) {
+    reset();
+    take(std::move(other));
+  }
+  return *this;
+}
+
+template <typename ItemType, std::size_t inline_capacity>
+ItemType& SmallArray<ItemType, inline_capacity>::operator[](
+    std::size_t index) {
+  return items_[index];
+}
+
+template <typename ItemType, std::size_t inline_capacity>
+const ItemType& SmallArray<ItemType, inline_capacity>::operator[](
+    std::size_t index) const {
+  return items_[index];
+}
+
+template <typename ItemType, std::size_t inline_capacity>
+SmallArray<ItemType, inline_capacity>::~SmallArray() {
+  reset();
+}
+
+template <typename ItemType, std::size_t inline_capacity>
+ItemType& SmallArray<ItemType, inline_capacity>::at(std::size_t index) {
+  utils::validate(index, size_, utils::Action::kNone);
+  return items_[index];
+}
+
+template <typename ItemType, std::size_t inline_capacity>
+const ItemType& SmallArray<ItemType, inline_capacity>::at(
+    std::size_t index) const {
+  utils::validate(index, size_, utils::Action::kNone);
+  return items_[index];
+}
+
+template <typename ItemType, std::size_t inline_capacity>
+ItemType* SmallArray<ItemType, inline_capacity>::data() {
+  return items_;
+}
+
+template <typename ItemType, std::size_t inline_capacity>
+const ItemType* SmallArray<ItemType, inline_capacity>::data() const {
+  return items_;
+}
+
+template <typename ItemType, std::size_t inline_capacity>
+typename SmallArray<ItemType, inline_capacity>::iterator
+SmallArray<ItemType, inline_capacity>::begin() {
+  return items_;
+}
+
+template <typename ItemType, std::size_t inline_capacity>
+typename SmallArray<ItemType, inline_capacity>::iterator
+SmallArray<ItemType, inline_capacity>::end() {
+  return items_ + size_;
+}
+
+template <typename ItemType, std::size_t inline_capacity>
+typename SmallArray<ItemType, inline_capacity>::const_iterator
+SmallArray<ItemType, inline_capacity>::begin() const {
+  return items_;
+}
+
+template <typename ItemType, std::size_t inline_capacity>
+typename SmallArray<ItemType, inline_capacity>::const_iterator
+SmallArray<ItemType, inline_capacity>::end() const {
+  return items_ + size_;
+}
+
+template <typename ItemType, std::size_t inline_capacity>
+std::size_t SmallArray<ItemType, inline_capacity>::size() const {
+  return size_;
+}
+
+template <typename ItemType, std::size_t inline_capacity>
+std::size_t SmallArray<ItemType, inline_capacity>::capacity() const {
+  return capacity_;
+}
+
+template <typename ItemType, std::size_t inline_capacity>
+bool SmallArray<ItemType, inline_capacity>::is_empty() const {
+  return size_ == 0;
+}
+
+template <typename ItemType, std::size_t inline_capacity>
+bool SmallArray<ItemType, inline_capacity>::is_inline() const {
+  return items_ == reinterpret_cast<const ItemType*>(inline_storage_);
+}
+
+template <typename ItemType, std::size_t inline_capacity>
+ItemType SmallArray<ItemType, inline_capacity>::item_at(
+    std::size_t index) const {
+  return at(index);
+}
+
+template <typename ItemType, std::size_t inline_capacity>
+void SmallArray<ItemType, inline_capacity>::append(const ItemType& item) {
+  if (size_ == capacity_) {
+    // |item| may be stored in this array, copy it before storage moves.
+    append(ItemType(item));
+    return;
+  }
+
+  new (items_ + size_) ItemType(item);
+  ++size_;
+}
+
+template <typename ItemType, std::size_t inline_capacity>
+void SmallArray<ItemType, inline_capacity>::append(ItemType&& item) {
+  if (size_ == capacity_) {
+    ItemType value(std::move(item));
+    grow_if_needed(size_ + 1);
+    new (items_ + size_) ItemType(std::move(value));
+  } else {
+    new (items_ + size_) ItemType(std::move(item));
+  }
+  ++size_;
+}
+
+template <typename ItemType, std::size_t inline_capacity>
+void SmallArray<ItemType, inline_capacity>::insert(const ItemType& item,
+                                                   std::size_t index) {
+  utils::validate(index, size_, utils::Action::kInsert);
+  if (index == size_) {
+    append(item);
+    return;
+  }
+
+  // |item| may be stored in this array, copy it before items shift.
+  ItemType value(item);
+  grow_if_needed(size_ + 1);
+
+  new (items_ + size_) ItemType(std::move(items_[size_ - 1]));
+  for (std::size_t i = size_ - 1; i > index; --i) {
+    items_[i] = std::move(items_[i - 1]);
+  }
+  ++size_;
+
+  items_[index] = std::move(value);
+}
+
+template <typename ItemType, std::size_t inline_capacity>
+void SmallArray<ItemType, inline_capacity>::prepend(const ItemType& item) {
+  insert(item, 0);
+}
+
+template <typename ItemType, std::size_t inline_capacity>
+ItemType SmallArray<ItemType, inline_capacity>::pop() {
+  std::size_t last_index = size_ - 1;
+  utils::validate(last_index, size_, utils::Action::kRemove);
+
+  ItemType last_item = std::move(items_[last_index]);
+  destroy(items_ + last_index, items_ + size_);
+  --size_;
+  return last_item;
+}
+
+template <typename ItemType, std::size_t inline_capacity>
+void SmallArray<ItemType, inline_capacity>::remove_at(std::size_t index) {
+  utils::validate(index, size_, utils::Action::kRemove);
+
+  for (std::size_t i = index; i < size_ - 1; ++i) {
+    items_[i] = std::move(items_[i + 1]);
+  }
+  destroy(items_ + size_ - 1, items_ + size_);
+  --size_;
+}
+
+template <typename ItemType, std::size_t inline_capacity>
+std::size_t SmallArray<ItemType, inline_capacity>::remove(
+    const ItemType& item) {
+  // |item| may be stored in this array, copy it before items move.
+  return remove_if(
+      [value = item](const ItemType& other) { return other == value; });
+}
+
+template <typename ItemType, std::size_t inline_capacity>
+template <typename Predicate>
+std::size_t SmallArray<ItemType, inline_capacity>::remove_if(
+    Predicate predicate) {
+  std::size_t kept = 0;
+  for (std::size_t i = 0; i < size_; ++i) {
+    if (predicate(items_[i])) {
+      continue;
+    }
+
+    if (kept != i) {
+      items_[kept] = std::move(items_[i]);
+    }
+    ++kept;
+  }
+
+  std::size_t removed = size_ - kept;
+  destroy(items_ + kept, items_ + size_);
+  size_ = kept;
+  return removed;
+}
+
+template <typename ItemType, std::size_t inline_capacity>
+std::size_t SmallArray<ItemType, inline_capacity>::find(
+    const ItemType& item) const {
+  if constexpr (array::is_vectorizable<ItemType>) {
+    return array::find(items_, size_, item);
+  }
+
+  for (std::size_t i = 0; i < size_; ++i) {
+    if (item == items_[i]) {
+      return i;
+    }
+  }
+
+  return index_not_found;
+}
+
+template <typename ItemType, std::size_t inline_capacity>
+std::size_t SmallArray<ItemType, inline_capacity>::count(
+    const ItemType& item) const {
+  if constexpr (array::is_vectorizable<ItemType>) {
+    return array::count(items_, size_, item);
+  }
+
+  return std::count(begin(), end(), item);
+}
+
+template <typename ItemType, std::size_t inline_capacity>
+bool SmallArray<ItemType, inline_capacity>::contains(
+    const ItemType& item) const {
+  return find(item) != index_not_found;
+}
+
+// Private
+
+template <typename ItemType, std::size_t inline_capacity>
+ItemType* SmallArray<ItemType, inline_capacity>::inline_items() {
+  return reinterpret_cast<ItemType*>(inline_storage_);
+}
+
+template <typename ItemType, std::size_t inline_capacity>
+void SmallArray<ItemType, inline_capacity>::grow_if_needed(
+    std::size_t new_size) {
+  if (new_size <= capacity_) {
+    return;
+  }
+
+  std::size_t new_capacity = std::max(capacity_ * growth_factor, new_size);
+  void* new_storage;
+  if constexpr (std::is_trivially_copyable<ItemType>::value) {
+    if (!is_inline()) {
+      new_storage = std::realloc(items_, new_capacity * sizeof(ItemType));
+      if (!new_storage) {
+        throw std::bad_alloc();
+      }
+
+      items_ = static_cast<ItemType*>(new_storage);
+      capacity_ = new_capacity;
+      return;
+    }
+  }
+
+  new_storage = std::malloc(new_capacity * sizeof(ItemType));
+  if (!new_storage) {
+    throw std::bad_alloc();
+  }
+
+  ItemType* new_items = static_cast<ItemType*>(new_storage);
+  std::size_t constructed = 0;
+  try {
+    for (; constructed < size_; ++constructed) {
+      new (new_items + constructed)
+          ItemType(std::move_if_noexcept(items_[constructed]));
+    }
+  } catch (...) {
+    destroy(new_items, new_items + constructed);
+    std::free(new_items);
+    throw;
+  }
+
+  destroy(items_, items_ + size_);
+  if (!is_inline()) {
+    std::free(items_);
+  }
+  items_ = new_items;
+
+  capacity_ = new_capacity;
+}
+
+template <typename ItemType, std::size_t inline_capacity>
+void SmallArray<ItemType, inline_capacity>::take(SmallArray&& other) {
+  if (!other.is_inline()) {
+    items_ = other.items_;
+    size_ = other.size_;
+    capacity_ = other.capacity_;
+  } else {
+    std::uninitialized_move(other.begin(), other.end(), items_);
+    size_ = other.size_;
+    destroy(other.begin(), other.end());
+  }
+
+  other.items_ = other.inline_items();
+  other.size_ = 0;
+  other.capacity_ = inline_capacity;
+}
+
+template <typename ItemType, std::size_t inline_capacity>
+void SmallArray<ItemType, inline_capacity>::reset() {
+  destroy(items_, items_ + size_);
+  if (!is_inline()) {
+    std::free(items_);
+  }
+
+  items_ = inline_items();
+  size_ = 0;
+  capacity_ = inline_capacity;
+}
+
+template <typename ItemType, std::size_t inline_capacity>
+void SmallArray<ItemType, inline_capacity>::destroy(ItemType* first,
+                                                    ItemType* last) {
+  if constexpr (!std::is_trivially_destructible<ItemType>::value) {
+    for (; first != last; ++first) {
+      first->~ItemType();
+    }
+  }
+}
+
+}  // namespace td
@@ -0,0 +1,271 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "array/array.h"
+#include "array/span.h"
+#include "utils/utils.h"
+
+namespace td {
+
+// A dynamic array of rows with one field of each type in |Fields|, stored as
+// structure of arrays: every field has its own |Array| column. A loop which
+// reads one field of every row reads only that column, instead of pulling
+// whole rows into cache as an |Array| of structs does, and columns of
+// numbers can be passed to SIMD kernels through |column|.
+//
+// Columns are |Array|s which grow together, so each holds |size()| items
+// and none shrinks until |shrink_to_fit|. Rows are read and written
+// through |Row|, a tuple of references to fields.
+template <typename... Fields>
+class SoaArray {
+  static_assert(sizeof...(Fields) > 0, "SoaArray needs at least one field");
+
+ public:
+  // Type of field at |index|.
+  template <std::size_t index>
+  using Field = std::tuple_element_t<index, std::tuple<Fields...>>;
+
+  // References to fields of one row. Fields can be assigned through it, it
+  // can be assigned a tuple of values, and unpacked by structured bindings.
+  using Row = std::tuple<Fields&...>;
+  using ConstRow = std::tuple<const Fields&...>;
+
+  SoaArray() = default;
+  explicit SoaArray(std::size_t capacity);
+
+  // Return row at |index|. |index| isn't checked, it must be less than
+  // |size()|.
+  Row operator[](std::size_t index);
+  ConstRow operator[](std::size_t index) const;
+
+  // Return row at |index|. Throw std::out_of_range if |index| isn't less
+  // than |size()|.
+  Row at(std::size_t index);
+  ConstRow at(std::size_t index) const;
+
+  // Return field at |index| of every row. Column is contiguous, and is
+  // invalidated when array grows or shrinks.
+  template <std::size_t index>
+  array::Span<Field<index>> column();
+  template <std::size_t index>
+  array::Span<const Field<index>> column() const;
+
+  // Return number of rows are currently stored in array.
+  std::size_t size() const;
+
+  // Return number of rows array can hold.
+  std::size_t capacity() const;
+
+  // Return array is empty or not.
+  bool is_empty() const;
+
+  // Make room for at least |capacity| rows.
+  void reserve(std::size_t capacity);
+
+  // Reduce capacity to size of array.
+  void shrink_to_fit();
+
+  // Append a row of |values|, one for each field in order. If a field
+  // can't be added, array is left unchanged.
+  template <typename... Values>
+  void append(Values&&... values);
+
+  // Remove last row and return its fields.
+  std::tuple<Fields...> pop();
+
+  // Remove row at |index|.
+  void remove_at(std::size_t index);
+
+  // Remove rows for which |predicate| returns true, keeping order of the
+  // rest. |predicate| is called with a |ConstRow|. Return number of removed
+  // rows.
+  template <typename Predicate>
+  std::size_t remove_if(Predicate predicate);
+
+ private:
+  // Append |values| to columns at |indices|, popping appended ones if one
+  // throws.
+  template <std::size_t... indices, typename... Values>
+  void append_row(std::index_sequence<indices...>, Values&&... values);
+
+  // Remove last row and return its fields.
+  template <std::size_t... indices>
+  std::tuple<Fields...> pop_row(std::index_sequence<indices...>);
+
+  std::tuple<Array<Fields>...> columns_;
+};
+
+}  // namespace td
+
+/****************  SoA array implementation ****************/
+namespace td {
+
+// Public
+
+template <typename... Fields>
+SoaArray<Fields...>::SoaArray(std::size_t capacity)
+    : columns_(Array<Fields>(capacity)...) {}
+
+template <typename... Fields>
+typename SoaArray<Fields...>::Row SoaArray<Fields...>::operator[](
+    std::size_t index) {
+  return std::apply(
+      [index](Array<Fields>&... columns) { return Row(columns[index]...); },
+      columns_);
+}
+
+template <typename... Fields>
+typename SoaArray<Fields...>::ConstRow SoaArray<Fields...>::operator[](
+    std::size_t index) const {
+  return std::apply(
+      [index](const Array<Fields>&... columns) {
+        return ConstRow(columns[index]...);
+      },
+      columns_);
+}
+
+template <typename... Fields>
+typename SoaArray<Fields...>::Row SoaArray<Fields...>::at(std::size_t index) {
+  utils::validate(index, size(), utils::Action::kNone);
+  return (*this)[index];
+}
+
+template <typename... Fields>
+typename SoaArray<Fields...>::ConstRow SoaArray<Fields...>::at(
+    std::size_t index) const {
+  utils::validate(index, size(), utils::Action::kNone);
+  return (*this)[index];
+}
+
+template <typename... Fields>
+template <std::size_t index>
+array::Span<typename SoaArray<Fields...>::template Field<index>>
+SoaArray<Fields...>::column() {
+  return {std::get<index>(columns_).data(), size()};
+}
+
+template <typename... Fields>
+template <std::size_t index>
+array::Span<const typename SoaArray<Fields...>::template Field<index>>
+SoaArray<Fields...>::column() const {
+  return {std::get<index>(columns_).data(), size()};
+}
+
+template <typename... Fields>
+std::size_t SoaArray<Fields...>::size() const {
+  return std::get<0>(columns_).size();
+}
+
+template <typename... Fields>
+std::size_t SoaArray<Fields...>::capacity() const {
+  // Columns have equal capacity, unless growing one failed.
+  return std::apply(
+      [](const Array<Fields>&... columns) {
+        return std::min({columns.capacity()...});
+      },
+      columns_);
+}
+
+template <typename... Fields>
+bool SoaArray<Fields...>::is_empty() const {
+  return size() == 0;
+}
+
+template <typename... Fields>
+void SoaArray<Fields...>::reserve(std::size_t capacity) {
+  std::apply(
+      [capacity](Array<Fields>&... columns) {
+        (columns.reserve(capacity), ...);
+      },
+      columns_);
+}
+
+template <typename... Fields>
+void SoaArray<Fields...>::shrink_to_fit() {
+  std::apply([](Array<Fields>&... columns) { (columns.shrink_to_fit(), ...); },
+             columns_);
+}
+
+template <typename... Fields>
+template <typename... Values>
+void SoaArray<Fields...>::append(Values&&... values) {
+  static_assert(sizeof...(Values) == sizeof...(Fields),
+                "append needs one value for each field");
+  append_row(std::index_sequence_for<Fields...>(),
+             std::forward<Values>(values)...);
+}
+
+template <typename... Fields>
+std::tuple<Fields...> SoaArray<Fields...>::pop() {
+  return pop_row(std::index_sequence_for<Fields...>());
+}
+
+template <typename... Fields>
+void SoaArray<Fields...>::remove_at(std::size_t index) {
+  utils::validate(index, size(), utils::Action::kRemove);
+  std::apply(
+      [index](Array<Fields>&... columns) { (columns.remove_at(index), ...); },
+      columns_);
+}
+
+template <typename... Fields>
+template <typename Predicate>
+std::size_t SoaArray<Fields...>::remove_if(Predicate predicate) {
+  std::size_t old_size = size();
+  std::size_t kept = 0;
+  for (std::size_t i = 0; i < old_size; ++i) {
+    if (predicate(std::as_const(*this)[i])) {
+      continue;
+    }
+
+    if (kept != i) {
+      std::apply(
+          [kept, i](Array<Fields>&... columns) {
+            ((columns[kept] = std::move(columns[i])), ...);
+          },
+          columns_);
+    }
+    ++kept;
+  }
+
+  std::apply(
+      [kept, old_size](Array<Fields>&... columns) {
+        (columns.erase_range(kept, old_size), ...);
+      },
+      columns_);
+  return old_size - kept;
+}
+
+// Private
+
+template <typename... Fields>
+template <std::size_t... indices, typename... Values>
+void SoaArray<Fields...>::append_row(std::index_sequence<indices...>,
+                                     Values&&... values) {
+  std::size_t appended = 0;
+  try {
+    ((std::get<indices>(columns_).append(std::forward<Values>(values)),
+      ++appended),
+     ...);
+  } catch (...) {
+    ((indices < appended ? static_cast<void>(std::get<indices>(columns_).pop())
+                         : static_cast<void>(0)),
+     ...);
+    throw;
+  }
+}
+
+template <typename... Fields>
+template <std::size_t... indices>
+std::tuple<Fields...> SoaArray<Fields...>::pop_row(
+    std::index_sequence<indices...>) {
+  utils::validate(size() - 1, size(), utils::Action::kRemove);
+  return std::tuple<Fields...>{std::get<indices>(columns_).pop()...};
+}
+
+}  // namespace td
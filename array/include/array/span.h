@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+
+namespace td {
+namespace array {
+
+// View of |size| contiguous items owned by someone else, such as a column of
+// |SoaArray|. Items may be changed through it unless |T| is const. A span is
+// invalidated when its owner reallocates.
+template <typename T>
+class Span {
+ public:
+  using iterator = T*;
+
+  Span(T* data, std::size_t size);
+
+  // Return item at |index|. |index| isn't checked, it must be less than
+  // |size()|.
+  T& operator[](std::size_t index) const;
+
+  // Return pointer to first item.
+  T* data() const;
+
+  // Return number of items.
+  std::size_t size() const;
+
+  // Return iterators to first item and past last item.
+  iterator begin() const;
+  iterator end() const;
+
+ private:
+  T* data_;
+  std::size_t size_;
+};
+
+}  // namespace array
+}  // namespace td
+
+/****************  Span implementation ****************/
+namespace td {
+namespace array {
+
+template <typename T>
+Span<T>::Span(T* data, std::size_t size) : data_(data), size_(size) {}
+
+template <typename T>
+T& Span<T>::operator[](std::size_t index) const {
+  return data_[index];
+}
+
+template <typename T>
+T* Span<T>::data() const {
+  return data_;
+}
+
+template <typename T>
+std::size_t Span<T>::size() const {
+  return size_;
+}
+
+template <typename T>
+typename Span<T>::iterator Span<T>::begin() const {
+  return data_;
+}
+
+template <typename T>
+typename Span<T>::iterator Span<T>::end() const {
+  return data_ + size_;
+}
+
+}  // namespace array
+}  // namespace td
@@ -1,4 +1,14 @@
+#include <algorithm>
+#include <iterator>
+#include <list>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <type_traits>
+#include <vector>
+
 #include "array/array.h"
+#include "utils/allocator.h"
 #include "gtest/gtest.h"
 
 namespace {
@@ -37,6 +47,45 @@ TEST(ArrayTest, BracketOperator) {
   EXPECT_EQ(10, array[2]);
 }
 
+TEST(ArrayTest, At) {
+  Array<int> array({0, 1, 2});
+  EXPECT_THROW(array.at(3), std::out_of_range);
+
+  array.at(1) = 10;
+  EXPECT_EQ(10, array.at(1));
+
+  const Array<int>& const_array = array;
+  EXPECT_EQ(2, const_array.at(2));
+  EXPECT_THROW(const_array.at(3), std::out_of_range);
+}
+
+TEST(ArrayTest, Iterators) {
+  static_assert(
+      std::is_same<std::random_access_iterator_tag,
+                   std::iterator_traits<Array<int>::iterator>::
+                       iterator_category>::value,
+      "");
+
+  Array<int> array;
+  EXPECT_EQ(array.begin(), array.end());
+
+  array = Array<int>({3, 1, 2});
+  EXPECT_EQ(array.data(), array.begin());
+  EXPECT_EQ(3, array.end() - array.begin());
+
+  std::sort(array.begin(), array.end());
+  EXPECT_EQ(1, array[0]);
+  EXPECT_EQ(3, array[2]);
+
+  for (int& item : array) {
+    item *= 2;
+  }
+
+  const Array<int>& const_array = array;
+  EXPECT_EQ(12, std::accumulate(const_array.begin(), const_array.end(), 0));
+  EXPECT_EQ(4, const_array.data()[1]);
+}
+
 TEST(ArrayTest, Size) {
   Array<int> array({0, 1, 2});
   EXPECT_EQ(3, array.size());
@@ -107,6 +156,44 @@ TEST(ArrayTest, Insert) {
   EXPECT_EQ(32, array.capacity());
 }
 
+TEST(ArrayTest, AppendRange) {
+  Array<int> array({0, 1});
+  int items[] = {2, 3, 4};
+  array.append_range(std::begin(items), std::end(items));
+  array.append_range(items, items);
+  EXPECT_EQ(5, array.size());
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_EQ(i, array[i]);
+  }
+
+  // Storage grows once, to fit all items.
+  std::vector<int> many(100, 7);
+  array.append_range(many.begin(), many.end());
+  EXPECT_EQ(105, array.size());
+  EXPECT_EQ(105, array.capacity());
+  EXPECT_EQ(7, array[104]);
+}
+
+TEST(ArrayTest, InsertRange) {
+  Array<int> array({0, 1, 5});
+  int items[] = {2, 3, 4};
+  EXPECT_THROW(array.insert_range(items, items + 3, 4), std::out_of_range);
+
+  array.insert_range(items, items + 3, 2);
+  array.insert_range(items, items + 1, 6);
+  array.insert_range(items + 1, items + 2, 0);
+  Array<int> expected({3, 0, 1, 2, 3, 4, 5, 2});
+  EXPECT_TRUE(std::equal(expected.begin(), expected.end(), array.begin(),
+                         array.end()));
+
+  // Iterators which aren't pointers.
+  std::list<int> list({-2, -1});
+  array.insert_range(list.begin(), list.end(), 0);
+  EXPECT_EQ(10, array.size());
+  EXPECT_EQ(-2, array[0]);
+  EXPECT_EQ(3, array[2]);
+}
+
 TEST(ArrayTest, Prepend) {
   Array<int> array;
 
@@ -136,9 +223,81 @@ TEST(ArrayTest, Pop) {
   array.pop();
   array.pop();
   array.pop();
-  EXPECT_EQ(32, array.capacity());
   array.pop();
+  EXPECT_EQ(8, array.size());
+  EXPECT_EQ(32, array.capacity());
+
+  // Popping never shrinks storage.
+  while (!array.is_empty()) {
+    array.pop();
+  }
+  EXPECT_EQ(32, array.capacity());
+}
+
+TEST(ArrayTest, ReserveAndShrinkToFit) {
+  Array<int> array;
+  array.reserve(10);
   EXPECT_EQ(16, array.capacity());
+  array.reserve(100);
+  EXPECT_EQ(100, array.capacity());
+
+  for (int i = 0; i < 100; ++i) {
+    array.append(i);
+  }
+  EXPECT_EQ(100, array.capacity());
+
+  for (int i = 0; i < 90; ++i) {
+    array.pop();
+  }
+  EXPECT_EQ(100, array.capacity());
+  array.shrink_to_fit();
+  EXPECT_EQ(10, array.capacity());
+  EXPECT_EQ(9, array[9]);
+
+  array.remove_if([](int) { return true; });
+  array.shrink_to_fit();
+  EXPECT_EQ(0, array.capacity());
+  array.append(1);
+  EXPECT_EQ(1, array[0]);
+}
+
+TEST(ArrayTest, GrowthPolicies) {
+  Array<int, MallocAllocator<int>, array::HalfGrowth> half;
+  for (int i = 0; i < 17; ++i) {
+    half.append(i);
+  }
+  EXPECT_EQ(24, half.capacity());
+
+  // Storage of 4 KiB and more is mapped pages, grown by a quarter.
+  using PageArray = Array<int, MallocAllocator<int>, array::PageGrowth<4096>>;
+  std::size_t page_items = page_size() / sizeof(int);
+  PageArray pages;
+  for (std::size_t i = 0; i < 64 * page_items; ++i) {
+    pages.append(static_cast<int>(i));
+  }
+  EXPECT_EQ(0, pages.capacity() % page_items);
+  EXPECT_GE(64 * page_items * 5 / 4 + page_items, pages.capacity());
+  EXPECT_EQ(12345, pages[12345]);
+
+  PageArray copy(pages);
+  EXPECT_EQ(pages.size(), copy.size());
+  EXPECT_EQ(64 * page_items - 1, copy[64 * page_items - 1]);
+
+  // Shrinking moves items back to memory of the allocator.
+  while (pages.size() > 10) {
+    pages.pop();
+  }
+  pages.shrink_to_fit();
+  EXPECT_EQ(10, pages.capacity());
+  EXPECT_EQ(9, pages[9]);
+
+  // Items which aren't grown by realloc use the allocator at any size.
+  Array<std::string, std::allocator<std::string>, array::PageGrowth<4096>>
+      strings;
+  for (int i = 0; i < 1000; ++i) {
+    strings.append(std::to_string(i));
+  }
+  EXPECT_EQ("999", strings[999]);
 }
 
 TEST(ArrayTest, RemoveAt) {
@@ -156,6 +315,40 @@ TEST(ArrayTest, RemoveAt) {
   EXPECT_TRUE(array.is_empty());
 }
 
+TEST(ArrayTest, EraseRange) {
+  Array<int> array({0, 1, 2, 3, 4, 5});
+  EXPECT_THROW(array.erase_range(2, 7), std::out_of_range);
+  EXPECT_THROW(array.erase_range(3, 2), std::out_of_range);
+
+  array.erase_range(1, 3);
+  array.erase_range(2, 2);
+  EXPECT_EQ(4, array.size());
+  EXPECT_EQ(0, array[0]);
+  EXPECT_EQ(3, array[1]);
+  EXPECT_EQ(5, array[3]);
+
+  array.erase_range(0, 4);
+  EXPECT_TRUE(array.is_empty());
+  EXPECT_EQ(16, array.capacity());
+}
+
+TEST(ArrayTest, Resize) {
+  Array<int> array({1, 2});
+  array.resize(40);
+  EXPECT_EQ(40, array.size());
+  EXPECT_EQ(40, array.capacity());
+  EXPECT_EQ(2, array[1]);
+  EXPECT_EQ(0, array[39]);
+
+  array.resize(1);
+  EXPECT_EQ(1, array.size());
+  EXPECT_EQ(40, array.capacity());
+
+  array.resize(3, 9);
+  EXPECT_EQ(1, array[0]);
+  EXPECT_EQ(9, array[2]);
+}
+
 TEST(ArrayTest, Remove) {
   Array<int> array({0, 1, 2});
 
@@ -179,5 +372,214 @@ TEST(ArrayTest, Find) {
   EXPECT_EQ(1, array.find(1));
   EXPECT_EQ(2, array.find(2));
 }
+
+TEST(ArrayTest, NonTrivialItems) {
+  Array<std::string> array;
+  for (int i = 0; i < 100; ++i) {
+    array.append("a string too long for small string optimization " +
+                 std::to_string(i));
+  }
+  EXPECT_EQ(100, array.size());
+  EXPECT_EQ(128, array.capacity());
+  EXPECT_EQ("a string too long for small string optimization 42", array[42]);
+
+  Array<std::string> copy(array);
+  array.insert("inserted", 1);
+  array.remove_at(0);
+  EXPECT_EQ("inserted", array[0]);
+  EXPECT_EQ(copy[99], array.pop());
+  EXPECT_EQ(99, array.size());
+  EXPECT_EQ(100, copy.size());
+
+  while (array.size() > 1) {
+    array.pop();
+  }
+  EXPECT_EQ(128, array.capacity());
+  array.shrink_to_fit();
+  EXPECT_EQ(1, array.capacity());
+  EXPECT_EQ("inserted", array[0]);
+}
+
+TEST(ArrayTest, AppendItemOfSameArray) {
+  Array<std::string> array({"first"});
+  for (int i = 0; i < 40; ++i) {
+    array.append(array[0]);
+  }
+  array.insert(array[0], 0);
+  EXPECT_EQ(42, array.size());
+  EXPECT_EQ("first", array[41]);
+}
+
+TEST(ArrayTest, MoveOnlyItems) {
+  // Moves don't throw, so containers of arrays move them when they grow.
+  static_assert(std::is_nothrow_move_constructible<Array<std::string>>::value,
+                "");
+  static_assert(std::is_nothrow_move_assignable<Array<std::string>>::value,
+                "");
+
+  Array<std::unique_ptr<int>> array;
+  for (int i = 0; i < 100; ++i) {
+    array.append(std::make_unique<int>(i));
+  }
+  EXPECT_EQ(100, array.size());
+  EXPECT_EQ(42, *array[42]);
+  EXPECT_EQ(99, *array.pop());
+}
+
+// Item which can't be default constructed and counts live instances.
+struct Counted {
+  static int live;
+
+  explicit Counted(int v) : value(v) { ++live; }
+  Counted(const Counted& other) : value(other.value) { ++live; }
+  Counted& operator=(const Counted& other) = default;
+  ~Counted() { --live; }
+
+  int value;
+};
+
+int Counted::live = 0;
+
+TEST(ArrayTest, ItemsAreConstructedOnlyWhenAdded) {
+  {
+    Array<Counted> array;
+    EXPECT_EQ(0, Counted::live);
+    for (int i = 0; i < 20; ++i) {
+      array.append(Counted(i));
+    }
+    EXPECT_EQ(20, Counted::live);
+
+    array.remove_at(0);
+    EXPECT_EQ(19, Counted::live);
+    EXPECT_EQ(19, array.pop().value);
+    EXPECT_EQ(18, Counted::live);
+
+    Array<Counted> copy(array);
+    EXPECT_EQ(36, Counted::live);
+  }
+  EXPECT_EQ(0, Counted::live);
+}
+
+TEST(ArrayTest, RangesOfNonTrivialItems) {
+  {
+    Array<Counted> array;
+    std::vector<Counted> items;
+    for (int i = 0; i < 10; ++i) {
+      items.emplace_back(i);
+    }
+
+    array.append_range(items.begin(), items.begin() + 4);
+    array.insert_range(items.begin() + 4, items.end(), 2);
+    EXPECT_EQ(20, Counted::live);
+    int expected[] = {0, 1, 4, 5, 6, 7, 8, 9, 2, 3};
+    for (int i = 0; i < 10; ++i) {
+      EXPECT_EQ(expected[i], array[i].value);
+    }
+
+    array.erase_range(1, 8);
+    EXPECT_EQ(13, Counted::live);
+    EXPECT_EQ(0, array[0].value);
+    EXPECT_EQ(2, array[1].value);
+    EXPECT_EQ(3, array[2].value);
+
+    // Filling with an item of the array itself.
+    array.resize(30, array[2]);
+    EXPECT_EQ(40, Counted::live);
+    EXPECT_EQ(3, array[29].value);
+    array.resize(2, Counted(0));
+    EXPECT_EQ(12, Counted::live);
+  }
+  EXPECT_EQ(0, Counted::live);
+
+  Array<std::string> strings({"a", "e"});
+  std::vector<std::string> items({"b", "c", "d"});
+  strings.insert_range(items.begin(), items.end(), 1);
+  strings.resize(7);
+  EXPECT_EQ("abcde", std::accumulate(strings.begin(), strings.end(),
+                                     std::string()));
+  strings.erase_range(0, 3);
+  EXPECT_EQ("d", strings[0]);
+  EXPECT_EQ(4, strings.size());
+}
+
+TEST(ArrayTest, RemoveMany) {
+  Array<int> array;
+  for (int i = 0; i < 1000; ++i) {
+    array.append(i % 3);
+  }
+
+  EXPECT_EQ(334, array.remove(0));
+  EXPECT_EQ(666, array.size());
+  EXPECT_EQ(1024, array.capacity());
+  for (std::size_t i = 0; i < array.size(); ++i) {
+    EXPECT_EQ(1 + i % 2, array[i]);
+  }
+
+  EXPECT_EQ(666, array.remove_if([](int item) { return item > 0; }));
+  EXPECT_TRUE(array.is_empty());
+  EXPECT_EQ(1024, array.capacity());
+}
+
+TEST(ArrayTest, RemoveIf) {
+  Array<std::string> array({"a", "bb", "c", "dd", "a"});
+
+  EXPECT_EQ(0, array.remove_if([](const std::string&) { return false; }));
+  EXPECT_EQ(2, array.remove_if(
+                   [](const std::string& item) { return item.size() == 2; }));
+  EXPECT_EQ(3, array.size());
+  EXPECT_EQ("a", array[0]);
+  EXPECT_EQ("c", array[1]);
+  EXPECT_EQ("a", array[2]);
+
+  // Removing an item of the array itself.
+  EXPECT_EQ(2, array.remove(array[0]));
+  EXPECT_EQ(1, array.size());
+  EXPECT_EQ("c", array[0]);
+}
+
+TEST(ArrayTest, CountAndContains) {
+  Array<double> array({1.0, 2.0, 1.0, -0.0});
+  EXPECT_EQ(2, array.count(1.0));
+  EXPECT_EQ(1, array.count(0.0));
+  EXPECT_EQ(0, array.count(3.0));
+  EXPECT_TRUE(array.contains(2.0));
+  EXPECT_FALSE(array.contains(3.0));
+  EXPECT_EQ(3, array.find(0.0));
+
+  Array<std::string> strings({"a", "b", "a"});
+  EXPECT_EQ(2, strings.count("a"));
+  EXPECT_TRUE(strings.contains("b"));
+  EXPECT_FALSE(strings.contains("c"));
+
+  Array<bool> flags;
+  for (int i = 0; i < 100; ++i) {
+    flags.append(i % 10 == 9);
+  }
+  EXPECT_EQ(10, flags.count(true));
+  EXPECT_EQ(9, flags.find(true));
+}
+
+TEST(ArrayTest, Allocators) {
+  MonotonicArena arena;
+  Array<int, ArenaAllocator<int>> array{ArenaAllocator<int>(arena)};
+  for (int i = 0; i < 100; ++i) {
+    array.append(i);
+  }
+  EXPECT_EQ(99, array[99]);
+  EXPECT_EQ(128, array.capacity());
+  EXPECT_GE(arena.bytes_allocated(), 128 * sizeof(int));
+
+  Array<int, ArenaAllocator<int>> copy(array);
+  EXPECT_EQ(100, copy.size());
+  EXPECT_GE(arena.bytes_allocated(), 2 * 128 * sizeof(int));
+
+  Array<std::string, std::allocator<std::string>> strings({"a", "b"});
+  for (int i = 0; i < 20; ++i) {
+    strings.append(strings[0]);
+  }
+  strings.remove("b");
+  EXPECT_EQ(21, strings.size());
+  EXPECT_EQ("a", strings.pop());
+}
 }
 
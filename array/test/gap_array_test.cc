@@ -0,0 +1,123 @@
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "array/gap_array.h"
+#include "gtest/gtest.h"
+
+namespace {
+using namespace td;
+
+// Return items of |array| in order.
+template <typename ArrayType>
+auto items_of(const ArrayType& array) {
+  std::vector<std::decay_t<decltype(array[0])>> items;
+  for (std::size_t i = 0; i < array.size(); ++i) {
+    items.push_back(array[i]);
+  }
+  return items;
+}
+
+TEST(GapArrayTest, Constructors) {
+  GapArray<int> array;
+  EXPECT_EQ(0, array.size());
+  EXPECT_EQ(16, array.capacity());
+  EXPECT_TRUE(array.is_empty());
+
+  GapArray<int> list({0, 1, 2});
+  EXPECT_EQ(std::vector<int>({0, 1, 2}), items_of(list));
+
+  GapArray<int> copy(list);
+  GapArray<int> moved(std::move(list));
+  EXPECT_EQ(std::vector<int>({0, 1, 2}), items_of(copy));
+  EXPECT_EQ(std::vector<int>({0, 1, 2}), items_of(moved));
+  EXPECT_TRUE(list.is_empty());
+
+  list = copy;
+  copy = GapArray<int>({3});
+  EXPECT_EQ(std::vector<int>({0, 1, 2}), items_of(list));
+  EXPECT_EQ(std::vector<int>({3}), items_of(copy));
+}
+
+TEST(GapArrayTest, InsertAndRemove) {
+  GapArray<int> array;
+  EXPECT_THROW(array.insert(0, 1), std::out_of_range);
+  EXPECT_THROW(array.remove_at(0), std::out_of_range);
+  EXPECT_THROW(array.pop(), std::out_of_range);
+
+  for (int i = 0; i < 10; ++i) {
+    array.append(i);
+  }
+  array.insert(100, 5);
+  array.insert(101, 6);
+  array.prepend(-1);
+  array.insert(102, 1);
+  EXPECT_EQ(std::vector<int>({-1, 102, 0, 1, 2, 3, 4, 100, 101, 5, 6, 7, 8,
+                              9}),
+            items_of(array));
+
+  array.remove_at(8);
+  array.remove_at(0);
+  EXPECT_EQ(9, array.pop());
+  array.remove_at(10);
+  EXPECT_EQ(std::vector<int>({102, 0, 1, 2, 3, 4, 100, 5, 6, 7}),
+            items_of(array));
+  EXPECT_EQ(7, array.at(9));
+  EXPECT_THROW(array.at(10), std::out_of_range);
+  EXPECT_EQ(16, array.capacity());
+}
+
+TEST(GapArrayTest, MatchesArray) {
+  // Edits jump around and grow the array, with items on both sides of the
+  // gap.
+  GapArray<std::string> gap_array;
+  std::vector<std::string> expected;
+  unsigned position = 0;
+  for (int i = 0; i < 2000; ++i) {
+    position = (position * 31 + 17) % (expected.size() + 1);
+    std::string item = "a string too long for small strings " +
+                       std::to_string(i);
+    if (i % 3 == 2 && position < expected.size()) {
+      gap_array.remove_at(position);
+      expected.erase(expected.begin() + position);
+    } else {
+      gap_array.insert(item, position);
+      expected.insert(expected.begin() + position, item);
+    }
+  }
+  EXPECT_EQ(expected, items_of(gap_array));
+
+  GapArray<std::string> copy(gap_array);
+  EXPECT_EQ(expected, items_of(copy));
+
+  gap_array.shrink_to_fit();
+  EXPECT_EQ(expected.size(), gap_array.capacity());
+  EXPECT_EQ(expected, items_of(gap_array));
+  gap_array.insert(gap_array[3], 0);
+  EXPECT_EQ(expected[3], gap_array[0]);
+}
+
+TEST(GapArrayTest, MoveOnlyItems) {
+  static_assert(
+      std::is_nothrow_move_constructible<GapArray<std::string>>::value, "");
+  static_assert(std::is_nothrow_move_assignable<GapArray<std::string>>::value,
+                "");
+
+  GapArray<std::unique_ptr<int>> array;
+  std::vector<int> expected;
+  for (int i = 0; i < 100; ++i) {
+    array.insert(std::make_unique<int>(i), array.size() / 2);
+    expected.insert(expected.begin() + expected.size() / 2, i);
+  }
+  array.reserve(1000);
+  EXPECT_EQ(1000, array.capacity());
+  EXPECT_EQ(100, array.size());
+  for (std::size_t i = 0; i < expected.size(); ++i) {
+    EXPECT_EQ(expected[i], *array[i]);
+  }
+  EXPECT_EQ(expected.back(), *array.pop());
+}
+
+}  // namespace
@@ -0,0 +1,88 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "array/simd.h"
+#include "gtest/gtest.h"
+
+namespace {
+using namespace td;
+
+// Return index of first item equal to |item| by comparing one by one.
+template <typename T>
+std::size_t scalar_find(const std::vector<T>& items, T item) {
+  auto it = std::find(items.begin(), items.end(), item);
+  return it == items.end() ? index_not_found : it - items.begin();
+}
+
+// Check |array::find| and |array::count| against scalar loops for arrays of
+// every length up to 100, holding values picked from |values|.
+template <typename T>
+void check_against_scalar(const std::vector<T>& values) {
+  std::mt19937 generator(1);
+  for (std::size_t size = 0; size <= 100; ++size) {
+    std::vector<T> items;
+    for (std::size_t i = 0; i < size; ++i)
+      items.push_back(values[generator() % values.size()]);
+
+    for (T item : values) {
+      std::size_t index = scalar_find(items, item);
+      std::size_t count = std::count(items.begin(), items.end(), item);
+      EXPECT_EQ(index, array::find(items.data(), items.size(), item));
+      EXPECT_EQ(count, array::count(items.data(), items.size(), item));
+
+#if defined(__SSE2__)
+      // Kernels which aren't picked on this CPU are checked too.
+      EXPECT_EQ(index, array::sse2::find(items.data(), items.size(), item));
+      EXPECT_EQ(count, array::sse2::count(items.data(), items.size(), item));
+      if (array::has_avx2()) {
+        EXPECT_EQ(index, array::avx2::find(items.data(), items.size(), item));
+        EXPECT_EQ(count,
+                  array::avx2::count(items.data(), items.size(), item));
+      }
+#endif
+    }
+  }
+}
+
+static_assert(array::is_vectorizable<int>, "");
+static_assert(array::is_vectorizable<double>, "");
+static_assert(!array::is_vectorizable<long double>, "");
+static_assert(!array::is_vectorizable<int*>, "");
+
+TEST(SimdTest, Integers) {
+  check_against_scalar<std::int8_t>({-128, -1, 0, 1, 127});
+  check_against_scalar<char>({'a', 'b', 'c'});
+  check_against_scalar<std::uint16_t>({0, 1, 0x100, 0xFFFF});
+  check_against_scalar<std::int32_t>({-1, 0, 1, 1 << 16, 1 << 30});
+
+  // 64-bit items which share lower or upper 32 bits.
+  check_against_scalar<std::uint64_t>(
+      {0, 1, 1ULL << 32, (1ULL << 32) + 1, ~0ULL});
+  check_against_scalar<std::int64_t>({-1, 0, 1, 0xFFFFFFFF});
+}
+
+TEST(SimdTest, FloatingPoint) {
+  // Zeros of both signs are equal, NaN isn't equal to anything.
+  check_against_scalar<float>(
+      {0.0f, -0.0f, 1.5f, std::numeric_limits<float>::quiet_NaN(),
+       std::numeric_limits<float>::infinity()});
+  check_against_scalar<double>(
+      {0.0, -0.0, 1.5, std::numeric_limits<double>::quiet_NaN(), 1e300});
+}
+
+TEST(SimdTest, MatchInLastRegisterAndTail) {
+  std::vector<std::int32_t> items(1000, 0);
+  items[999] = 7;
+  EXPECT_EQ(999, array::find(items.data(), items.size(), 7));
+  items[992] = 7;
+  EXPECT_EQ(992, array::find(items.data(), items.size(), 7));
+  EXPECT_EQ(2, array::count(items.data(), items.size(), 7));
+  EXPECT_EQ(998, array::count(items.data(), items.size(), 0));
+  EXPECT_EQ(index_not_found, array::find(items.data(), items.size(), 1));
+}
+
+}  // namespace
@@ -0,0 +1,139 @@
+#include <memory>
+#include <string>
+#include <type_traits>
+
+#include "array/small_array.h"
+#include "gtest/gtest.h"
+
+namespace {
+
+using namespace td;
+
+TEST(SmallArrayTest, StaysInlineUpToCapacity) {
+  SmallArray<int, 4> array;
+  EXPECT_TRUE(array.is_empty());
+  EXPECT_TRUE(array.is_inline());
+  EXPECT_EQ(4, array.capacity());
+
+  for (int i = 0; i < 4; ++i) {
+    array.append(i);
+  }
+  EXPECT_TRUE(array.is_inline());
+  EXPECT_EQ(3, array[3]);
+
+  array.append(4);
+  EXPECT_FALSE(array.is_inline());
+  EXPECT_EQ(5, array.size());
+  EXPECT_EQ(8, array.capacity());
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_EQ(i, array.at(i));
+  }
+  EXPECT_THROW(array.at(5), std::out_of_range);
+
+  // Never moves back inline.
+  while (!array.is_empty()) {
+    array.pop();
+  }
+  EXPECT_FALSE(array.is_inline());
+  EXPECT_THROW(array.pop(), std::out_of_range);
+}
+
+TEST(SmallArrayTest, InsertAndRemove) {
+  SmallArray<int, 4> array({1, 3});
+  array.insert(2, 1);
+  array.prepend(0);
+  array.insert(4, 4);
+  EXPECT_THROW(array.insert(6, 6), std::out_of_range);
+  EXPECT_EQ(5, array.size());
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_EQ(i, array[i]);
+  }
+
+  array.remove_at(0);
+  EXPECT_EQ(1, array.item_at(0));
+  EXPECT_THROW(array.remove_at(4), std::out_of_range);
+
+  array.append(2);
+  EXPECT_EQ(2, array.count(2));
+  EXPECT_EQ(1, array.find(2));
+  EXPECT_TRUE(array.contains(4));
+  EXPECT_EQ(2, array.remove(2));
+  EXPECT_FALSE(array.contains(2));
+  EXPECT_EQ(1, array.remove_if([](int item) { return item > 3; }));
+  EXPECT_EQ(2, array.size());
+  EXPECT_EQ(1, array[0]);
+  EXPECT_EQ(3, array[1]);
+}
+
+// Item whose move may throw.
+struct ThrowingMove {
+  ThrowingMove() = default;
+  ThrowingMove(ThrowingMove&&) noexcept(false) {}
+};
+
+TEST(SmallArrayTest, CopyAndMove) {
+  // Inline items are moved one by one, so moves only don't throw if moves
+  // of items don't.
+  static_assert(
+      std::is_nothrow_move_constructible<SmallArray<std::string, 2>>::value,
+      "");
+  static_assert(
+      std::is_nothrow_move_assignable<SmallArray<std::string, 2>>::value, "");
+  static_assert(
+      !std::is_nothrow_move_constructible<SmallArray<ThrowingMove, 2>>::value,
+      "");
+
+  SmallArray<std::string, 2> small({"a", "b"});
+  SmallArray<std::string, 2> large({"a", "b", "c", "d"});
+  EXPECT_TRUE(small.is_inline());
+  EXPECT_FALSE(large.is_inline());
+
+  SmallArray<std::string, 2> copy(large);
+  EXPECT_EQ(4, copy.size());
+  EXPECT_EQ("d", copy[3]);
+
+  copy = small;
+  EXPECT_EQ(2, copy.size());
+  EXPECT_TRUE(copy.is_inline());
+  EXPECT_EQ("b", copy[1]);
+
+  const std::string* large_items = large.data();
+  SmallArray<std::string, 2> moved(std::move(large));
+  EXPECT_EQ(large_items, moved.data());
+  EXPECT_TRUE(large.is_empty());
+  EXPECT_TRUE(large.is_inline());
+
+  moved = std::move(small);
+  EXPECT_TRUE(moved.is_inline());
+  EXPECT_EQ(2, moved.size());
+  EXPECT_EQ("a", moved[0]);
+  EXPECT_TRUE(small.is_empty());
+
+  moved = moved;
+  EXPECT_EQ(2, moved.size());
+}
+
+TEST(SmallArrayTest, NonTrivialItems) {
+  SmallArray<std::unique_ptr<int>, 2> pointers;
+  for (int i = 0; i < 10; ++i) {
+    pointers.append(std::make_unique<int>(i));
+  }
+  EXPECT_EQ(9, *pointers.pop());
+  EXPECT_EQ(4, *pointers[4]);
+
+  SmallArray<std::string, 2> strings({"first"});
+  for (int i = 0; i < 10; ++i) {
+    strings.append(strings[0]);
+  }
+  strings.insert(strings[1], 0);
+  EXPECT_EQ(12, strings.size());
+  EXPECT_EQ("first", strings[11]);
+
+  std::string joined;
+  for (const std::string& item : strings) {
+    joined += item[0];
+  }
+  EXPECT_EQ(std::string(12, 'f'), joined);
+}
+
+}  // namespace
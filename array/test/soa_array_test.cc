@@ -0,0 +1,140 @@
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+#include "array/simd.h"
+#include "array/soa_array.h"
+#include "gtest/gtest.h"
+
+namespace {
+using namespace td;
+
+TEST(SoaArrayTest, AppendAndAccess) {
+  SoaArray<int, std::string, double> array;
+  EXPECT_TRUE(array.is_empty());
+  EXPECT_EQ(16, array.capacity());
+
+  for (int i = 0; i < 100; ++i) {
+    array.append(i, std::to_string(i), i / 2.0);
+  }
+  EXPECT_EQ(100, array.size());
+  EXPECT_EQ(128, array.capacity());
+
+  auto [id, name, value] = array[42];
+  EXPECT_EQ(42, id);
+  EXPECT_EQ("42", name);
+  EXPECT_EQ(21.0, value);
+
+  // Rows refer to fields, so fields are changed through them.
+  std::get<1>(array[42]) = "forty-two";
+  EXPECT_EQ("forty-two", std::get<1>(array.at(42)));
+  array[43] = std::make_tuple(-1, "minus one", -1.0);
+  EXPECT_EQ(-1, std::get<0>(array[43]));
+  EXPECT_EQ("minus one", std::get<1>(array[43]));
+
+  EXPECT_THROW(array.at(100), std::out_of_range);
+}
+
+TEST(SoaArrayTest, Columns) {
+  SoaArray<std::int32_t, float> array;
+  for (int i = 0; i < 1000; ++i) {
+    array.append(i % 10, static_cast<float>(i));
+  }
+
+  array::Span<std::int32_t> ids = array.column<0>();
+  EXPECT_EQ(1000, ids.size());
+  EXPECT_EQ(100, array::count(ids.data(), ids.size(), 7));
+
+  float sum = 0;
+  for (float value : array.column<1>()) {
+    sum += value;
+  }
+  EXPECT_EQ(499500, sum);
+
+  for (std::int32_t& id : ids) {
+    id *= 2;
+  }
+  const SoaArray<std::int32_t, float>& const_array = array;
+  EXPECT_EQ(14, const_array.column<0>()[7]);
+  EXPECT_EQ(14, std::get<0>(const_array[7]));
+}
+
+TEST(SoaArrayTest, Remove) {
+  SoaArray<int, std::string> array;
+  EXPECT_THROW(array.pop(), std::out_of_range);
+  EXPECT_THROW(array.remove_at(0), std::out_of_range);
+
+  for (int i = 0; i < 10; ++i) {
+    array.append(i, std::string(20, 'a' + i));
+  }
+
+  auto [id, name] = array.pop();
+  EXPECT_EQ(9, id);
+  EXPECT_EQ(std::string(20, 'j'), name);
+
+  array.remove_at(0);
+  EXPECT_EQ(8, array.size());
+  EXPECT_EQ(1, std::get<0>(array[0]));
+  EXPECT_EQ(std::string(20, 'b'), std::get<1>(array[0]));
+
+  EXPECT_EQ(4, array.remove_if([](const auto& row) {
+    return std::get<0>(row) % 2 == 0;
+  }));
+  EXPECT_EQ(4, array.size());
+  for (std::size_t i = 0; i < array.size(); ++i) {
+    EXPECT_EQ(static_cast<int>(2 * i + 1), std::get<0>(array[i]));
+    EXPECT_EQ(std::string(20, 'b' + 2 * i), std::get<1>(array[i]));
+  }
+  EXPECT_EQ(16, array.capacity());
+}
+
+TEST(SoaArrayTest, ReserveAndShrinkToFit) {
+  SoaArray<int, char> array(4);
+  EXPECT_EQ(4, array.capacity());
+  array.reserve(100);
+  EXPECT_EQ(100, array.capacity());
+
+  array.append(1, 'a');
+  array.append(2, 'b');
+  array.shrink_to_fit();
+  EXPECT_EQ(2, array.capacity());
+  EXPECT_EQ('b', std::get<1>(array[1]));
+
+  SoaArray<int, char> copy(array);
+  SoaArray<int, char> moved(std::move(array));
+  EXPECT_EQ(2, copy.size());
+  EXPECT_EQ(2, moved.size());
+  EXPECT_EQ(2, std::get<0>(moved[1]));
+}
+
+// Field which throws when the |throwing| instance is copied.
+struct Fragile {
+  static int throwing;
+  int value;
+
+  Fragile(int v) : value(v) {}
+  Fragile(const Fragile& other) : value(other.value) {
+    if (value == throwing) {
+      throw std::runtime_error("copy failed");
+    }
+  }
+  Fragile& operator=(const Fragile& other) = default;
+};
+
+int Fragile::throwing = -1;
+
+TEST(SoaArrayTest, FailedAppendLeavesArrayUnchanged) {
+  SoaArray<std::string, Fragile> array;
+  array.append("first", Fragile(1));
+
+  Fragile fragile(2);
+  Fragile::throwing = 2;
+  EXPECT_THROW(array.append("second", fragile), std::runtime_error);
+  Fragile::throwing = -1;
+
+  EXPECT_EQ(1, array.size());
+  EXPECT_EQ(1, array.column<0>().size());
+  EXPECT_EQ("first", std::get<0>(array[0]));
+}
+
+}  // namespace
@@ -0,0 +1,101 @@
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "binary_trees/avl_tree.h"
+#include "binary_trees/bstree.h"
+#include "utils/allocator.h"
+#include "utils/bench.h"
+
+namespace {
+
+using namespace td;
+
+// Build a tree of |keys| with |insert| |rounds| times, look every key up
+// once and free the tree with |discard|.
+template <typename Insert, typename Discard>
+void bench_build_and_discard(const char* name,
+                             const std::vector<int>& keys,
+                             std::size_t rounds,
+                             Insert&& insert,
+                             Discard&& discard) {
+  double total_ns = bench::elapsed_ns([&] {
+    for (std::size_t round = 0; round < rounds; ++round) {
+      BinaryNode<int>* root = nullptr;
+      for (int key : keys) {
+        insert(&root, key);
+      }
+      std::size_t found = 0;
+      for (int key : keys) {
+        found += bstree::contain(root, key);
+      }
+      bench::do_not_optimize(found);
+      discard(&root);
+    }
+  });
+  bench::report(name, total_ns, keys.size() * rounds);
+}
+
+// Measure building and discarding binary search trees and AVL trees of
+// random keys with each allocator. Time is per node and covers allocating,
+// one lookup and freeing it. Arena trees of trivially destructible keys are
+// dropped with the arena instead of being released node by node.
+void bench_allocators(std::size_t size, std::size_t rounds) {
+  std::mt19937 random(42);
+  std::vector<int> keys(size);
+  for (int& key : keys) {
+    key = static_cast<int>(random());
+  }
+
+  using Node = BinaryNode<int>;
+  MonotonicArena arena;
+  FixedSizePool pool(sizeof(Node));
+
+  bench_build_and_discard(
+      "build and discard BST, std::allocator", keys, rounds,
+      [](Node** root, int key) { bstree::insert(root, key); },
+      [](Node** root) { binary_tree::release(root); });
+  bench_build_and_discard(
+      "build and discard BST, ArenaAllocator", keys, rounds,
+      [&](Node** root, int key) {
+        bstree::insert(root, key, ArenaAllocator<Node>(arena));
+      },
+      [&](Node**) { arena.reset(); });
+  bench_build_and_discard(
+      "build and discard BST, PoolAllocator", keys, rounds,
+      [&](Node** root, int key) {
+        bstree::insert(root, key, PoolAllocator<Node>(pool));
+      },
+      [&](Node** root) {
+        binary_tree::release(root, PoolAllocator<Node>(pool));
+      });
+
+  bench_build_and_discard(
+      "build and discard AVL tree, std::allocator", keys, rounds,
+      [](Node** root, int key) { avl_tree::insert(root, key); },
+      [](Node** root) { binary_tree::release(root); });
+  bench_build_and_discard(
+      "build and discard AVL tree, ArenaAllocator", keys, rounds,
+      [&](Node** root, int key) {
+        avl_tree::insert(root, key, ArenaAllocator<Node>(arena));
+      },
+      [&](Node**) { arena.reset(); });
+  bench_build_and_discard(
+      "build and discard AVL tree, PoolAllocator", keys, rounds,
+      [&](Node** root, int key) {
+        avl_tree::insert(root, key, PoolAllocator<Node>(pool));
+      },
+      [&](Node** root) {
+        binary_tree::release(root, PoolAllocator<Node>(pool));
+      });
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  std::size_t size = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+
+  bench_allocators(size, 3);
+  return 0;
+}
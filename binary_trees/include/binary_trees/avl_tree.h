@@ -98,25 +98,33 @@ void balance(AVLNode<DataType>** p_node) {
 
 }  // namespace detail
 
-// Insert the given data into tree whose root is given node.
-template <typename DataType>
-void insert(AVLNode<DataType>** p_node, const DataType& data) {
+// Insert the given data into tree whose root is given node. The new node is
+// allocated by |allocator|.
+template <typename DataType,
+          typename Allocator = std::allocator<AVLNode<DataType>>>
+void insert(AVLNode<DataType>** p_node,
+            const DataType& data,
+            Allocator allocator = Allocator()) {
   AVLNode<DataType>* node = *p_node;
 
   if (!node) {
-    *p_node = new AVLNode<DataType>(data);
+    *p_node = binary_tree::create_node(data, allocator);
     return;
   }
 
-  insert(data < node->data ? &node->left : &node->right, data);
+  insert(data < node->data ? &node->left : &node->right, data, allocator);
 
   detail::update_height(node);
   detail::balance(p_node);
 }
 
-// Remove the given data from tree whose root is given node.
-template <typename DataType>
-void remove(AVLNode<DataType>** p_node, const DataType& data) {
+// Remove the given data from tree whose root is given node. The node is
+// freed by |allocator|.
+template <typename DataType,
+          typename Allocator = std::allocator<AVLNode<DataType>>>
+void remove(AVLNode<DataType>** p_node,
+            const DataType& data,
+            Allocator allocator = Allocator()) {
   AVLNode<DataType>* node = *p_node;
 
   if (!node) {
@@ -124,17 +132,17 @@ void remove(AVLNode<DataType>** p_node, const DataType& data) {
   }
 
   if (node->data != data) {
-    remove(data < node->data ? &node->left : &node->right, data);
+    remove(data < node->data ? &node->left : &node->right, data, allocator);
   } else {
     if (node->left && node->right) {
       AVLNode<DataType>* right_child_min_node =
           bstree::detail::min_node(node->right);
       node->data = right_child_min_node->data;
       right_child_min_node->data = data;
-      remove(&node->right, data);
+      remove(&node->right, data, allocator);
     } else {
       *p_node = node->left ?: node->right;
-      delete node;
+      binary_tree::destroy_node(node, allocator);
       node = *p_node;
     }
   }
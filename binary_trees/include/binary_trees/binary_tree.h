@@ -1,5 +1,6 @@
 #pragma once
 
+#include <memory>
 #include <vector>
 #include <queue>
 
@@ -105,16 +106,49 @@ std::size_t node_count(BinaryNode<DataType>* node) {
   return node_count(node->left) + node_count(node->right) + 1;
 }
 
+// Node allocator of trees, which is |Allocator| rebound to nodes. Functions
+// which add or remove nodes take a standard allocator, |std::allocator| by
+// default, and nodes must be removed and released with the allocator they
+// were created with.
+template <typename DataType, typename Allocator>
+using NodeAllocator = typename std::allocator_traits<
+    Allocator>::template rebind_alloc<BinaryNode<DataType>>;
+
+// Return a new node with given data, allocated by |allocator|.
+template <typename DataType, typename Allocator>
+BinaryNode<DataType>* create_node(const DataType& data, Allocator allocator) {
+  using Traits = std::allocator_traits<NodeAllocator<DataType, Allocator>>;
+  NodeAllocator<DataType, Allocator> node_allocator(allocator);
+  BinaryNode<DataType>* node = Traits::allocate(node_allocator, 1);
+  try {
+    Traits::construct(node_allocator, node, data);
+  } catch (...) {
+    Traits::deallocate(node_allocator, node, 1);
+    throw;
+  }
+  return node;
+}
+
+// Destroy given node and free it by |allocator|.
+template <typename DataType, typename Allocator>
+void destroy_node(BinaryNode<DataType>* node, Allocator allocator) {
+  using Traits = std::allocator_traits<NodeAllocator<DataType, Allocator>>;
+  NodeAllocator<DataType, Allocator> node_allocator(allocator);
+  Traits::destroy(node_allocator, node);
+  Traits::deallocate(node_allocator, node, 1);
+}
+
 // Release nodes in tree whose root node is given node.
-template <typename DataType>
-void release(BinaryNode<DataType>** node) {
+template <typename DataType,
+          typename Allocator = std::allocator<BinaryNode<DataType>>>
+void release(BinaryNode<DataType>** node, Allocator allocator = Allocator()) {
   if (!*node)
     return;
 
-  release(&(*node)->left);
-  release(&(*node)->right);
+  release(&(*node)->left, allocator);
+  release(&(*node)->right, allocator);
 
-  delete *node;
+  destroy_node(*node, allocator);
   *node = nullptr;
 }
 
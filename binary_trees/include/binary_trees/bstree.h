@@ -1,5 +1,7 @@
 #pragma once
 
+#include <stdexcept>
+
 #include "binary_tree.h"
 
 namespace td {
@@ -115,26 +117,32 @@ bool contain(BinaryNode<DataType>* node, const DataType& data) {
   return detail::node_with_data(node, data) != nullptr;
 }
 
-// Insert the given data into tree whose root is given node.
-template <typename DataType>
-void insert(BinaryNode<DataType>** p_node, const DataType& data) {
-  BinaryNode<DataType>* new_node = new BinaryNode<DataType>(data);
-
+// Insert the given data into tree whose root is given node. The new node is
+// allocated by |allocator|.
+template <typename DataType,
+          typename Allocator = std::allocator<BinaryNode<DataType>>>
+void insert(BinaryNode<DataType>** p_node,
+            const DataType& data,
+            Allocator allocator = Allocator()) {
   if (!*p_node) {
-    *p_node = new_node;
+    *p_node = binary_tree::create_node(data, allocator);
     return;
   }
 
   if (data < (*p_node)->data) {
-    insert(&(*p_node)->left, data);
+    insert(&(*p_node)->left, data, allocator);
   } else {
-    insert(&(*p_node)->right, data);
+    insert(&(*p_node)->right, data, allocator);
   }
 }
 
-// Remove the given data from tree whose root is given node.
-template <typename DataType>
-void remove(BinaryNode<DataType>** p_node, const DataType& data) {
+// Remove the given data from tree whose root is given node. The node is
+// freed by |allocator|.
+template <typename DataType,
+          typename Allocator = std::allocator<BinaryNode<DataType>>>
+void remove(BinaryNode<DataType>** p_node,
+            const DataType& data,
+            Allocator allocator = Allocator()) {
   BinaryNode<DataType>* node = *p_node;
 
   if (!node) {
@@ -142,7 +150,7 @@ void remove(BinaryNode<DataType>** p_node, const DataType& data) {
   }
 
   if (node->data != data) {
-    remove(data < node->data ? &node->left : &node->right, data);
+    remove(data < node->data ? &node->left : &node->right, data, allocator);
     return;
   }
 
@@ -150,10 +158,10 @@ void remove(BinaryNode<DataType>** p_node, const DataType& data) {
     BinaryNode<DataType>* right_child_min_node = detail::min_node(node->right);
     node->data = right_child_min_node->data;
     right_child_min_node->data = data;
-    remove(&node->right, data);
+    remove(&node->right, data, allocator);
   } else {
     *p_node = node->right ?: node->left;
-    delete node;
+    binary_tree::destroy_node(node, allocator);
   }
 }
 
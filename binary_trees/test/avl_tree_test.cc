@@ -1,5 +1,6 @@
 #include "binary_trees/avl_tree.h"
 #include "gtest/gtest.h"
+#include "utils/allocator.h"
 
 namespace {
 using namespace td;
@@ -176,4 +177,29 @@ TEST(AVLTreeTest, Remove) {
             levelorder_traversal(root));
 }
 
+TEST(AVLTreeTest, Allocators) {
+  FixedSizePool pool(sizeof(AVLNode<int>));
+  PoolAllocator<int> pool_allocator(pool);
+  AVLNode<int>* root = nullptr;
+
+  for (int i = 0; i < 1000; ++i) {
+    insert(&root, i, pool_allocator);
+  }
+  for (int i = 0; i < 1000; i += 2) {
+    remove(&root, i, pool_allocator);
+  }
+  EXPECT_TRUE(is_bstree(root));
+  EXPECT_EQ(500, node_count(root));
+  EXPECT_GE(9, height(root));
+  release(&root, pool_allocator);
+
+  // Nodes in an arena are freed with it, without releasing the tree.
+  MonotonicArena arena;
+  for (int i = 0; i < 1000; ++i) {
+    insert(&root, i, ArenaAllocator<int>(arena));
+  }
+  EXPECT_EQ(1000, node_count(root));
+  EXPECT_EQ(1000 * sizeof(AVLNode<int>), arena.bytes_allocated());
+}
+
 }  // namespace
@@ -1,5 +1,6 @@
 #include "binary_trees/bstree.h"
 #include "gtest/gtest.h"
+#include "utils/allocator.h"
 
 namespace {
 using namespace td;
@@ -247,4 +248,25 @@ TEST(BSTreeTest, DataInRange) {
   release(&root);
 }
 
+TEST(BSTreeTest, Allocators) {
+  FixedSizePool pool(sizeof(BinaryNode<int>));
+  PoolAllocator<BinaryNode<int>> pool_allocator(pool);
+  BinaryNode<int>* root = nullptr;
+
+  for (int i : {50, 30, 70, 20, 40, 60, 80}) {
+    insert(&root, i, pool_allocator);
+  }
+  remove(&root, 30, pool_allocator);
+  remove(&root, 70, pool_allocator);
+  EXPECT_EQ(std::vector<int>({20, 40, 50, 60, 80}), inorder_traversal(root));
+
+  // Removed nodes are reused.
+  BinaryNode<int>* block = static_cast<BinaryNode<int>*>(pool.allocate());
+  pool.deallocate(block);
+  insert(&root, 90, pool_allocator);
+  EXPECT_EQ(block, bstree::detail::node_with_data(root, 90));
+
+  release(&root, pool_allocator);
+}
+
 }  // namespace td
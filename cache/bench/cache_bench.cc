@@ -0,0 +1,96 @@
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "cache/clock_cache.h"
+#include "cache/lru_cache.h"
+#include "utils/bench.h"
+
+namespace {
+
+using namespace td;
+
+// Return |length| keys out of |key_count| drawn with Zipf distribution, key
+// of rank i is drawn with weight 1 / i^|skew|.
+std::vector<std::uint64_t> make_zipf_trace(std::size_t length,
+                                           std::size_t key_count,
+                                           double skew) {
+  std::vector<double> weights(key_count);
+  for (std::size_t i = 0; i < key_count; ++i)
+    weights[i] = 1.0 / std::pow(static_cast<double>(i + 1), skew);
+
+  std::mt19937_64 random(42);
+  std::discrete_distribution<std::uint64_t> distribution(weights.begin(),
+                                                         weights.end());
+  std::vector<std::uint64_t> trace(length);
+  for (std::uint64_t& key : trace)
+    key = distribution(random);
+  return trace;
+}
+
+// Read a trace with one key per line, keys are numbered in order of first
+// appearance. Return number of distinct keys.
+std::size_t read_trace(const char* path, std::vector<std::uint64_t>& trace) {
+  std::ifstream file(path);
+  if (!file) {
+    std::fprintf(stderr, "can't open %s\n", path);
+    std::exit(1);
+  }
+
+  HashTable<std::string, std::uint64_t> ids;
+  std::string line;
+  while (std::getline(file, line)) {
+    std::uint64_t id = ids.size();
+    trace.push_back(*ids.try_emplace(line, id).first);
+  }
+  return ids.size();
+}
+
+// Replay |trace| through a cache of |capacity| entries, putting every key
+// which misses, and report hit ratio and throughput.
+template <typename Cache>
+void replay(const std::vector<std::uint64_t>& trace,
+            std::size_t capacity,
+            const char* cache_name) {
+  Cache cache(capacity);
+  double ns = bench::elapsed_ns([&] {
+    for (std::uint64_t key : trace) {
+      std::uint64_t* value = cache.get(key);
+      if (value)
+        bench::do_not_optimize(*value);
+      else
+        cache.put(key, key);
+    }
+  });
+
+  char name[64];
+  std::snprintf(name, sizeof(name), "%-5s %9zu entries, hit ratio %.4f",
+                cache_name, capacity, cache.stats().hit_ratio());
+  bench::report(name, ns, trace.size());
+}
+
+}  // namespace
+
+// Usage: cache_bench [trace file]
+// Without a trace file, a Zipf trace of 10M lookups over 1M keys is replayed.
+int main(int argc, char** argv) {
+  std::vector<std::uint64_t> trace;
+  std::size_t key_count = 1000000;
+  if (argc > 1)
+    key_count = read_trace(argv[1], trace);
+  else
+    trace = make_zipf_trace(10000000, key_count, 0.99);
+
+  for (double share : {0.001, 0.01, 0.1}) {
+    std::size_t capacity = std::max<std::size_t>(1, key_count * share);
+    replay<LruCache<std::uint64_t, std::uint64_t>>(trace, capacity, "lru");
+    replay<ClockCache<std::uint64_t, std::uint64_t>>(trace, capacity,
+                                                     "clock");
+  }
+  return 0;
+}
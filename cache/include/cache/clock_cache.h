@@ -0,0 +1,278 @@
+#pragma once
+
+#include <functional>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "cache/stats.h"
+#include "hash_table/hash_table.h"
+#include "utils/macros.h"
+#include "utils/utils.h"
+
+namespace td {
+
+// A cache with the same interface as |LruCache| which approximates LRU with
+// the CLOCK algorithm. Entries live in a ring of slots, each with a
+// referenced bit. A hit only sets the bit, so it doesn't touch any list, and
+// entries need no allocation of their own. To evict, a hand sweeps the ring,
+// clearing set bits and evicting the first entry whose bit is clear.
+template <typename KeyType,
+          typename ValueType,
+          typename HashType = Hash<KeyType>,
+          typename EqualType = std::equal_to<>>
+class ClockCache {
+  // Type of key accepted by lookups, see |HashTable|.
+  template <typename K>
+  using key_arg = typename hash_table::KeyArg<
+      hash_table::is_transparent<HashType>::value &&
+      hash_table::is_transparent<EqualType>::value>::template type<K, KeyType>;
+
+ public:
+  // Cache holds entries whose charges add up to at most |capacity|.
+  explicit ClockCache(std::size_t capacity);
+
+  // Return pointer to value at given key and mark it referenced, or nullptr
+  // if key isn't cached. The pointer is valid until next |put| or |erase|.
+  template <typename K = KeyType>
+  ValueType* get(const key_arg<K>& key);
+
+  // Add the given key and value, replacing old value if key exists.
+  // Unreferenced entries are evicted until total charge fits in capacity, an
+  // entry whose charge alone exceeds it is not kept.
+  void put(const KeyType& key, ValueType value, std::size_t charge = 1);
+
+  // Removes entry at given key. Return true if key was cached.
+  template <typename K = KeyType>
+  bool erase(const key_arg<K>& key);
+
+  // Return number of entries are currently cached.
+  std::size_t size() const;
+
+  // Return total charge of cached entries.
+  std::size_t charge() const;
+
+  // Return maximum total charge.
+  std::size_t capacity() const;
+
+  // Return hit, miss and eviction counters.
+  const cache::Stats& stats() const;
+
+ private:
+  struct Entry {
+    KeyType key;
+    ValueType value;
+  };
+
+  // A place in the ring, empty if |entry| is.
+  struct Slot {
+    std::optional<Entry> entry;
+    std::size_t charge{0};
+    bool referenced{false};
+  };
+
+  // Empty slot at |index| and make it reusable.
+  void clear_slot(std::size_t index);
+
+  // Sweep the ring and evict entries until |charge| more fits in capacity.
+  // Slot at |kept| is never evicted.
+  void evict(std::size_t charge, std::size_t kept = index_not_found);
+
+  // Index of slot of every entry by key.
+  HashTable<KeyType, std::size_t, HashType, EqualType> slot_indices_;
+
+  // Ring of slots, the hand wraps around at its end.
+  std::vector<Slot> slots_;
+
+  // Indices of empty slots of |slots_|.
+  std::vector<std::size_t> free_slots_;
+
+  // Index of next slot the hand visits.
+  std::size_t hand_{0};
+
+  std::size_t capacity_;
+  std::size_t charge_{0};
+  cache::Stats stats_;
+
+  DISALLOW_COPY_AND_ASSIGN(ClockCache);
+};
+
+}  // namespace td
+
+/****************  Clock cache implementation ****************/
+namespace td {
+
+// Public
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType>
+ClockCache<KeyType, ValueType, HashType, EqualType>::ClockCache(
+    std::size_t capacity)
+    : capacity_(capacity) {}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType>
+template <typename K>
+ValueType* ClockCache<KeyType, ValueType, HashType, EqualType>::get(
+    const key_arg<K>& key) {
+  std::size_t* index = slot_indices_.template find<K>(key);
+  if (!index) {
+    ++stats_.misses;
+    return nullptr;
+  }
+
+  ++stats_.hits;
+  Slot& slot = slots_[*index];
+  slot.referenced = true;
+  return &slot.entry->value;
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType>
+void ClockCache<KeyType, ValueType, HashType, EqualType>::put(
+    const KeyType& key,
+    ValueType value,
+    std::size_t charge) {
+  if (charge > capacity_) {
+    erase(key);
+    return;
+  }
+
+  std::size_t* index = slot_indices_.find(key);
+  if (index) {
+    // Index is copied, as evicting other entries may move it in the table.
+    std::size_t kept = *index;
+    Slot& slot = slots_[kept];
+    slot.entry->value = std::move(value);
+    charge_ -= slot.charge;
+    slot.charge = charge;
+    slot.referenced = true;
+    charge_ += charge;
+    evict(0, kept);
+    return;
+  }
+
+  evict(charge);
+
+  bool appended = free_slots_.empty();
+  std::size_t new_index = appended ? slots_.size() : free_slots_.back();
+  if (appended)
+    slots_.emplace_back();
+
+  // Slot is only taken once entry is made and indexed, so neither leaves a
+  // lost slot or an unindexed entry behind if it throws.
+  Slot& slot = slots_[new_index];
+  try {
+    slot.entry.emplace(Entry{key, std::move(value)});
+    slot_indices_.set(key, new_index);
+  } catch (...) {
+    slot.entry.reset();
+    if (appended)
+      slots_.pop_back();
+    throw;
+  }
+  if (!appended)
+    free_slots_.pop_back();
+
+  // A new entry must be hit once to survive a sweep.
+  slot.charge = charge;
+  slot.referenced = false;
+  charge_ += charge;
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType>
+template <typename K>
+bool ClockCache<KeyType, ValueType, HashType, EqualType>::erase(
+    const key_arg<K>& key) {
+  std::size_t* index = slot_indices_.template find<K>(key);
+  if (!index)
+    return false;
+
+  clear_slot(*index);
+  return true;
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType>
+std::size_t ClockCache<KeyType, ValueType, HashType, EqualType>::size()
+    const {
+  return slot_indices_.size();
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType>
+std::size_t ClockCache<KeyType, ValueType, HashType, EqualType>::charge()
+    const {
+  return charge_;
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType>
+std::size_t ClockCache<KeyType, ValueType, HashType, EqualType>::capacity()
+    const {
+  return capacity_;
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType>
+const cache::Stats&
+ClockCache<KeyType, ValueType, HashType, EqualType>::stats() const {
+  return stats_;
+}
+
+// Private
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType>
+void ClockCache<KeyType, ValueType, HashType, EqualType>::clear_slot(
+    std::size_t index) {
+  Slot& slot = slots_[index];
+  slot_indices_.erase(slot.entry->key);
+  slot.entry.reset();
+  charge_ -= slot.charge;
+  free_slots_.push_back(index);
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType>
+void ClockCache<KeyType, ValueType, HashType, EqualType>::evict(
+    std::size_t charge,
+    std::size_t kept) {
+  // Every sweep clears all referenced bits, so this ends within two sweeps.
+  // Charge of |kept| alone fits, so it's never the only one left to evict.
+  while (charge_ + charge > capacity_) {
+    Slot& slot = slots_[hand_];
+    if (slot.entry && hand_ != kept) {
+      if (slot.referenced) {
+        slot.referenced = false;
+      } else {
+        clear_slot(hand_);
+        ++stats_.evictions;
+      }
+    }
+    hand_ = hand_ + 1 < slots_.size() ? hand_ + 1 : 0;
+  }
+}
+
+}  // namespace td
@@ -0,0 +1,282 @@
+#pragma once
+
+#include <functional>
+#include <utility>
+
+#include "cache/stats.h"
+#include "hash_table/hash_table.h"
+#include "utils/macros.h"
+
+namespace td {
+
+// A cache which keeps entries up to a total charge, evicting the least
+// recently used ones first. Every entry has a charge given on |put|: 1 for
+// an entry budget, or its size in bytes for a byte budget.
+//
+// Entries are linked in a recency list and found through a |HashTable| of
+// pointers to them, so get, put and eviction are O(1).
+template <typename KeyType,
+          typename ValueType,
+          typename HashType = Hash<KeyType>,
+          typename EqualType = std::equal_to<>>
+class LruCache {
+  // Type of key accepted by lookups, see |HashTable|.
+  template <typename K>
+  using key_arg = typename hash_table::KeyArg<
+      hash_table::is_transparent<HashType>::value &&
+      hash_table::is_transparent<EqualType>::value>::template type<K, KeyType>;
+
+ public:
+  // Cache holds entries whose charges add up to at most |capacity|.
+  explicit LruCache(std::size_t capacity);
+  ~LruCache();
+
+  // Return pointer to value at given key and mark it most recently used, or
+  // nullptr if key isn't cached. The pointer is valid until next |put| or
+  // |erase|.
+  template <typename K = KeyType>
+  ValueType* get(const key_arg<K>& key);
+
+  // Add the given key and value as most recently used entry, replacing old
+  // value if key exists. Least recently used entries are evicted until total
+  // charge fits in capacity, an entry whose charge alone exceeds it is not
+  // kept.
+  void put(const KeyType& key, ValueType value, std::size_t charge = 1);
+
+  // Removes entry at given key. Return true if key was cached.
+  template <typename K = KeyType>
+  bool erase(const key_arg<K>& key);
+
+  // Return number of entries are currently cached.
+  std::size_t size() const;
+
+  // Return total charge of cached entries.
+  std::size_t charge() const;
+
+  // Return maximum total charge.
+  std::size_t capacity() const;
+
+  // Return hit, miss and eviction counters.
+  const cache::Stats& stats() const;
+
+ private:
+  // Links of recency list.
+  struct Link {
+    Link* previous;
+    Link* next;
+  };
+
+  // A cached entry.
+  struct Entry : Link {
+    KeyType key;
+    ValueType value;
+    std::size_t charge;
+
+    Entry(const KeyType& k, ValueType&& v, std::size_t c)
+        : Link{nullptr, nullptr}, key(k), value(std::move(v)), charge(c) {}
+  };
+
+  // Remove |link| from recency list.
+  static void unlink(Link* link);
+
+  // Link |link| right after head, as most recently used.
+  void link_front(Link* link);
+
+  // Remove |entry| from table and recency list and free it.
+  void remove_entry(Entry* entry);
+
+  // Evict least recently used entries until total charge is at most
+  // |capacity_|.
+  void evict();
+
+  // Entries by key.
+  HashTable<KeyType, Entry*, HashType, EqualType> entries_;
+
+  // Sentinel of circular recency list. |head_.next| is most recently used,
+  // |head_.previous| is least recently used.
+  Link head_;
+
+  std::size_t capacity_;
+  std::size_t charge_{0};
+  cache::Stats stats_;
+
+  DISALLOW_COPY_AND_ASSIGN(LruCache);
+};
+
+}  // namespace td
+
+/****************  LRU cache implementation ****************/
+namespace td {
+
+// Public
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType>
+LruCache<KeyType, ValueType, HashType, EqualType>::LruCache(
+    std::size_t capacity)
+    : head_{&head_, &head_}, capacity_(capacity) {}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType>
+LruCache<KeyType, ValueType, HashType, EqualType>::~LruCache() {
+  for (Link* link = head_.next; link != &head_;) {
+    Link* next = link->next;
+    delete static_cast<Entry*>(link);
+    link = next;
+  }
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType>
+template <typename K>
+ValueType* LruCache<KeyType, ValueType, HashType, EqualType>::get(
+    const key_arg<K>& key) {
+  Entry** entry = entries_.template find<K>(key);
+  if (!entry) {
+    ++stats_.misses;
+    return nullptr;
+  }
+
+  ++stats_.hits;
+  unlink(*entry);
+  link_front(*entry);
+  return &(*entry)->value;
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType>
+void LruCache<KeyType, ValueType, HashType, EqualType>::put(
+    const KeyType& key,
+    ValueType value,
+    std::size_t charge) {
+  if (charge > capacity_) {
+    erase(key);
+    return;
+  }
+
+  std::pair<Entry**, bool> result = entries_.try_emplace(key, nullptr);
+  if (result.second) {
+    // Don't leave |key| mapped to nullptr if entry can't be made.
+    try {
+      *result.first = new Entry(key, std::move(value), charge);
+    } catch (...) {
+      entries_.erase(key);
+      throw;
+    }
+  } else {
+    Entry* entry = *result.first;
+    entry->value = std::move(value);
+    charge_ -= entry->charge;
+    entry->charge = charge;
+    unlink(entry);
+  }
+
+  link_front(*result.first);
+  charge_ += charge;
+  evict();
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType>
+template <typename K>
+bool LruCache<KeyType, ValueType, HashType, EqualType>::erase(
+    const key_arg<K>& key) {
+  Entry** entry = entries_.template find<K>(key);
+  if (!entry)
+    return false;
+
+  remove_entry(*entry);
+  return true;
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType>
+std::size_t LruCache<KeyType, ValueType, HashType, EqualType>::size() const {
+  return entries_.size();
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType>
+std::size_t LruCache<KeyType, ValueType, HashType, EqualType>::charge() const {
+  return charge_;
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType>
+std::size_t LruCache<KeyType, ValueType, HashType, EqualType>::capacity()
+    const {
+  return capacity_;
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType>
+const cache::Stats& LruCache<KeyType, ValueType, HashType, EqualType>::stats()
+    const {
+  return stats_;
+}
+
+// Private
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType>
+void LruCache<KeyType, ValueType, HashType, EqualType>::unlink(Link* link) {
+  link->previous->next = link->next;
+  link->next->previous = link->previous;
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType>
+void LruCache<KeyType, ValueType, HashType, EqualType>::link_front(
+    Link* link) {
+  link->previous = &head_;
+  link->next = head_.next;
+  head_.next->previous = link;
+  head_.next = link;
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType>
+void LruCache<KeyType, ValueType, HashType, EqualType>::remove_entry(
+    Entry* entry) {
+  unlink(entry);
+  charge_ -= entry->charge;
+  entries_.erase(entry->key);
+  delete entry;
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType>
+void LruCache<KeyType, ValueType, HashType, EqualType>::evict() {
+  while (charge_ > capacity_) {
+    remove_entry(static_cast<Entry*>(head_.previous));
+    ++stats_.evictions;
+  }
+}
+
+}  // namespace td
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+
+namespace td {
+namespace cache {
+
+// Counters of a cache since it was created.
+struct Stats {
+  // Lookups which found their key.
+  std::size_t hits{0};
+
+  // Lookups which didn't find their key.
+  std::size_t misses{0};
+
+  // Entries removed to keep cache within its capacity.
+  std::size_t evictions{0};
+
+  // Return share of lookups which hit, 0 if there were none.
+  double hit_ratio() const {
+    std::size_t lookups = hits + misses;
+    return lookups ? static_cast<double>(hits) / lookups : 0.0;
+  }
+};
+
+}  // namespace cache
+}  // namespace td
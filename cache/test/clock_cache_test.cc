@@ -0,0 +1,226 @@
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "cache/clock_cache.h"
+#include "gtest/gtest.h"
+
+namespace {
+using namespace td;
+
+TEST(ClockCacheTest, PutGet) {
+  ClockCache<std::string, int> cache(3);
+  cache.put("1", 1);
+  cache.put("2", 2);
+
+  ASSERT_NE(nullptr, cache.get("1"));
+  EXPECT_EQ(1, *cache.get("1"));
+  EXPECT_EQ(2, *cache.get("2"));
+  EXPECT_EQ(nullptr, cache.get("3"));
+  EXPECT_EQ(2, cache.size());
+
+  cache.put("1", 11);
+  EXPECT_EQ(11, *cache.get("1"));
+  EXPECT_EQ(2, cache.size());
+}
+
+TEST(ClockCacheTest, SecondChance) {
+  ClockCache<int, int> cache(3);
+  cache.put(1, 1);
+  cache.put(2, 2);
+  cache.put(3, 3);
+
+  // 1 is referenced, so hand passes it and evicts 2, then 3.
+  cache.get(1);
+  cache.put(4, 4);
+  cache.put(5, 5);
+  EXPECT_EQ(3, cache.size());
+  EXPECT_EQ(2, cache.stats().evictions);
+  EXPECT_EQ(nullptr, cache.get(2));
+  EXPECT_EQ(nullptr, cache.get(3));
+  EXPECT_EQ(1, *cache.get(1));
+  EXPECT_EQ(4, *cache.get(4));
+  EXPECT_EQ(5, *cache.get(5));
+}
+
+TEST(ClockCacheTest, HotKeysSurvive) {
+  ClockCache<int, int> cache(10);
+  for (int i = 0; i < 1000; ++i) {
+    for (int hot = 0; hot < 5; ++hot) {
+      if (!cache.get(hot))
+        cache.put(hot, hot);
+    }
+    cache.put(100 + i, i);
+  }
+
+  EXPECT_EQ(10, cache.size());
+  for (int hot = 0; hot < 5; ++hot)
+    EXPECT_NE(nullptr, cache.get(hot));
+}
+
+TEST(ClockCacheTest, ByteBudget) {
+  ClockCache<int, std::string> cache(10);
+  cache.put(1, "aaaa", 4);
+  cache.put(2, "bbbb", 4);
+  EXPECT_EQ(8, cache.charge());
+
+  // 1 must go to fit 4 more bytes.
+  cache.put(3, "cccc", 4);
+  EXPECT_EQ(nullptr, cache.get(1));
+  EXPECT_EQ(8, cache.charge());
+
+  // Growing an entry evicts others.
+  cache.put(3, "cccccccc", 8);
+  EXPECT_EQ(nullptr, cache.get(2));
+  EXPECT_EQ("cccccccc", *cache.get(3));
+  EXPECT_EQ(8, cache.charge());
+
+  // An entry larger than whole cache is not kept, nor its old value.
+  cache.put(3, "ccccccccccc", 11);
+  EXPECT_EQ(nullptr, cache.get(3));
+  EXPECT_EQ(0, cache.size());
+  EXPECT_EQ(0, cache.charge());
+}
+
+TEST(ClockCacheTest, GrowingEntryIsKept) {
+  ClockCache<int, int> cache(3);
+  cache.put(1, 1);
+  cache.put(2, 2);
+  cache.put(3, 3);
+  cache.get(2);
+  cache.get(3);
+
+  // Sweep clears every referenced bit, then comes back to 1, which must not
+  // be evicted for its own growth.
+  cache.put(1, 11, 2);
+  ASSERT_NE(nullptr, cache.get(1));
+  EXPECT_EQ(11, *cache.get(1));
+  EXPECT_EQ(2, cache.size());
+  EXPECT_EQ(3, cache.charge());
+  EXPECT_EQ(1, cache.stats().evictions);
+}
+
+TEST(ClockCacheTest, Stats) {
+  ClockCache<int, int> cache(2);
+  cache.put(1, 1);
+  cache.put(2, 2);
+  cache.put(3, 3);
+  cache.get(1);
+  cache.get(2);
+  cache.get(3);
+
+  EXPECT_EQ(2, cache.stats().hits);
+  EXPECT_EQ(1, cache.stats().misses);
+  EXPECT_EQ(1, cache.stats().evictions);
+  EXPECT_DOUBLE_EQ(2.0 / 3, cache.stats().hit_ratio());
+}
+
+TEST(ClockCacheTest, Erase) {
+  ClockCache<int, int> cache(2);
+  cache.put(1, 1);
+  cache.put(2, 2);
+
+  EXPECT_TRUE(cache.erase(1));
+  EXPECT_FALSE(cache.erase(1));
+  EXPECT_EQ(nullptr, cache.get(1));
+  EXPECT_EQ(1, cache.size());
+  EXPECT_EQ(1, cache.charge());
+
+  // Slot of erased entry is reused.
+  cache.put(3, 3);
+  EXPECT_EQ(2, cache.size());
+  EXPECT_EQ(0, cache.stats().evictions);
+  EXPECT_EQ(3, *cache.get(3));
+}
+
+// Value whose copy throws if |fails| is set.
+struct Fragile {
+  bool fails;
+
+  explicit Fragile(bool f) : fails(f) {}
+  Fragile(const Fragile& other) : fails(other.fails) {
+    if (fails)
+      throw std::runtime_error("copy failed");
+  }
+  Fragile& operator=(const Fragile& other) = default;
+};
+
+TEST(ClockCacheTest, PutThatThrows) {
+  ClockCache<int, Fragile> cache(2);
+  EXPECT_THROW(cache.put(1, Fragile(true)), std::runtime_error);
+  EXPECT_EQ(0, cache.size());
+  EXPECT_EQ(nullptr, cache.get(1));
+  EXPECT_FALSE(cache.erase(1));
+
+  // A failed put into a freed slot leaves it free.
+  cache.put(1, Fragile(false));
+  cache.put(2, Fragile(false));
+  EXPECT_TRUE(cache.erase(1));
+  EXPECT_THROW(cache.put(3, Fragile(true)), std::runtime_error);
+  EXPECT_EQ(1, cache.size());
+  EXPECT_EQ(nullptr, cache.get(3));
+
+  cache.put(1, Fragile(false));
+  EXPECT_EQ(2, cache.size());
+  EXPECT_NE(nullptr, cache.get(1));
+  EXPECT_NE(nullptr, cache.get(2));
+}
+
+// Hash of ints which throws once |calls_left| calls are used up.
+struct FailingHash {
+  static int calls_left;
+
+  std::size_t operator()(int key) const {
+    if (calls_left-- == 0)
+      throw std::runtime_error("hash failed");
+    return Hash<int>()(key);
+  }
+};
+
+int FailingHash::calls_left = -1;
+
+TEST(ClockCacheTest, IndexThatThrows) {
+  ClockCache<int, int, FailingHash> cache(4);
+  cache.put(1, 1);
+  cache.put(2, 2);
+
+  // Lookup of key succeeds, adding it to the index throws.
+  FailingHash::calls_left = 1;
+  EXPECT_THROW(cache.put(3, 3), std::runtime_error);
+  FailingHash::calls_left = -1;
+  EXPECT_EQ(2, cache.size());
+  EXPECT_EQ(2, cache.charge());
+  EXPECT_EQ(nullptr, cache.get(3));
+
+  // No entry outside the index is left for sweeps to evict.
+  for (int i = 0; i < 100; ++i) {
+    cache.put(i, i);
+    EXPECT_EQ(cache.size(), cache.charge());
+  }
+  EXPECT_EQ(4, cache.size());
+}
+
+TEST(ClockCacheTest, HeterogeneousLookup) {
+  ClockCache<std::string, int> cache(2);
+  cache.put("1", 1);
+
+  std::string_view key = "1";
+  EXPECT_EQ(1, *cache.get<std::string_view>(key));
+  EXPECT_TRUE(cache.erase<std::string_view>(key));
+}
+
+TEST(ClockCacheTest, ManyKeys) {
+  ClockCache<int, int> cache(100);
+  for (int i = 0; i < 10000; ++i) {
+    cache.put(i, i);
+    if (i >= 10)
+      cache.get(i - 10);
+  }
+
+  EXPECT_EQ(100, cache.size());
+  EXPECT_EQ(100, cache.charge());
+  EXPECT_EQ(9900, cache.stats().evictions);
+  EXPECT_EQ(9999, *cache.get(9999));
+}
+
+}  // namespace
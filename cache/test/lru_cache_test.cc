@@ -0,0 +1,153 @@
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "cache/lru_cache.h"
+#include "gtest/gtest.h"
+
+namespace {
+using namespace td;
+
+TEST(LruCacheTest, PutGet) {
+  LruCache<std::string, int> cache(3);
+  cache.put("1", 1);
+  cache.put("2", 2);
+
+  ASSERT_NE(nullptr, cache.get("1"));
+  EXPECT_EQ(1, *cache.get("1"));
+  EXPECT_EQ(2, *cache.get("2"));
+  EXPECT_EQ(nullptr, cache.get("3"));
+  EXPECT_EQ(2, cache.size());
+
+  cache.put("1", 11);
+  EXPECT_EQ(11, *cache.get("1"));
+  EXPECT_EQ(2, cache.size());
+}
+
+TEST(LruCacheTest, EvictLeastRecentlyUsed) {
+  LruCache<int, int> cache(3);
+  cache.put(1, 1);
+  cache.put(2, 2);
+  cache.put(3, 3);
+
+  // 1 is used again, so 2 is least recently used.
+  cache.get(1);
+  cache.put(4, 4);
+  EXPECT_EQ(nullptr, cache.get(2));
+  EXPECT_NE(nullptr, cache.get(1));
+  EXPECT_NE(nullptr, cache.get(3));
+  EXPECT_NE(nullptr, cache.get(4));
+
+  // Replacing a value makes it most recently used too.
+  cache.put(1, 11);
+  cache.put(5, 5);
+  EXPECT_EQ(nullptr, cache.get(3));
+  EXPECT_EQ(11, *cache.get(1));
+  EXPECT_EQ(3, cache.size());
+}
+
+TEST(LruCacheTest, ByteBudget) {
+  LruCache<int, std::string> cache(10);
+  cache.put(1, "aaaa", 4);
+  cache.put(2, "bbbb", 4);
+  EXPECT_EQ(8, cache.charge());
+
+  // 1 must go to fit 4 more bytes.
+  cache.put(3, "cccc", 4);
+  EXPECT_EQ(nullptr, cache.get(1));
+  EXPECT_EQ(8, cache.charge());
+
+  // Growing an entry evicts others.
+  cache.put(3, "cccccccc", 8);
+  EXPECT_EQ(nullptr, cache.get(2));
+  EXPECT_EQ("cccccccc", *cache.get(3));
+  EXPECT_EQ(8, cache.charge());
+
+  // An entry larger than whole cache is not kept, nor its old value.
+  cache.put(3, "ccccccccccc", 11);
+  EXPECT_EQ(nullptr, cache.get(3));
+  EXPECT_EQ(0, cache.size());
+  EXPECT_EQ(0, cache.charge());
+}
+
+TEST(LruCacheTest, Stats) {
+  LruCache<int, int> cache(2);
+  cache.put(1, 1);
+  cache.put(2, 2);
+  cache.put(3, 3);
+  cache.get(1);
+  cache.get(2);
+  cache.get(3);
+
+  EXPECT_EQ(2, cache.stats().hits);
+  EXPECT_EQ(1, cache.stats().misses);
+  EXPECT_EQ(1, cache.stats().evictions);
+  EXPECT_DOUBLE_EQ(2.0 / 3, cache.stats().hit_ratio());
+}
+
+TEST(LruCacheTest, Erase) {
+  LruCache<int, int> cache(2);
+  cache.put(1, 1);
+  cache.put(2, 2);
+
+  EXPECT_TRUE(cache.erase(1));
+  EXPECT_FALSE(cache.erase(1));
+  EXPECT_EQ(nullptr, cache.get(1));
+  EXPECT_EQ(1, cache.size());
+  EXPECT_EQ(1, cache.charge());
+
+  // Erased entry isn't in recency list anymore.
+  cache.put(3, 3);
+  cache.put(4, 4);
+  EXPECT_EQ(nullptr, cache.get(2));
+  EXPECT_EQ(1, cache.stats().evictions);
+}
+
+// Value whose copy throws if |fails| is set.
+struct Fragile {
+  bool fails;
+
+  explicit Fragile(bool f) : fails(f) {}
+  Fragile(const Fragile& other) : fails(other.fails) {
+    if (fails)
+      throw std::runtime_error("copy failed");
+  }
+  Fragile& operator=(const Fragile& other) = default;
+};
+
+TEST(LruCacheTest, PutThatThrows) {
+  LruCache<int, Fragile> cache(2);
+  EXPECT_THROW(cache.put(1, Fragile(true)), std::runtime_error);
+  EXPECT_EQ(0, cache.size());
+  EXPECT_EQ(nullptr, cache.get(1));
+  EXPECT_FALSE(cache.erase(1));
+
+  cache.put(1, Fragile(false));
+  EXPECT_EQ(1, cache.size());
+  EXPECT_NE(nullptr, cache.get(1));
+}
+
+TEST(LruCacheTest, HeterogeneousLookup) {
+  LruCache<std::string, int> cache(2);
+  cache.put("1", 1);
+
+  std::string_view key = "1";
+  EXPECT_EQ(1, *cache.get<std::string_view>(key));
+  EXPECT_TRUE(cache.erase<std::string_view>(key));
+}
+
+TEST(LruCacheTest, ManyKeys) {
+  LruCache<int, int> cache(100);
+  for (int i = 0; i < 10000; ++i) {
+    cache.put(i, i);
+    if (i >= 10)
+      cache.get(i - 10);
+  }
+
+  EXPECT_EQ(100, cache.size());
+  EXPECT_EQ(9900, cache.stats().evictions);
+  for (int i = 9900; i < 10000; ++i)
+    EXPECT_EQ(i, *cache.get(i));
+}
+
+}  // namespace
@@ -0,0 +1,686 @@
+#include <malloc.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "hash_table/arena_hash_table.h"
+#include "hash_table/concurrent_hash_table.h"
+#include "hash_table/filtered_hash_table.h"
+#include "hash_table/flat_int_table.h"
+#include "hash_table/hash_table.h"
+#include "hash_table/mapped_hash_table.h"
+#include "hash_table/read_mostly_hash_table.h"
+#include "utils/bench.h"
+
+namespace {
+
+using namespace td;
+
+// Keys which are inserted to tables and keys which never are.
+struct KeySet {
+  std::vector<std::string> present;
+  std::vector<std::string> absent;
+};
+
+KeySet make_keys(std::size_t count) {
+  KeySet keys;
+  for (std::size_t i = 0; i < count; ++i) {
+    keys.present.push_back("key:" + std::to_string(i));
+    keys.absent.push_back("missing:" + std::to_string(i));
+  }
+  return keys;
+}
+
+// Measure hit and miss lookups of a table with |capacity| slots filled up to
+// |load_factor|.
+void bench_lookup(std::size_t capacity, float load_factor) {
+  std::size_t count = static_cast<std::size_t>(capacity * load_factor);
+  KeySet keys = make_keys(count);
+
+  HashTable<std::string, std::string> hash_table;
+  for (const std::string& key : keys.present)
+    hash_table.set(key, "value");
+
+  // Look keys up in random order so probes don't follow insertion order.
+  std::mt19937 random(42);
+  std::shuffle(keys.present.begin(), keys.present.end(), random);
+
+  char name[64];
+  double hit_ns = bench::elapsed_ns([&] {
+    for (const std::string& key : keys.present)
+      bench::do_not_optimize(hash_table.get(key));
+  });
+  std::snprintf(name, sizeof(name), "get hit  load %.3f", load_factor);
+  bench::report(name, hit_ns, count);
+
+  double miss_ns = bench::elapsed_ns([&] {
+    for (const std::string& key : keys.absent)
+      bench::do_not_optimize(hash_table.get(key));
+  });
+  std::snprintf(name, sizeof(name), "get miss load %.3f", load_factor);
+  bench::report(name, miss_ns, count);
+}
+
+// Measure set and get of |count| 64-bit integer keys, once with integer keys
+// and once converting them to strings as std::string keyed tables need.
+void bench_integer_keys(std::size_t count) {
+  std::vector<std::uint64_t> keys;
+  std::mt19937_64 random(42);
+  for (std::size_t i = 0; i < count; ++i)
+    keys.push_back(random());
+
+  double integer_ns = bench::elapsed_ns([&] {
+    HashTable<std::uint64_t, std::uint64_t> hash_table;
+    for (std::uint64_t key : keys)
+      hash_table.set(key, key);
+    for (std::uint64_t key : keys)
+      bench::do_not_optimize(hash_table.get(key));
+  });
+  bench::report("set+get uint64 key", integer_ns, count);
+
+  double string_ns = bench::elapsed_ns([&] {
+    HashTable<std::string, std::uint64_t> hash_table;
+    for (std::uint64_t key : keys)
+      hash_table.set(std::to_string(key), key);
+    for (std::uint64_t key : keys)
+      bench::do_not_optimize(hash_table.get(std::to_string(key)));
+  });
+  bench::report("set+get uint64 as std::string key", string_ns, count);
+}
+
+// Measure writes of |count| new keys and then overwrites of the same keys.
+void bench_write(std::size_t count) {
+  KeySet keys = make_keys(count);
+  HashTable<std::string, std::uint64_t> hash_table;
+
+  double insert_ns = bench::elapsed_ns([&] {
+    for (std::size_t i = 0; i < count; ++i)
+      hash_table.set(keys.present[i], i);
+  });
+  bench::report("set new key", insert_ns, count);
+
+  double assign_ns = bench::elapsed_ns([&] {
+    for (std::size_t i = 0; i < count; ++i)
+      hash_table.set(keys.present[i], i + 1);
+  });
+  bench::report("set existing key", assign_ns, count);
+
+  double erase_ns = bench::elapsed_ns([&] {
+    for (std::size_t i = 0; i < count; ++i)
+      bench::do_not_optimize(hash_table.erase(keys.present[i]));
+  });
+  bench::report("erase existing key", erase_ns, count);
+}
+
+// Measure latency of each of |count| inserts, with given rehash mode.
+void bench_insert_latency(std::size_t count,
+                          hash_table::Rehash rehash,
+                          const char* name) {
+  std::vector<std::uint64_t> keys;
+  std::mt19937_64 random(42);
+  for (std::size_t i = 0; i < count; ++i)
+    keys.push_back(random());
+
+  std::vector<double> latencies_ns;
+  latencies_ns.reserve(count);
+
+  HashTable<std::uint64_t, std::uint64_t> hash_table(rehash);
+  for (std::uint64_t key : keys) {
+    latencies_ns.push_back(
+        bench::elapsed_ns([&] { hash_table.set(key, key); }));
+  }
+  bench::report_latency(name, latencies_ns);
+}
+
+// A |HashTable| behind one global mutex, the setup |ConcurrentHashTable|
+// replaces.
+class LockedHashTable {
+ public:
+  void set(std::uint64_t key, std::uint64_t value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    hash_table_.set(key, value);
+  }
+
+  std::uint64_t get(std::uint64_t key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return hash_table_.get(key);
+  }
+
+ private:
+  std::mutex mutex_;
+  HashTable<std::uint64_t, std::uint64_t> hash_table_;
+};
+
+// Run |operations| random gets and sets over |key_count| keys split across
+// |thread_count| threads. |read_percent| of operations are gets. Return
+// elapsed time.
+template <typename Table>
+double run_mixed(Table& table,
+                 std::size_t key_count,
+                 std::size_t operations,
+                 unsigned thread_count,
+                 unsigned read_percent) {
+  return bench::elapsed_ns([&] {
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < thread_count; ++t) {
+      threads.emplace_back([&, t] {
+        std::mt19937_64 random(t);
+        for (std::size_t i = 0; i < operations / thread_count; ++i) {
+          std::uint64_t key = random() % key_count;
+          if (random() % 100 < read_percent)
+            bench::do_not_optimize(table.get(key));
+          else
+            table.set(key, i);
+        }
+      });
+    }
+    for (std::thread& thread : threads)
+      thread.join();
+  });
+}
+
+// Measure throughput of a global-mutex table and |ConcurrentHashTable| from
+// 1 thread up to all hardware threads.
+void bench_concurrent(std::size_t key_count) {
+  unsigned max_threads = std::max(1u, std::thread::hardware_concurrency());
+  std::size_t operations = key_count * 4;
+
+  for (unsigned read_percent : {90u, 50u}) {
+    for (unsigned threads = 1; threads <= max_threads; threads *= 2) {
+      LockedHashTable locked;
+      ConcurrentHashTable<std::uint64_t, std::uint64_t> sharded;
+      for (std::uint64_t key = 0; key < key_count; ++key) {
+        locked.set(key, key);
+        sharded.set(key, key);
+      }
+
+      char name[64];
+      std::snprintf(name, sizeof(name), "global mutex  %u%% reads %2u threads",
+                    read_percent, threads);
+      bench::report(name, run_mixed(locked, key_count, operations, threads,
+                                    read_percent),
+                    operations);
+      std::snprintf(name, sizeof(name), "sharded       %u%% reads %2u threads",
+                    read_percent, threads);
+      bench::report(name, run_mixed(sharded, key_count, operations, threads,
+                                    read_percent),
+                    operations);
+
+      // Finish with all hardware threads when their count isn't a power of
+      // two.
+      if (threads < max_threads && threads * 2 > max_threads)
+        threads = max_threads / 2;
+    }
+  }
+}
+
+// Measure read-only throughput per thread of |ConcurrentHashTable| and
+// |ReadMostlyHashTable|. Lock-free reads should keep it flat as threads are
+// added, reader locks bounce their cache lines between cores.
+void bench_read_scaling(std::size_t key_count) {
+  unsigned max_threads = std::max(1u, std::thread::hardware_concurrency());
+  std::size_t reads_per_thread = key_count * 2;
+
+  ConcurrentHashTable<std::uint64_t, std::uint64_t> sharded;
+  ReadMostlyHashTable<std::uint64_t, std::uint64_t> read_mostly;
+  for (std::uint64_t key = 0; key < key_count; ++key) {
+    sharded.set(key, key);
+    read_mostly.set(key, key);
+  }
+
+  auto run = [&](auto& table, unsigned thread_count) {
+    return bench::elapsed_ns([&] {
+      std::vector<std::thread> threads;
+      for (unsigned t = 0; t < thread_count; ++t) {
+        threads.emplace_back([&, t] {
+          std::mt19937_64 random(t);
+          for (std::size_t i = 0; i < reads_per_thread; ++i)
+            bench::do_not_optimize(table.get(random() % key_count));
+        });
+      }
+      for (std::thread& thread : threads)
+        thread.join();
+    });
+  };
+
+  for (unsigned threads = 1; threads <= max_threads; threads *= 2) {
+    // Reported ops/s are reads per second per thread.
+    char name[64];
+    std::snprintf(name, sizeof(name), "sharded     reads/thread %2u threads",
+                  threads);
+    bench::report(name, run(sharded, threads), reads_per_thread);
+    std::snprintf(name, sizeof(name), "read mostly reads/thread %2u threads",
+                  threads);
+    bench::report(name, run(read_mostly, threads), reads_per_thread);
+
+    if (threads < max_threads && threads * 2 > max_threads)
+      threads = max_threads / 2;
+  }
+}
+
+// Measure startup load of |count| random integer pairs: repeated |set|,
+// |reserve| followed by |set|, and the bulk constructor. Then measure lookups
+// of all keys one by one and with |get_many|.
+void bench_bulk_load(std::size_t count) {
+  std::vector<std::pair<std::uint64_t, std::uint64_t>> items;
+  std::vector<std::uint64_t> keys;
+  std::mt19937_64 random(42);
+  for (std::size_t i = 0; i < count; ++i) {
+    items.emplace_back(random(), i);
+    keys.push_back(items.back().first);
+  }
+  std::shuffle(keys.begin(), keys.end(), random);
+
+  char name[64];
+  double set_ns = bench::elapsed_ns([&] {
+    HashTable<std::uint64_t, std::uint64_t> hash_table;
+    for (const auto& item : items)
+      hash_table.set(item.first, item.second);
+  });
+  std::snprintf(name, sizeof(name), "load %zu pairs with set", count);
+  bench::report(name, set_ns, count);
+
+  double reserve_ns = bench::elapsed_ns([&] {
+    HashTable<std::uint64_t, std::uint64_t> hash_table;
+    hash_table.reserve(count);
+    for (const auto& item : items)
+      hash_table.set(item.first, item.second);
+  });
+  std::snprintf(name, sizeof(name), "load %zu pairs with reserve+set", count);
+  bench::report(name, reserve_ns, count);
+
+  std::unique_ptr<HashTable<std::uint64_t, std::uint64_t>> loaded;
+  double bulk_ns = bench::elapsed_ns([&] {
+    loaded = std::make_unique<HashTable<std::uint64_t, std::uint64_t>>(
+        items.begin(), items.end());
+  });
+  std::snprintf(name, sizeof(name), "load %zu pairs with bulk constructor",
+                count);
+  bench::report(name, bulk_ns, count);
+
+  double get_ns = bench::elapsed_ns([&] {
+    for (std::uint64_t key : keys)
+      bench::do_not_optimize(loaded->get(key));
+  });
+  bench::report("get one by one after bulk load", get_ns, count);
+
+  std::vector<std::uint64_t> values(count);
+  double get_many_ns =
+      bench::elapsed_ns([&] { loaded->get_many(keys, values.begin()); });
+  bench::do_not_optimize(values.back());
+  bench::report("get_many after bulk load", get_many_ns, count);
+}
+
+// Measure cold start of a process serving |count| string pairs: rebuilding
+// the table with |set| against opening a snapshot of it. Snapshot file is
+// in page cache, as after a restart.
+void bench_snapshot(std::size_t count) {
+  KeySet keys = make_keys(count);
+  std::vector<std::string> values;
+  for (std::size_t i = 0; i < count; ++i)
+    values.push_back("value:" + std::to_string(i));
+
+  HashTable<std::string, std::string> hash_table;
+  double rebuild_ns = bench::elapsed_ns([&] {
+    for (std::size_t i = 0; i < count; ++i)
+      hash_table.set(keys.present[i], values[i]);
+  });
+  std::printf("%-48s %10.2f ms\n", "start by rebuilding with set",
+              rebuild_ns / 1e6);
+
+  const char* path = "hash_table_bench.snapshot";
+  double write_ns =
+      bench::elapsed_ns([&] { MappedHashTable::write(path, hash_table); });
+  std::printf("%-48s %10.2f ms\n", "write snapshot", write_ns / 1e6);
+
+  for (hash_table::Verify verify :
+       {hash_table::Verify::kHeader, hash_table::Verify::kChecksum}) {
+    double open_ns = bench::elapsed_ns([&] {
+      MappedHashTable mapped(path, verify);
+      bench::do_not_optimize(mapped.get(keys.present[0]));
+    });
+    std::printf("%-48s %10.2f ms\n",
+                verify == hash_table::Verify::kHeader
+                    ? "start by mapping snapshot, header check"
+                    : "start by mapping snapshot, checksum check",
+                open_ns / 1e6);
+  }
+
+  MappedHashTable mapped(path, hash_table::Verify::kHeader);
+  double mapped_ns = bench::elapsed_ns([&] {
+    for (const std::string& key : keys.present)
+      bench::do_not_optimize(mapped.get(key));
+  });
+  bench::report("get hit  mapped snapshot", mapped_ns, count);
+
+  double table_ns = bench::elapsed_ns([&] {
+    for (const std::string& key : keys.present)
+      bench::do_not_optimize(hash_table.find(key));
+  });
+  bench::report("find hit HashTable", table_ns, count);
+  std::remove(path);
+}
+
+// Return bytes of heap currently in use.
+std::size_t heap_in_use() {
+  struct mallinfo2 info = mallinfo2();
+  return info.uordblks + info.hblkhd;
+}
+
+// Compare memory per item and lookups of |count| random string keys of 12 to
+// 40 bytes, stored as std::string nodes of |HashTable| or in the arena of
+// |ArenaHashTable|.
+void bench_string_keys(std::size_t count) {
+  std::mt19937_64 random(42);
+  std::uniform_int_distribution<std::size_t> length(12, 40);
+  std::uniform_int_distribution<int> letter('a', 'z');
+  std::vector<std::string> keys(count);
+  std::size_t key_bytes = 0;
+  for (std::string& key : keys) {
+    key.resize(length(random));
+    for (char& c : key)
+      c = static_cast<char>(letter(random));
+    key_bytes += key.size();
+  }
+
+  std::vector<std::uint32_t> order(count);
+  for (std::size_t i = 0; i < count; ++i)
+    order[i] = static_cast<std::uint32_t>(i);
+  std::shuffle(order.begin(), order.end(), random);
+
+  char name[64];
+  {
+    std::size_t heap_before = heap_in_use();
+    HashTable<std::string, std::uint64_t> hash_table;
+    double set_ns = bench::elapsed_ns([&] {
+      for (std::size_t i = 0; i < count; ++i)
+        hash_table.set(keys[i], i);
+    });
+    std::size_t bytes = heap_in_use() - heap_before;
+    bench::report("string keys, HashTable set", set_ns, count);
+
+    double get_ns = bench::elapsed_ns([&] {
+      for (std::uint32_t i : order)
+        bench::do_not_optimize(hash_table.find(keys[i]));
+    });
+    bench::report("string keys, HashTable find hit", get_ns, count);
+    std::snprintf(name, sizeof(name), "string keys, HashTable %zu keys", count);
+    std::printf("%-48s %10.1f bytes/item\n", name, 1.0 * bytes / count);
+  }
+
+  {
+    std::size_t heap_before = heap_in_use();
+    ArenaHashTable<std::uint64_t> arena_table;
+    double set_ns = bench::elapsed_ns([&] {
+      for (std::size_t i = 0; i < count; ++i)
+        arena_table.set(keys[i], i);
+    });
+    std::size_t bytes = heap_in_use() - heap_before;
+    bench::report("string keys, ArenaHashTable set", set_ns, count);
+
+    double get_ns = bench::elapsed_ns([&] {
+      for (std::uint32_t i : order)
+        bench::do_not_optimize(arena_table.find(keys[i]));
+    });
+    bench::report("string keys, ArenaHashTable find hit", get_ns, count);
+    std::snprintf(name, sizeof(name), "string keys, ArenaHashTable %zu keys",
+                  count);
+    std::printf("%-48s %10.1f bytes/item (%.1f bytes of keys)\n", name,
+                1.0 * bytes / count, 1.0 * key_bytes / count);
+  }
+}
+
+// Dedup a stream where each of |size| random keys occurs 4 times, then look
+// all keys up, with |FlatIntSet| and with |HashTable|. Tables are rebuilt
+// until about 4M keys went through each.
+template <std::size_t size>
+void bench_flat_int() {
+  std::mt19937_64 random(42);
+  std::vector<std::uint64_t> keys(size);
+  for (std::uint64_t& key : keys)
+    key = random();
+  std::vector<std::uint64_t> stream;
+  for (int i = 0; i < 4; ++i)
+    stream.insert(stream.end(), keys.begin(), keys.end());
+  std::shuffle(stream.begin(), stream.end(), random);
+  std::size_t rounds = (std::size_t{1} << 22) / stream.size();
+
+  char name[64];
+  static FlatIntSet<size> set;
+  std::size_t unique = 0;
+  double flat_dedup_ns = bench::elapsed_ns([&] {
+    for (std::size_t round = 0; round < rounds; ++round) {
+      set.clear();
+      for (std::uint64_t key : stream)
+        unique += set.insert(key);
+    }
+  });
+  std::snprintf(name, sizeof(name), "dedup  %6zu keys, FlatIntSet", size);
+  bench::report(name, flat_dedup_ns, rounds * stream.size());
+
+  double flat_lookup_ns = bench::elapsed_ns([&] {
+    for (std::size_t round = 0; round < rounds * 4; ++round) {
+      for (std::uint64_t key : keys)
+        unique += set.contains(key);
+    }
+  });
+  std::snprintf(name, sizeof(name), "lookup %6zu keys, FlatIntSet", size);
+  bench::report(name, flat_lookup_ns, rounds * stream.size());
+
+  std::unique_ptr<HashTable<std::uint64_t, bool>> hash_table;
+  double table_dedup_ns = bench::elapsed_ns([&] {
+    for (std::size_t round = 0; round < rounds; ++round) {
+      hash_table = std::make_unique<HashTable<std::uint64_t, bool>>();
+      for (std::uint64_t key : stream)
+        unique += hash_table->try_emplace(key, true).second;
+    }
+  });
+  std::snprintf(name, sizeof(name), "dedup  %6zu keys, HashTable", size);
+  bench::report(name, table_dedup_ns, rounds * stream.size());
+
+  double table_lookup_ns = bench::elapsed_ns([&] {
+    for (std::size_t round = 0; round < rounds * 4; ++round) {
+      for (std::uint64_t key : keys)
+        unique += hash_table->find(key) != nullptr;
+    }
+  });
+  std::snprintf(name, sizeof(name), "lookup %6zu keys, HashTable", size);
+  bench::report(name, table_lookup_ns, rounds * stream.size());
+  bench::do_not_optimize(unique);
+}
+
+// Keep |key_count| integer keys in a table of given probing while |cycles|
+// times a random key is removed and a new one inserted, then measure lookups
+// in the steady state reached.
+template <typename ProbingType>
+void bench_churn(std::size_t key_count, std::size_t cycles, const char* name) {
+  HashTable<std::uint64_t, std::uint64_t, Hash<std::uint64_t>, std::equal_to<>,
+            ProbingType>
+      hash_table;
+  std::vector<std::uint64_t> keys;
+  std::uint64_t next_key = 0;
+  for (; next_key < key_count; ++next_key) {
+    keys.push_back(next_key);
+    hash_table.set(next_key, next_key);
+  }
+
+  std::mt19937_64 random(42);
+  char label[64];
+  double churn_ns = bench::elapsed_ns([&] {
+    for (std::size_t i = 0; i < cycles; ++i) {
+      std::uint64_t& key = keys[random() % key_count];
+      hash_table.erase(key);
+      key = next_key++;
+      hash_table.set(key, key);
+    }
+  });
+  std::snprintf(label, sizeof(label), "%s churn erase+set", name);
+  bench::report(label, churn_ns, cycles);
+
+  std::shuffle(keys.begin(), keys.end(), random);
+  double hit_ns = bench::elapsed_ns([&] {
+    for (std::uint64_t key : keys)
+      bench::do_not_optimize(hash_table.get(key));
+  });
+  std::snprintf(label, sizeof(label), "%s get hit  after churn", name);
+  bench::report(label, hit_ns, key_count);
+
+  double miss_ns = bench::elapsed_ns([&] {
+    for (std::size_t i = 0; i < key_count; ++i)
+      bench::do_not_optimize(hash_table.get(next_key + i));
+  });
+  std::snprintf(label, sizeof(label), "%s get miss after churn", name);
+  bench::report(label, miss_ns, key_count);
+
+  std::vector<double> latencies_ns;
+  for (std::size_t i = 0; i < key_count; ++i) {
+    std::uint64_t key = i % 2 ? keys[i] : next_key + i;
+    latencies_ns.push_back(bench::elapsed_ns(
+        [&] { bench::do_not_optimize(hash_table.get(key)); }));
+  }
+  std::snprintf(label, sizeof(label), "%s get latency after churn", name);
+  bench::report_latency(label, latencies_ns);
+
+  std::vector<std::size_t> histogram = hash_table.probe_histogram();
+  std::printf("%s probe lengths:", name);
+  for (std::size_t length = 1; length < histogram.size(); ++length)
+    std::printf(" %zu:%zu", length, histogram[length]);
+  std::printf("\n");
+
+  hash_table::Stats stats = hash_table.stats();
+  std::printf(
+      "%s stats: load %.3f, %zu tombstones, probe avg %.3f max %zu, "
+      "%zu rehashes\n",
+      name, stats.load_factor(), stats.tombstones, stats.average_probe_length,
+      stats.max_probe_length, stats.rehash_count);
+}
+
+// Measure walking all items of a table with |capacity| slots filled up to
+// |load_factor|, and the cost of |stats| which stays on in production.
+void bench_iterate(std::size_t capacity, float load_factor) {
+  std::size_t count = static_cast<std::size_t>(capacity * load_factor);
+  HashTable<std::uint64_t, std::uint64_t> hash_table;
+  hash_table.reserve(static_cast<std::size_t>(capacity * growth_factor));
+  for (std::uint64_t i = 0; i < count; ++i)
+    hash_table.set(i, i);
+
+  char name[64];
+  std::uint64_t sum = 0;
+  double iterate_ns = bench::elapsed_ns([&] {
+    for (auto item : hash_table)
+      sum += item.value;
+  });
+  bench::do_not_optimize(sum);
+  std::snprintf(name, sizeof(name), "iterate      load %.3f", load_factor);
+  bench::report(name, iterate_ns, count);
+
+  double for_each_ns = bench::elapsed_ns([&] {
+    hash_table.for_each(
+        [&](std::uint64_t, std::uint64_t value) { sum += value; });
+  });
+  bench::do_not_optimize(sum);
+  std::snprintf(name, sizeof(name), "for_each     load %.3f", load_factor);
+  bench::report(name, for_each_ns, count);
+
+  constexpr std::size_t stats_calls = 100000;
+  double stats_ns = bench::elapsed_ns([&] {
+    for (std::size_t i = 0; i < stats_calls; ++i)
+      bench::do_not_optimize(hash_table.stats());
+  });
+  std::snprintf(name, sizeof(name), "stats        load %.3f", load_factor);
+  bench::report(name, stats_ns, stats_calls);
+}
+
+// Measure lookups of which nine in ten miss, on tables of |present| keys with
+// and without a Bloom filter in front.
+template <typename KeyType>
+void bench_miss_heavy(const std::vector<KeyType>& present,
+                      const std::vector<KeyType>& absent,
+                      const char* name) {
+  HashTable<KeyType, std::uint64_t> hash_table;
+  FilteredHashTable<KeyType, std::uint64_t> filtered_table;
+  for (std::size_t i = 0; i < present.size(); ++i) {
+    hash_table.set(present[i], i + 1);
+    filtered_table.set(present[i], i + 1);
+  }
+
+  std::vector<const KeyType*> lookups;
+  std::mt19937_64 generator(11);
+  for (std::size_t i = 0; i < present.size(); ++i) {
+    const std::vector<KeyType>& keys = i % 10 == 0 ? present : absent;
+    lookups.push_back(&keys[generator() % keys.size()]);
+  }
+
+  char label[64];
+  std::uint64_t sum = 0;
+  double table_ns = bench::elapsed_ns([&] {
+    for (const KeyType* key : lookups)
+      sum += hash_table.get(*key);
+  });
+  bench::do_not_optimize(sum);
+  std::snprintf(label, sizeof(label), "90%% miss %s, hash table", name);
+  bench::report(label, table_ns, lookups.size());
+
+  double filtered_ns = bench::elapsed_ns([&] {
+    for (const KeyType* key : lookups)
+      sum += filtered_table.get(*key);
+  });
+  bench::do_not_optimize(sum);
+  std::snprintf(label, sizeof(label), "90%% miss %s, filtered", name);
+  bench::report(label, filtered_ns, lookups.size());
+  std::printf("%-48s %10zu filter bytes\n", label,
+              filtered_table.filter_memory_usage());
+}
+
+}  // namespace
+
+// Usage: hash_table_bench [capacity] [startup load count] [churn cycles]
+int main(int argc, char** argv) {
+  std::size_t capacity = argc > 1 ? std::strtoull(argv[1], nullptr, 10)
+                                  : std::size_t{1} << 20;
+  std::size_t load_count =
+      argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 10000000;
+  std::size_t churn_cycles =
+      argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 100000000;
+
+  for (float load_factor : {0.5f, 0.625f, 0.75f, 0.875f})
+    bench_lookup(capacity, load_factor);
+  bench_integer_keys(capacity);
+  bench_write(capacity);
+  bench_insert_latency(capacity, hash_table::Rehash::kAllAtOnce,
+                       "set latency, rehash all at once");
+  bench_insert_latency(capacity, hash_table::Rehash::kIncremental,
+                       "set latency, incremental rehash");
+  bench_concurrent(capacity);
+  bench_read_scaling(capacity);
+  bench_bulk_load(load_count);
+  bench_snapshot(capacity);
+  bench_churn<hash_table::GroupProbing>(capacity / 2, churn_cycles, "group");
+  bench_churn<hash_table::RobinHoodProbing>(capacity / 2, churn_cycles,
+                                            "robin hood");
+  for (float load_factor : {0.1f, 0.875f})
+    bench_iterate(capacity, load_factor);
+  bench_string_keys(load_count);
+  bench_flat_int<1024>();
+  bench_flat_int<4096>();
+  bench_flat_int<16384>();
+  bench_flat_int<65536>();
+
+  KeySet string_keys = make_keys(capacity);
+  bench_miss_heavy(string_keys.present, string_keys.absent, "string keys");
+  std::vector<std::uint64_t> present, absent;
+  for (std::uint64_t i = 0; i < capacity; ++i) {
+    present.push_back(i * 2);
+    absent.push_back(i * 2 + 1);
+  }
+  bench_miss_heavy(present, absent, "integer keys");
+  return 0;
+}
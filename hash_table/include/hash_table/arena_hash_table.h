@@ -0,0 +1,392 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "hash_table/group.h"
+#include "hash_table/hash.h"
+#include "hash_table/hash_table.h"
+#include "utils/macros.h"
+
+namespace td {
+
+// A hash table of string keys which keeps all keys back to back in one
+// append-only arena instead of a std::string per item. A slot holds offset,
+// length and full hash of its key next to the value, so inserting a key
+// allocates nothing but arena growth, and a lookup only reads the arena when
+// hash and length already match.
+//
+// Keys of removed items stay in the arena until the next rehash, which
+// copies live keys to a new arena in slot order. Live keys may take up to
+// 4 GiB in total. Probing is the same as |HashTable| with
+// |hash_table::GroupProbing|, rehashing is always all at once.
+template <typename ValueType, typename HashType = hash_table::StringHash>
+class ArenaHashTable {
+ public:
+  ArenaHashTable();
+  explicit ArenaHashTable(const HashType& hasher);
+  ~ArenaHashTable();
+
+  // Make room for |count| items whose keys take |key_bytes| in total, so
+  // inserting them never reallocates. Capacity never shrinks below it
+  // afterwards.
+  void reserve(std::size_t count, std::size_t key_bytes = 0);
+
+  // Add the given key and value to hash table. If key exists, replace old value
+  // with given value. Throw std::length_error if arena can't hold the key.
+  void set(std::string_view key, const ValueType& value);
+  void set(std::string_view key, ValueType&& value);
+
+  // Returns value at given key. If key doesn't exist, return
+  // |hash_table::null_value()|.
+  ValueType get(std::string_view key) const;
+
+  // Return pointer to value at given key, or nullptr if key doesn't exist.
+  // The pointer is valid until the table is modified.
+  ValueType* find(std::string_view key);
+
+  // Removes value at given key. If key doesn't exist, does nothing
+  void remove(std::string_view key);
+
+  // Removes value at given key. Return true if key existed.
+  bool erase(std::string_view key);
+
+  // Call |function| with key and value of every item, in no particular
+  // order. |function| must not modify the table.
+  template <typename Function>
+  void for_each(Function&& function) const;
+
+  // Return number of items are currently stored in hash table.
+  std::size_t size() const;
+
+  // Return bytes allocated for control bytes, slots and arena.
+  std::size_t memory_usage() const;
+
+ private:
+  using ctrl_t = hash_table::ctrl_t;
+
+  // Key is |length| bytes at |offset| of |arena_|.
+  struct Slot {
+    std::uint64_t hash;
+    std::uint32_t offset;
+    std::uint32_t length;
+    ValueType value;
+  };
+
+  // Return index of slot which holds |key|. If key doesn't exist, return
+  // |index_not_found|.
+  std::size_t find_index(std::string_view key, std::uint64_t hash_value) const;
+
+  // Implementation of |set|.
+  template <typename V>
+  void assign(std::string_view key, V&& value);
+
+  // Return index of first empty or deleted slot in probe sequence of
+  // |hash_value|.
+  std::size_t find_free_index(std::uint64_t hash_value) const;
+
+  // Copy |key| to end of arena and return its offset.
+  std::uint32_t append_key(std::string_view key);
+
+  // Grow, shrink or clean up tombstones like |HashTable|, also when more
+  // than half of arena is taken by removed keys.
+  void reallocate_if_needed(std::size_t new_size);
+
+  // Allocate |new_capacity| slots and move items to them, copying their keys
+  // to a new arena.
+  void rehash(std::size_t new_capacity);
+
+  // Destroy all values and release slots and control bytes.
+  void deallocate();
+
+  // Hash function of keys.
+  HashType hasher_;
+
+  // Control bytes of slots, |capacity_| items.
+  ctrl_t* ctrl_{nullptr};
+
+  // Raw array of slots, only full ones hold a constructed slot.
+  Slot* slots_{nullptr};
+
+  std::size_t capacity_{0};
+  std::size_t size_{0};
+
+  // Number of slots are marked as |deleted_ctrl|.
+  std::size_t deleted_{0};
+
+  // Keys of all slots, and of removed items until next rehash.
+  std::string arena_;
+
+  // Bytes of |arena_| which belong to removed items.
+  std::size_t dead_bytes_{0};
+
+  // Capacity which table never shrinks below, raised by |reserve|.
+  std::size_t min_capacity_{default_capacity};
+
+  DISALLOW_COPY_AND_ASSIGN(ArenaHashTable);
+};
+
+}  // namespace td
+
+/****************  Arena hash table implementation ****************/
+namespace td {
+
+// Public
+
+template <typename ValueType, typename HashType>
+ArenaHashTable<ValueType, HashType>::ArenaHashTable()
+    : ArenaHashTable(HashType()) {}
+
+template <typename ValueType, typename HashType>
+ArenaHashTable<ValueType, HashType>::ArenaHashTable(const HashType& hasher)
+    : hasher_(hasher) {
+  rehash(default_capacity);
+}
+
+template <typename ValueType, typename HashType>
+ArenaHashTable<ValueType, HashType>::~ArenaHashTable() {
+  deallocate();
+}
+
+template <typename ValueType, typename HashType>
+void ArenaHashTable<ValueType, HashType>::reserve(std::size_t count,
+                                                  std::size_t key_bytes) {
+  std::size_t capacity = default_capacity;
+  while (count > capacity * growth_factor)
+    capacity *= 2;
+  if (capacity > min_capacity_)
+    min_capacity_ = capacity;
+  if (capacity > capacity_)
+    rehash(capacity);
+  arena_.reserve(key_bytes);
+}
+
+template <typename ValueType, typename HashType>
+void ArenaHashTable<ValueType, HashType>::set(std::string_view key,
+                                              const ValueType& value) {
+  assign(key, value);
+}
+
+template <typename ValueType, typename HashType>
+void ArenaHashTable<ValueType, HashType>::set(std::string_view key,
+                                              ValueType&& value) {
+  assign(key, std::move(value));
+}
+
+template <typename ValueType, typename HashType>
+ValueType ArenaHashTable<ValueType, HashType>::get(
+    std::string_view key) const {
+  std::size_t index = find_index(key, hasher_(key));
+  if (index == index_not_found)
+    return hash_table::null_value<ValueType>();
+  return slots_[index].value;
+}
+
+template <typename ValueType, typename HashType>
+ValueType* ArenaHashTable<ValueType, HashType>::find(std::string_view key) {
+  std::size_t index = find_index(key, hasher_(key));
+  if (index == index_not_found)
+    return nullptr;
+  return &slots_[index].value;
+}
+
+template <typename ValueType, typename HashType>
+void ArenaHashTable<ValueType, HashType>::remove(std::string_view key) {
+  erase(key);
+}
+
+template <typename ValueType, typename HashType>
+bool ArenaHashTable<ValueType, HashType>::erase(std::string_view key) {
+  std::size_t index = find_index(key, hasher_(key));
+  if (index == index_not_found)
+    return false;
+
+  dead_bytes_ += slots_[index].length;
+  slots_[index].~Slot();
+  --size_;
+
+  // Same rule as |HashTable|: a group which still has an empty slot never
+  // made a probe sequence move on.
+  std::size_t group_offset = index - index % hash_table::group_width;
+  if (hash_table::Group(ctrl_ + group_offset).match_empty().any()) {
+    ctrl_[index] = hash_table::empty_ctrl;
+  } else {
+    ctrl_[index] = hash_table::deleted_ctrl;
+    ++deleted_;
+  }
+
+  reallocate_if_needed(size_);
+  return true;
+}
+
+template <typename ValueType, typename HashType>
+template <typename Function>
+void ArenaHashTable<ValueType, HashType>::for_each(
+    Function&& function) const {
+  for (std::size_t i = 0; i < capacity_; ++i) {
+    if (hash_table::is_full(ctrl_[i])) {
+      const Slot& slot = slots_[i];
+      function(std::string_view(arena_.data() + slot.offset, slot.length),
+               slot.value);
+    }
+  }
+}
+
+template <typename ValueType, typename HashType>
+std::size_t ArenaHashTable<ValueType, HashType>::size() const {
+  return size_;
+}
+
+template <typename ValueType, typename HashType>
+std::size_t ArenaHashTable<ValueType, HashType>::memory_usage() const {
+  return capacity_ * (sizeof(ctrl_t) + sizeof(Slot)) + arena_.capacity();
+}
+
+// Private
+
+template <typename ValueType, typename HashType>
+std::size_t ArenaHashTable<ValueType, HashType>::find_index(
+    std::string_view key,
+    std::uint64_t hash_value) const {
+  ctrl_t h2 = static_cast<ctrl_t>(hash_value & 0x7F);
+  hash_table::ProbeSequence sequence(hash_value >> 7,
+                                     capacity_ / hash_table::group_width);
+  while (true) {
+    hash_table::Group group(ctrl_ + sequence.offset());
+    for (hash_table::BitMask match = group.match(h2); match.any();
+         match.clear_lowest()) {
+      std::size_t index = sequence.offset() + match.lowest();
+      const Slot& slot = slots_[index];
+      if (slot.hash == hash_value && slot.length == key.size() &&
+          std::memcmp(arena_.data() + slot.offset, key.data(), key.size()) ==
+              0)
+        return index;
+    }
+
+    if (group.match_empty().any())
+      return index_not_found;
+    sequence.next();
+  }
+}
+
+template <typename ValueType, typename HashType>
+template <typename V>
+void ArenaHashTable<ValueType, HashType>::assign(std::string_view key,
+                                                 V&& value) {
+  std::uint64_t hash_value = hasher_(key);
+  std::size_t index = find_index(key, hash_value);
+  if (index != index_not_found) {
+    slots_[index].value = std::forward<V>(value);
+    return;
+  }
+
+  // Value is made before anything changes, and slot is only marked full
+  // once it's built, so a throwing constructor leaves no half-inserted item.
+  // Key bytes of a slot whose move throws are dropped by next rehash.
+  ValueType new_value(std::forward<V>(value));
+  reallocate_if_needed(size_ + 1);
+  std::uint32_t offset = append_key(key);
+  index = find_free_index(hash_value);
+  new (&slots_[index]) Slot{hash_value, offset,
+                            static_cast<std::uint32_t>(key.size()),
+                            std::move(new_value)};
+  if (ctrl_[index] == hash_table::deleted_ctrl)
+    --deleted_;
+  ctrl_[index] = static_cast<ctrl_t>(hash_value & 0x7F);
+  ++size_;
+}
+
+template <typename ValueType, typename HashType>
+std::size_t ArenaHashTable<ValueType, HashType>::find_free_index(
+    std::uint64_t hash_value) const {
+  hash_table::ProbeSequence sequence(hash_value >> 7,
+                                     capacity_ / hash_table::group_width);
+  while (true) {
+    hash_table::BitMask free =
+        hash_table::Group(ctrl_ + sequence.offset()).match_free();
+    if (free.any())
+      return sequence.offset() + free.lowest();
+    sequence.next();
+  }
+}
+
+template <typename ValueType, typename HashType>
+std::uint32_t ArenaHashTable<ValueType, HashType>::append_key(
+    std::string_view key) {
+  if (arena_.size() + key.size() > std::numeric_limits<std::uint32_t>::max())
+    throw std::length_error("ArenaHashTable: arena is full");
+
+  std::uint32_t offset = static_cast<std::uint32_t>(arena_.size());
+  arena_.append(key);
+  return offset;
+}
+
+template <typename ValueType, typename HashType>
+void ArenaHashTable<ValueType, HashType>::reallocate_if_needed(
+    std::size_t new_size) {
+  if (new_size > capacity_ * growth_factor) {
+    rehash(capacity_ * 2);
+  } else if (new_size < capacity_ * shrink_factor &&
+             capacity_ > min_capacity_) {
+    rehash(capacity_ / 2);
+  } else if (new_size + deleted_ > capacity_ * growth_factor ||
+             dead_bytes_ > arena_.size() / 2) {
+    rehash(capacity_);
+  }
+}
+
+template <typename ValueType, typename HashType>
+void ArenaHashTable<ValueType, HashType>::rehash(std::size_t new_capacity) {
+  ctrl_t* old_ctrl = ctrl_;
+  Slot* old_slots = slots_;
+  std::size_t old_capacity = capacity_;
+  std::size_t live_bytes = arena_.size() - dead_bytes_;
+  std::string old_arena;
+  old_arena.swap(arena_);
+
+  capacity_ = new_capacity;
+  ctrl_ = new ctrl_t[capacity_];
+  for (std::size_t i = 0; i < capacity_; ++i)
+    ctrl_[i] = hash_table::empty_ctrl;
+  slots_ = static_cast<Slot*>(::operator new(capacity_ * sizeof(Slot)));
+  deleted_ = 0;
+  dead_bytes_ = 0;
+  arena_.reserve(live_bytes);
+
+  // Stored hashes spare hashing keys again.
+  for (std::size_t i = 0; i < old_capacity; ++i) {
+    if (!hash_table::is_full(old_ctrl[i]))
+      continue;
+
+    Slot& slot = old_slots[i];
+    std::size_t index = find_free_index(slot.hash);
+    ctrl_[index] = old_ctrl[i];
+    std::uint32_t offset = static_cast<std::uint32_t>(arena_.size());
+    arena_.append(old_arena, slot.offset, slot.length);
+    new (&slots_[index])
+        Slot{slot.hash, offset, slot.length, std::move(slot.value)};
+    slot.~Slot();
+  }
+
+  delete[] old_ctrl;
+  ::operator delete(old_slots);
+}
+
+template <typename ValueType, typename HashType>
+void ArenaHashTable<ValueType, HashType>::deallocate() {
+  for (std::size_t i = 0; i < capacity_; ++i) {
+    if (hash_table::is_full(ctrl_[i]))
+      slots_[i].~Slot();
+  }
+
+  delete[] ctrl_;
+  ::operator delete(slots_);
+}
+
+}  // namespace td
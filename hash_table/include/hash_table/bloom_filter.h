@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace td {
+
+// A blocked Bloom filter of 64-bit hashes. Each hash maps to one 256-bit
+// block, half a cache line, and sets one bit in each of its 8 words, so a
+// lookup touches one cache line and its 8 word checks are independent, which
+// compilers turn into SIMD. Items can't be removed, only the whole filter
+// cleared.
+//
+// Layout follows split block Bloom filters of Apache Parquet
+// (https://github.com/apache/parquet-format/blob/master/BloomFilter.md).
+class BloomFilter {
+ public:
+  // Default number of bits per expected item. It gives a false positive rate
+  // near 0.5%.
+  static constexpr std::size_t default_bits_per_item = 16;
+
+  // Filter sized for |expected_count| items.
+  explicit BloomFilter(std::size_t expected_count = 0,
+                       std::size_t bits_per_item = default_bits_per_item);
+
+  // Add item with |hash_value|.
+  void insert(std::uint64_t hash_value);
+
+  // Return false if no item with |hash_value| was added. True means one
+  // probably was.
+  bool may_contain(std::uint64_t hash_value) const;
+
+  // Remove all items.
+  void clear();
+
+  // Return bytes allocated for blocks.
+  std::size_t memory_usage() const;
+
+ private:
+  static constexpr std::size_t words_per_block = 8;
+
+  struct alignas(32) Block {
+    std::uint32_t words[words_per_block];
+  };
+
+  // Return block of |hash_value|, picked by its upper 32 bits.
+  std::size_t block_index(std::uint64_t hash_value) const;
+
+  // Bit of each word of a block which |hash_value| sets, picked by its lower
+  // 32 bits.
+  static Block make_mask(std::uint64_t hash_value);
+
+  std::vector<Block> blocks_;
+};
+
+}  // namespace td
+
+/****************  Bloom filter implementation ****************/
+namespace td {
+
+// Public
+
+inline BloomFilter::BloomFilter(std::size_t expected_count,
+                                std::size_t bits_per_item) {
+  constexpr std::size_t bits_per_block = words_per_block * 32;
+  std::size_t block_count =
+      (expected_count * bits_per_item + bits_per_block - 1) / bits_per_block;
+  blocks_.resize(block_count ? block_count : 1, Block{});
+}
+
+inline void BloomFilter::insert(std::uint64_t hash_value) {
+  Block& block = blocks_[block_index(hash_value)];
+  Block mask = make_mask(hash_value);
+  for (std::size_t i = 0; i < words_per_block; ++i)
+    block.words[i] |= mask.words[i];
+}
+
+inline bool BloomFilter::may_contain(std::uint64_t hash_value) const {
+  const Block& block = blocks_[block_index(hash_value)];
+  Block mask = make_mask(hash_value);
+
+  // No early exit, so the loop stays branch free.
+  std::uint32_t missing = 0;
+  for (std::size_t i = 0; i < words_per_block; ++i)
+    missing |= mask.words[i] & ~block.words[i];
+  return missing == 0;
+}
+
+inline void BloomFilter::clear() {
+  for (Block& block : blocks_)
+    block = Block{};
+}
+
+inline std::size_t BloomFilter::memory_usage() const {
+  return blocks_.size() * sizeof(Block);
+}
+
+// Private
+
+inline std::size_t BloomFilter::block_index(std::uint64_t hash_value) const {
+  // Maps upper 32 bits onto [0, block count) without a division.
+  return static_cast<std::size_t>(((hash_value >> 32) * blocks_.size()) >> 32);
+}
+
+inline BloomFilter::Block BloomFilter::make_mask(std::uint64_t hash_value) {
+  // Odd constants of Parquet's filters, each picks 5 bits of a product.
+  constexpr std::uint32_t salts[words_per_block] = {
+      0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+      0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U};
+
+  std::uint32_t key = static_cast<std::uint32_t>(hash_value);
+  Block mask;
+  for (std::size_t i = 0; i < words_per_block; ++i)
+    mask.words[i] = std::uint32_t{1} << ((key * salts[i]) >> 27);
+  return mask;
+}
+
+}  // namespace td
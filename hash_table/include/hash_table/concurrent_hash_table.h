@@ -0,0 +1,192 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+
+#include "hash_table/hash_table.h"
+#include "utils/macros.h"
+#include "utils/utils.h"
+
+namespace td {
+
+namespace hash_table {
+
+// Return number of shards used by default, 4 per hardware thread.
+inline std::size_t default_shard_count() {
+  unsigned threads = std::thread::hardware_concurrency();
+  return 4 * (threads ? threads : 1);
+}
+
+}  // namespace hash_table
+
+// A thread-safe hash table built from independent |HashTable| shards. Top
+// bits of a key's hash pick its shard, each shard has its own reader-writer
+// lock and grows or shrinks on its own, so threads working on different
+// shards never wait for each other. Readers of one shard share its lock.
+template <typename KeyType,
+          typename ValueType,
+          typename HashType = Hash<KeyType>,
+          typename EqualType = std::equal_to<>>
+class ConcurrentHashTable {
+  // Type of key accepted by lookups, see |HashTable|.
+  template <typename K>
+  using key_arg = typename hash_table::KeyArg<
+      hash_table::is_transparent<HashType>::value &&
+      hash_table::is_transparent<EqualType>::value>::template type<K, KeyType>;
+
+ public:
+  // Use |default_shard_count()| shards.
+  ConcurrentHashTable();
+
+  // |shard_count| is rounded up to a power of two.
+  explicit ConcurrentHashTable(std::size_t shard_count,
+                               const HashType& hasher = HashType(),
+                               const EqualType& equal = EqualType());
+
+  // Add the given key and value to hash table. If key exists, replace old value
+  // with given value
+  void set(const KeyType& key, const ValueType& value);
+
+  // Returns copy of value at given key. If key doesn't exist, return same
+  // value as |HashTable::get|.
+  template <typename K = KeyType>
+  ValueType get(const key_arg<K>& key);
+
+  // Removes value at given key. If key doesn't exist, does nothing
+  template <typename K = KeyType>
+  void remove(const key_arg<K>& key);
+
+  // Return number of shards.
+  std::size_t shard_count();
+
+ private:
+  using Table = HashTable<KeyType, ValueType, HashType, EqualType>;
+
+  // A lock and the table it protects. Shards are aligned to cache lines so
+  // locks of neighbour shards don't share one.
+  struct alignas(cache_line_size) Shard {
+    std::shared_mutex mutex;
+    Table table;
+
+    Shard(const HashType& hasher, const EqualType& equal)
+        : table(hasher, equal) {}
+  };
+
+  // Return shard which owns key with |hash_value|.
+  Shard& shard_for(std::size_t hash_value);
+
+  // Hash function of keys. A key is hashed once to pick its shard, and the
+  // hash is passed on to the shard's table.
+  HashType hasher_;
+
+  // Number of top hash bits which pick a shard.
+  std::size_t shard_bits_{0};
+
+  // Shards, |1 << shard_bits_| items.
+  std::vector<std::unique_ptr<Shard>> shards_;
+
+  DISALLOW_COPY_AND_ASSIGN(ConcurrentHashTable);
+};
+
+}  // namespace td
+
+/****************  Concurrent hash table implementation ****************/
+namespace td {
+
+// Public
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType>
+ConcurrentHashTable<KeyType, ValueType, HashType, EqualType>::
+    ConcurrentHashTable()
+    : ConcurrentHashTable(hash_table::default_shard_count()) {}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType>
+ConcurrentHashTable<KeyType, ValueType, HashType, EqualType>::
+    ConcurrentHashTable(std::size_t shard_count,
+                        const HashType& hasher,
+                        const EqualType& equal)
+    : hasher_(hasher) {
+  while ((std::size_t{1} << shard_bits_) < shard_count)
+    ++shard_bits_;
+
+  for (std::size_t i = 0; i < (std::size_t{1} << shard_bits_); ++i)
+    shards_.push_back(std::make_unique<Shard>(hasher, equal));
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType>
+void ConcurrentHashTable<KeyType, ValueType, HashType, EqualType>::set(
+    const KeyType& key,
+    const ValueType& value) {
+  std::size_t hash_value = hasher_(key);
+  Shard& shard = shard_for(hash_value);
+  std::unique_lock<std::shared_mutex> lock(shard.mutex);
+  shard.table.set(key, value, hash_value);
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType>
+template <typename K>
+ValueType ConcurrentHashTable<KeyType, ValueType, HashType, EqualType>::get(
+    const key_arg<K>& key) {
+  std::size_t hash_value = hasher_(key);
+  Shard& shard = shard_for(hash_value);
+  std::shared_lock<std::shared_mutex> lock(shard.mutex);
+  ValueType* value = shard.table.template find<K>(key, hash_value);
+  if (!value)
+    return hash_table::null_value<ValueType>();
+  return *value;
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType>
+template <typename K>
+void ConcurrentHashTable<KeyType, ValueType, HashType, EqualType>::remove(
+    const key_arg<K>& key) {
+  std::size_t hash_value = hasher_(key);
+  Shard& shard = shard_for(hash_value);
+  std::unique_lock<std::shared_mutex> lock(shard.mutex);
+  shard.table.template erase<K>(key, hash_value);
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType>
+std::size_t
+ConcurrentHashTable<KeyType, ValueType, HashType, EqualType>::shard_count() {
+  return shards_.size();
+}
+
+// Private
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType>
+typename ConcurrentHashTable<KeyType, ValueType, HashType, EqualType>::Shard&
+ConcurrentHashTable<KeyType, ValueType, HashType, EqualType>::shard_for(
+    std::size_t hash_value) {
+  if (shard_bits_ == 0)
+    return *shards_[0];
+
+  // Shard tables probe with lower bits, so top bits are independent of them.
+  return *shards_[hash_value >> (sizeof(std::size_t) * 8 - shard_bits_)];
+}
+
+}  // namespace td
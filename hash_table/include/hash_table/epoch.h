@@ -0,0 +1,233 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "utils/macros.h"
+#include "utils/utils.h"
+
+namespace td {
+namespace hash_table {
+
+// Epoch based reclamation for read-mostly data structures.
+//
+// Readers wrap every access in a |Guard|, which only writes the calling
+// thread's own record. A writer unlinks an object so new readers can't reach
+// it, then |retire|s it. The object is freed once every reader which could
+// still see it has left its guard: an object retired in epoch E is freed when
+// the global epoch reaches E + 2, and the global epoch only moves forward when
+// all readers inside a guard have seen the current one.
+class EpochDomain {
+  struct Record;
+  struct State;
+
+ public:
+  // Pins calling thread to current epoch while it's alive. Guards of one
+  // domain must not be nested in one thread.
+  class Guard {
+   public:
+    explicit Guard(EpochDomain& domain);
+    ~Guard();
+
+   private:
+    Record* record_;
+
+    DISALLOW_COPY_AND_ASSIGN(Guard);
+  };
+
+  EpochDomain();
+
+  // Free every retired object. No reader may be inside a guard.
+  ~EpochDomain();
+
+  // Free |object| with |deleter| once no reader can reach it. It must be
+  // unlinked by a sequentially consistent store, see |Guard|. Writers must
+  // call |retire| and |reclaim| one at a time.
+  void retire(void* object, void (*deleter)(void*));
+
+  // Try to advance the global epoch and free retired objects which no reader
+  // can see anymore.
+  void reclaim();
+
+  // Number of retired objects which are not freed yet.
+  std::size_t retired_count();
+
+ private:
+  // Epoch of a thread which is not inside a guard.
+  static constexpr std::uint64_t quiescent = 0;
+
+  // Per-thread announcement of the epoch it reads in. Each record has its own
+  // cache line, readers never write a line another thread writes.
+  struct alignas(cache_line_size) Record {
+    std::atomic<std::uint64_t> epoch{quiescent};
+
+    // Whether a live thread uses this record.
+    std::atomic<bool> owned{true};
+
+    // Next record in |State::records|, records are never unlinked.
+    Record* next{nullptr};
+  };
+
+  // Part of domain which threads keep alive until they exit, so their
+  // records can be released even if the domain is destroyed first.
+  struct State {
+    std::atomic<std::uint64_t> epoch{1};
+    std::atomic<Record*> records{nullptr};
+
+    ~State();
+  };
+
+  // Records claimed by one thread, released when the thread exits.
+  struct ThreadRecords {
+    std::vector<std::pair<std::shared_ptr<State>, Record*>> records;
+
+    ~ThreadRecords();
+  };
+
+  // An object waiting to be freed.
+  struct Retired {
+    void* object;
+    void (*deleter)(void*);
+    std::uint64_t epoch;
+  };
+
+  // Return record of calling thread, claim one on first use.
+  Record* local_record();
+
+  std::shared_ptr<State> state_;
+
+  // Objects waiting to be freed, oldest first.
+  std::vector<Retired> retired_;
+
+  DISALLOW_COPY_AND_ASSIGN(EpochDomain);
+};
+
+}  // namespace hash_table
+}  // namespace td
+
+/****************  Epoch domain implementation ****************/
+namespace td {
+namespace hash_table {
+
+// Guard
+
+inline EpochDomain::Guard::Guard(EpochDomain& domain)
+    : record_(domain.local_record()) {
+  // Sequentially consistent store orders the announcement before loads of
+  // the protected data only if those loads are sequentially consistent too,
+  // as are stores which unlink retired objects. Then a writer which advances
+  // the epoch either sees the announcement, or the reader sees the unlink.
+  record_->epoch.store(domain.state_->epoch.load(std::memory_order_acquire),
+                       std::memory_order_seq_cst);
+}
+
+inline EpochDomain::Guard::~Guard() {
+  record_->epoch.store(quiescent, std::memory_order_release);
+}
+
+// Public
+
+inline EpochDomain::EpochDomain() : state_(std::make_shared<State>()) {}
+
+inline EpochDomain::~EpochDomain() {
+  for (Retired& retired : retired_)
+    retired.deleter(retired.object);
+}
+
+inline void EpochDomain::retire(void* object, void (*deleter)(void*)) {
+  retired_.push_back(
+      {object, deleter, state_->epoch.load(std::memory_order_relaxed)});
+}
+
+inline void EpochDomain::reclaim() {
+  std::uint64_t epoch = state_->epoch.load(std::memory_order_relaxed);
+
+  // Epoch can only advance when no reader is still inside an older one.
+  bool can_advance = true;
+  for (Record* record = state_->records.load(std::memory_order_acquire);
+       record; record = record->next) {
+    std::uint64_t record_epoch = record->epoch.load(std::memory_order_seq_cst);
+    if (record_epoch != quiescent && record_epoch != epoch) {
+      can_advance = false;
+      break;
+    }
+  }
+  if (can_advance)
+    state_->epoch.store(++epoch, std::memory_order_seq_cst);
+
+  // Free objects retired at least two epochs ago.
+  std::size_t freed = 0;
+  while (freed < retired_.size() && retired_[freed].epoch + 2 <= epoch) {
+    retired_[freed].deleter(retired_[freed].object);
+    ++freed;
+  }
+  retired_.erase(retired_.begin(), retired_.begin() + freed);
+}
+
+inline std::size_t EpochDomain::retired_count() {
+  return retired_.size();
+}
+
+// Private
+
+inline EpochDomain::State::~State() {
+  Record* record = records.load(std::memory_order_relaxed);
+  while (record) {
+    Record* next = record->next;
+    delete record;
+    record = next;
+  }
+}
+
+inline EpochDomain::ThreadRecords::~ThreadRecords() {
+  for (auto& record : records)
+    record.second->owned.store(false, std::memory_order_release);
+}
+
+inline EpochDomain::Record* EpochDomain::local_record() {
+  static thread_local ThreadRecords thread_records;
+
+  for (auto& record : thread_records.records) {
+    if (record.first == state_)
+      return record.second;
+  }
+
+  // Drop records of destroyed domains, only this thread still holds them.
+  std::vector<std::pair<std::shared_ptr<State>, Record*>>& records =
+      thread_records.records;
+  for (std::size_t i = 0; i < records.size();) {
+    if (records[i].first.use_count() == 1) {
+      records[i] = std::move(records.back());
+      records.pop_back();
+    } else {
+      ++i;
+    }
+  }
+
+  // Reuse a record released by an exited thread, or add a new one.
+  Record* record = state_->records.load(std::memory_order_acquire);
+  for (; record; record = record->next) {
+    bool owned = false;
+    if (record->owned.compare_exchange_strong(owned, true,
+                                              std::memory_order_acq_rel))
+      break;
+  }
+
+  if (!record) {
+    record = new Record();
+    record->next = state_->records.load(std::memory_order_relaxed);
+    while (!state_->records.compare_exchange_weak(record->next, record,
+                                                  std::memory_order_release,
+                                                  std::memory_order_relaxed)) {
+    }
+  }
+
+  records.emplace_back(state_, record);
+  return record;
+}
+
+}  // namespace hash_table
+}  // namespace td
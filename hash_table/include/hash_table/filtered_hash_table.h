@@ -0,0 +1,272 @@
+#pragma once
+
+#include <functional>
+#include <utility>
+
+#include "hash_table/bloom_filter.h"
+#include "hash_table/hash_table.h"
+#include "utils/macros.h"
+
+namespace td {
+
+// A |HashTable| with a |BloomFilter| of its keys in front, for tables where
+// most lookups miss. A lookup checks the filter first, so a key which was
+// never inserted is usually rejected after one filter block is read, without
+// touching control bytes or slots. A key is hashed once, and the same hash
+// value is passed on to the table. Control bytes already reject most misses
+// after one group, so the filter pays off mainly while it stays in cache and
+// the table doesn't.
+//
+// Filter is rebuilt from the table when table outgrows it, or when removed
+// keys, which a Bloom filter can't forget, outnumber live ones.
+template <typename KeyType,
+          typename ValueType,
+          typename HashType = Hash<KeyType>,
+          typename EqualType = std::equal_to<>,
+          typename ProbingType = hash_table::GroupProbing>
+class FilteredHashTable {
+  // Type of key accepted by lookups, see |HashTable|.
+  template <typename K>
+  using key_arg = typename hash_table::KeyArg<
+      hash_table::is_transparent<HashType>::value &&
+      hash_table::is_transparent<EqualType>::value>::template type<K, KeyType>;
+
+ public:
+  FilteredHashTable();
+  explicit FilteredHashTable(const HashType& hasher,
+                             const EqualType& equal = EqualType());
+
+  // Add the given key and value to hash table. If key exists, replace old value
+  // with given value.
+  void set(const KeyType& key, const ValueType& value);
+  void set(KeyType&& key, ValueType&& value);
+
+  // Returns value at given key. If key doesn't exist, return
+  // |hash_table::null_value()|.
+  template <typename K = KeyType>
+  ValueType get(const key_arg<K>& key);
+
+  // Return pointer to value at given key, or nullptr if key doesn't exist.
+  // The pointer is valid until the table is modified.
+  template <typename K = KeyType>
+  ValueType* find(const key_arg<K>& key);
+
+  // Removes value at given key. If key doesn't exist, does nothing
+  template <typename K = KeyType>
+  void remove(const key_arg<K>& key);
+
+  // Removes value at given key. Return true if key existed.
+  template <typename K = KeyType>
+  bool erase(const key_arg<K>& key);
+
+  // Return false if key certainly isn't in table, only reads the filter.
+  template <typename K = KeyType>
+  bool may_contain(const key_arg<K>& key) const;
+
+  // Return number of items are currently stored in hash table.
+  std::size_t size() const;
+
+  // Return bytes allocated for the filter.
+  std::size_t filter_memory_usage() const;
+
+ private:
+  // Add new key with |hash_value| to filter, rebuilding it if table
+  // outgrew it.
+  void add_to_filter(std::size_t hash_value);
+
+  // Make a filter for twice the current number of items and add every key
+  // of |table_| to it.
+  void rebuild_filter();
+
+  // Hash function of keys, same as |table_| uses.
+  HashType hasher_;
+
+  HashTable<KeyType, ValueType, HashType, EqualType, ProbingType> table_;
+
+  BloomFilter filter_;
+
+  // Number of items |filter_| was sized for.
+  std::size_t filter_capacity_{0};
+
+  // Number of removed keys which |filter_| still holds.
+  std::size_t stale_count_{0};
+
+  DISALLOW_COPY_AND_ASSIGN(FilteredHashTable);
+};
+
+}  // namespace td
+
+/****************  Filtered hash table implementation ****************/
+namespace td {
+
+// Public
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+FilteredHashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::
+    FilteredHashTable()
+    : FilteredHashTable(HashType()) {}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+FilteredHashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::
+    FilteredHashTable(const HashType& hasher, const EqualType& equal)
+    : hasher_(hasher), table_(hasher, equal) {
+  rebuild_filter();
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+void FilteredHashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::
+    set(const KeyType& key, const ValueType& value) {
+  std::size_t hash_value = hasher_(key);
+  if (table_.insert_or_assign(key, value, hash_value).second)
+    add_to_filter(hash_value);
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+void FilteredHashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::
+    set(KeyType&& key, ValueType&& value) {
+  // |key| may be moved into the table, hash it first.
+  std::size_t hash_value = hasher_(key);
+  if (table_.insert_or_assign(std::move(key), std::move(value), hash_value)
+          .second)
+    add_to_filter(hash_value);
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+template <typename K>
+ValueType
+FilteredHashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::get(
+    const key_arg<K>& key) {
+  ValueType* value = find<K>(key);
+  if (!value)
+    return hash_table::null_value<ValueType>();
+  return *value;
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+template <typename K>
+ValueType*
+FilteredHashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::find(
+    const key_arg<K>& key) {
+  std::size_t hash_value = hasher_(key);
+  if (!filter_.may_contain(hash_value))
+    return nullptr;
+  return table_.template find<K>(key, hash_value);
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+template <typename K>
+void FilteredHashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::
+    remove(const key_arg<K>& key) {
+  erase<K>(key);
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+template <typename K>
+bool FilteredHashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::
+    erase(const key_arg<K>& key) {
+  if (!table_.template erase<K>(key))
+    return false;
+
+  ++stale_count_;
+  if (stale_count_ > table_.size())
+    rebuild_filter();
+  return true;
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+template <typename K>
+bool FilteredHashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::
+    may_contain(const key_arg<K>& key) const {
+  return filter_.may_contain(hasher_(key));
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+std::size_t
+FilteredHashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::size()
+    const {
+  return table_.size();
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+std::size_t FilteredHashTable<KeyType, ValueType, HashType, EqualType,
+                              ProbingType>::filter_memory_usage() const {
+  return filter_.memory_usage();
+}
+
+// Private
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+void FilteredHashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::
+    add_to_filter(std::size_t hash_value) {
+  if (table_.size() > filter_capacity_)
+    rebuild_filter();
+  else
+    filter_.insert(hash_value);
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+void FilteredHashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::
+    rebuild_filter() {
+  filter_capacity_ = 2 * table_.size();
+  if (filter_capacity_ < static_cast<std::size_t>(default_capacity))
+    filter_capacity_ = default_capacity;
+
+  filter_ = BloomFilter(filter_capacity_);
+  for (auto item : table_)
+    filter_.insert(hasher_(item.key));
+  stale_count_ = 0;
+}
+
+}  // namespace td
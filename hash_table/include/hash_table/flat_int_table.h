@@ -0,0 +1,339 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "utils/utils.h"
+
+namespace td {
+
+namespace hash_table {
+
+// Keys of |FlatIntSet| and |FlatIntMap|: |capacity| slots of linear probing,
+// stored inline, with capacity, mask and hash known at compile time.
+//
+// Key 0 marks an empty slot, so it's never stored in a slot. Instead it has
+// an extra slot at index |capacity|, used while |has_zero_| is set. Removal
+// shifts following keys back, so there are no tombstones.
+template <typename KeyType, std::size_t max_size>
+class FlatIntKeys {
+  static_assert(std::is_integral<KeyType>::value, "keys must be integers");
+  static_assert(max_size > 0, "max_size must be positive");
+
+ public:
+  // Number of slots, a power of two at least twice |max_size|, so probe runs
+  // stay short.
+  static constexpr std::size_t capacity = [] {
+    std::size_t result = 16;
+    while (result < 2 * max_size)
+      result *= 2;
+    return result;
+  }();
+
+  static constexpr std::size_t mask = capacity - 1;
+
+  // Return slot where probing for |key| starts: upper bits of |key| times
+  // 2^64 / golden ratio, which spreads sequential keys evenly.
+  static constexpr std::size_t home_index(KeyType key) {
+    return static_cast<std::size_t>(
+        (static_cast<std::uint64_t>(key) * 0x9e3779b97f4a7c15ULL) >> shift);
+  }
+
+  // Return index of slot which holds |key|, or |index_not_found|.
+  std::size_t find(KeyType key) const;
+
+  // Return index of slot which holds |key| and true if it was just inserted.
+  // Throw std::length_error if |key| is new and there are |max_size| keys.
+  std::pair<std::size_t, bool> insert(KeyType key);
+
+  // Remove key at |index|. For every key shifted back from slot i to slot j,
+  // call |move(i, j)|.
+  template <typename Move>
+  void erase_at(std::size_t index, Move&& move);
+
+  // Remove all keys. Takes time proportional to |capacity|.
+  void clear();
+
+  // Call |function| with index of every slot which holds a key.
+  template <typename Function>
+  void for_each_index(Function&& function) const;
+
+  // Return key at |index|.
+  KeyType key(std::size_t index) const { return keys_[index]; }
+
+  std::size_t size() const { return size_; }
+
+ private:
+  static constexpr unsigned shift = [] {
+    unsigned bits = 0;
+    while ((std::size_t{1} << bits) < capacity)
+      ++bits;
+    return 64 - bits;
+  }();
+
+  std::array<KeyType, capacity> keys_{};
+  std::size_t size_{0};
+  bool has_zero_{false};
+};
+
+}  // namespace hash_table
+
+// A set of up to |max_size| integer keys, for hot paths such as dedup
+// filters. All storage is inline, about 2 * |max_size| keys, so it never
+// allocates and can live on the stack or in static storage. Lookups probe
+// consecutive slots, usually one or two.
+template <std::size_t max_size, typename KeyType = std::uint64_t>
+class FlatIntSet {
+ public:
+  // Add |key|. Return true if it was added, false if it was already there.
+  // Throw std::length_error if set already holds |max_size| keys.
+  bool insert(KeyType key) { return keys_.insert(key).second; }
+
+  // Return true if set holds |key|.
+  bool contains(KeyType key) const {
+    return keys_.find(key) != index_not_found;
+  }
+
+  // Removes |key|. Return true if it was there.
+  bool erase(KeyType key);
+
+  // Remove all keys.
+  void clear() { keys_.clear(); }
+
+  // Call |function| with every key, in no particular order.
+  template <typename Function>
+  void for_each(Function&& function) const;
+
+  // Return number of keys are currently stored in set.
+  std::size_t size() const { return keys_.size(); }
+
+  // Return number of slots, fixed at compile time.
+  static constexpr std::size_t capacity() {
+    return hash_table::FlatIntKeys<KeyType, max_size>::capacity;
+  }
+
+ private:
+  hash_table::FlatIntKeys<KeyType, max_size> keys_;
+};
+
+// A map from up to |max_size| integer keys to values, with the same storage
+// and probing as |FlatIntSet|. |ValueType| must be default constructible, a
+// value is kept for every slot.
+template <std::size_t max_size,
+          typename ValueType,
+          typename KeyType = std::uint64_t>
+class FlatIntMap {
+  static_assert(std::is_default_constructible<ValueType>::value,
+                "values must be default constructible");
+
+ public:
+  // Add the given key and value to map. If key exists, replace old value with
+  // given value. Throw std::length_error if key is new and map already holds
+  // |max_size| keys.
+  void set(KeyType key, const ValueType& value);
+  void set(KeyType key, ValueType&& value);
+
+  // Returns value at given key. If key doesn't exist, return a
+  // value-initialized |ValueType|.
+  ValueType get(KeyType key) const;
+
+  // Return pointer to value at given key, or nullptr if key doesn't exist.
+  // The pointer is valid until the map is modified.
+  ValueType* find(KeyType key);
+
+  // Return true if map holds |key|.
+  bool contains(KeyType key) const {
+    return keys_.find(key) != index_not_found;
+  }
+
+  // Removes value at given key. Return true if key existed.
+  bool erase(KeyType key);
+
+  // Remove all keys, values are kept until their slots are reused.
+  void clear() { keys_.clear(); }
+
+  // Call |function| with key and value of every item, in no particular
+  // order.
+  template <typename Function>
+  void for_each(Function&& function) const;
+
+  // Return number of items are currently stored in map.
+  std::size_t size() const { return keys_.size(); }
+
+  // Return number of slots, fixed at compile time.
+  static constexpr std::size_t capacity() {
+    return hash_table::FlatIntKeys<KeyType, max_size>::capacity;
+  }
+
+ private:
+  hash_table::FlatIntKeys<KeyType, max_size> keys_;
+
+  // Value of key in slot i, including the slot of key 0.
+  std::array<ValueType, capacity() + 1> values_{};
+};
+
+}  // namespace td
+
+/****************  Flat int table implementation ****************/
+namespace td {
+namespace hash_table {
+
+template <typename KeyType, std::size_t max_size>
+std::size_t FlatIntKeys<KeyType, max_size>::find(KeyType key) const {
+  if (key == 0)
+    return has_zero_ ? capacity : index_not_found;
+
+  for (std::size_t index = home_index(key);; index = (index + 1) & mask) {
+    if (keys_[index] == key)
+      return index;
+    if (keys_[index] == 0)
+      return index_not_found;
+  }
+}
+
+template <typename KeyType, std::size_t max_size>
+std::pair<std::size_t, bool> FlatIntKeys<KeyType, max_size>::insert(
+    KeyType key) {
+  if (key == 0) {
+    if (has_zero_)
+      return {capacity, false};
+    if (size_ == max_size)
+      throw std::length_error("FlatIntKeys: table is full");
+    has_zero_ = true;
+    ++size_;
+    return {capacity, true};
+  }
+
+  for (std::size_t index = home_index(key);; index = (index + 1) & mask) {
+    if (keys_[index] == key)
+      return {index, false};
+    if (keys_[index] == 0) {
+      if (size_ == max_size)
+        throw std::length_error("FlatIntKeys: table is full");
+      keys_[index] = key;
+      ++size_;
+      return {index, true};
+    }
+  }
+}
+
+template <typename KeyType, std::size_t max_size>
+template <typename Move>
+void FlatIntKeys<KeyType, max_size>::erase_at(std::size_t index, Move&& move) {
+  --size_;
+  if (index == capacity) {
+    has_zero_ = false;
+    return;
+  }
+
+  // A following key moves into the hole unless its home slot lies after the
+  // hole, in which case a lookup never passes the hole to reach it.
+  for (std::size_t next = (index + 1) & mask; keys_[next] != 0;
+       next = (next + 1) & mask) {
+    std::size_t distance = (next - home_index(keys_[next])) & mask;
+    if (distance >= ((next - index) & mask)) {
+      keys_[index] = keys_[next];
+      move(next, index);
+      index = next;
+    }
+  }
+  keys_[index] = 0;
+}
+
+template <typename KeyType, std::size_t max_size>
+void FlatIntKeys<KeyType, max_size>::clear() {
+  keys_.fill(0);
+  size_ = 0;
+  has_zero_ = false;
+}
+
+template <typename KeyType, std::size_t max_size>
+template <typename Function>
+void FlatIntKeys<KeyType, max_size>::for_each_index(
+    Function&& function) const {
+  for (std::size_t index = 0; index < capacity; ++index) {
+    if (keys_[index] != 0)
+      function(index);
+  }
+  if (has_zero_)
+    function(capacity);
+}
+
+}  // namespace hash_table
+
+// Flat int set
+
+template <std::size_t max_size, typename KeyType>
+bool FlatIntSet<max_size, KeyType>::erase(KeyType key) {
+  std::size_t index = keys_.find(key);
+  if (index == index_not_found)
+    return false;
+
+  keys_.erase_at(index, [](std::size_t, std::size_t) {});
+  return true;
+}
+
+template <std::size_t max_size, typename KeyType>
+template <typename Function>
+void FlatIntSet<max_size, KeyType>::for_each(Function&& function) const {
+  keys_.for_each_index([&](std::size_t index) {
+    function(index == capacity() ? KeyType(0) : keys_.key(index));
+  });
+}
+
+// Flat int map
+
+template <std::size_t max_size, typename ValueType, typename KeyType>
+void FlatIntMap<max_size, ValueType, KeyType>::set(KeyType key,
+                                                   const ValueType& value) {
+  values_[keys_.insert(key).first] = value;
+}
+
+template <std::size_t max_size, typename ValueType, typename KeyType>
+void FlatIntMap<max_size, ValueType, KeyType>::set(KeyType key,
+                                                   ValueType&& value) {
+  values_[keys_.insert(key).first] = std::move(value);
+}
+
+template <std::size_t max_size, typename ValueType, typename KeyType>
+ValueType FlatIntMap<max_size, ValueType, KeyType>::get(KeyType key) const {
+  std::size_t index = keys_.find(key);
+  if (index == index_not_found)
+    return ValueType();
+  return values_[index];
+}
+
+template <std::size_t max_size, typename ValueType, typename KeyType>
+ValueType* FlatIntMap<max_size, ValueType, KeyType>::find(KeyType key) {
+  std::size_t index = keys_.find(key);
+  if (index == index_not_found)
+    return nullptr;
+  return &values_[index];
+}
+
+template <std::size_t max_size, typename ValueType, typename KeyType>
+bool FlatIntMap<max_size, ValueType, KeyType>::erase(KeyType key) {
+  std::size_t index = keys_.find(key);
+  if (index == index_not_found)
+    return false;
+
+  keys_.erase_at(index, [this](std::size_t from, std::size_t to) {
+    values_[to] = std::move(values_[from]);
+  });
+  return true;
+}
+
+template <std::size_t max_size, typename ValueType, typename KeyType>
+template <typename Function>
+void FlatIntMap<max_size, ValueType, KeyType>::for_each(
+    Function&& function) const {
+  keys_.for_each_index([&](std::size_t index) {
+    function(index == capacity() ? KeyType(0) : keys_.key(index),
+             values_[index]);
+  });
+}
+
+}  // namespace td
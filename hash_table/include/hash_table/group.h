@@ -0,0 +1,163 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace td {
+namespace hash_table {
+
+// Each slot of hash table has a control byte stored in a separate array.
+// Empty and deleted slots have the sign bit set, a full slot keeps the lower
+// 7 bits of its key's hash so probing can skip most mismatches without
+// touching the key.
+using ctrl_t = std::int8_t;
+
+constexpr ctrl_t empty_ctrl = -128;  // 0b10000000
+constexpr ctrl_t deleted_ctrl = -2;  // 0b11111110
+
+// Number of control bytes which are matched at once. Table capacity is always
+// a multiple of it.
+constexpr std::size_t group_width = 16;
+
+// Return true if slot with given control byte holds a node.
+inline bool is_full(ctrl_t ctrl) {
+  return ctrl >= 0;
+}
+
+// Set of slots in a group, bit i represents slot i.
+class BitMask {
+ public:
+  explicit BitMask(std::uint32_t mask) : mask_(mask) {}
+
+  // Return true if at least one slot is in the set.
+  bool any() const { return mask_ != 0; }
+
+  // Return index of lowest slot in the set. The set must not be empty.
+  std::size_t lowest() const { return __builtin_ctz(mask_); }
+
+  // Remove lowest slot from the set.
+  void clear_lowest() { mask_ &= mask_ - 1; }
+
+ private:
+  std::uint32_t mask_;
+};
+
+// |group_width| consecutive control bytes loaded together. With SSE2 each
+// match is a single compare and movemask, otherwise bytes are checked one by
+// one.
+class Group {
+ public:
+  explicit Group(const ctrl_t* ctrl);
+
+  // Return full slots whose control byte is |h2|.
+  BitMask match(ctrl_t h2) const;
+
+  // Return empty slots.
+  BitMask match_empty() const;
+
+  // Return empty or deleted slots.
+  BitMask match_free() const;
+
+  // Return full slots.
+  BitMask match_full() const;
+
+ private:
+#if defined(__SSE2__)
+  __m128i ctrl_;
+#else
+  const ctrl_t* ctrl_;
+#endif
+};
+
+// Visits groups of a table with |group_count| groups (a power of two) in
+// triangular order, starting at group picked by |hash_value|. Every group is
+// visited once in the first |group_count| steps.
+class ProbeSequence {
+ public:
+  ProbeSequence(std::size_t hash_value, std::size_t group_count)
+      : mask_(group_count - 1), group_(hash_value & mask_) {}
+
+  // Index of first slot of current group.
+  std::size_t offset() const { return group_ * group_width; }
+
+  // Move to next group.
+  void next() {
+    ++step_;
+    group_ = (group_ + step_) & mask_;
+  }
+
+ private:
+  std::size_t mask_;
+  std::size_t group_;
+  std::size_t step_{0};
+};
+
+}  // namespace hash_table
+}  // namespace td
+
+/****************  Group implementation ****************/
+namespace td {
+namespace hash_table {
+
+#if defined(__SSE2__)
+
+inline Group::Group(const ctrl_t* ctrl)
+    : ctrl_(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl))) {}
+
+inline BitMask Group::match(ctrl_t h2) const {
+  __m128i matched = _mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl_);
+  return BitMask(static_cast<std::uint32_t>(_mm_movemask_epi8(matched)));
+}
+
+inline BitMask Group::match_empty() const {
+  __m128i matched = _mm_cmpeq_epi8(_mm_set1_epi8(empty_ctrl), ctrl_);
+  return BitMask(static_cast<std::uint32_t>(_mm_movemask_epi8(matched)));
+}
+
+inline BitMask Group::match_free() const {
+  // Empty and deleted are the only control bytes with the sign bit set
+  return BitMask(static_cast<std::uint32_t>(_mm_movemask_epi8(ctrl_)));
+}
+
+inline BitMask Group::match_full() const {
+  return BitMask(static_cast<std::uint32_t>(_mm_movemask_epi8(ctrl_)) ^
+                 0xFFFF);
+}
+
+#else
+
+inline Group::Group(const ctrl_t* ctrl) : ctrl_(ctrl) {}
+
+inline BitMask Group::match(ctrl_t h2) const {
+  std::uint32_t mask = 0;
+  for (std::size_t i = 0; i < group_width; ++i)
+    mask |= static_cast<std::uint32_t>(ctrl_[i] == h2) << i;
+  return BitMask(mask);
+}
+
+inline BitMask Group::match_empty() const {
+  return match(empty_ctrl);
+}
+
+inline BitMask Group::match_free() const {
+  std::uint32_t mask = 0;
+  for (std::size_t i = 0; i < group_width; ++i)
+    mask |= static_cast<std::uint32_t>(!is_full(ctrl_[i])) << i;
+  return BitMask(mask);
+}
+
+inline BitMask Group::match_full() const {
+  std::uint32_t mask = 0;
+  for (std::size_t i = 0; i < group_width; ++i)
+    mask |= static_cast<std::uint32_t>(is_full(ctrl_[i])) << i;
+  return BitMask(mask);
+}
+
+#endif
+
+}  // namespace hash_table
+}  // namespace td
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace td {
+
+// Default hasher of |HashTable|. Integers and enums are spread by a
+// multiplicative mixer, strings go through |hash_table::hash_bytes|, other
+// types use |std::hash| and have its result mixed.
+template <typename Key, typename Enable = void>
+struct Hash;
+
+namespace hash_table {
+
+// Multiply |a| and |b| into 128 bits and fold upper half into lower half, so
+// every input bit affects every output bit.
+inline std::uint64_t mix(std::uint64_t a, std::uint64_t b) {
+#if defined(__SIZEOF_INT128__)
+  unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+  return static_cast<std::uint64_t>(product) ^
+         static_cast<std::uint64_t>(product >> 64);
+#else
+  // Without 128-bit multiplication, fall back to murmur3 finalizer.
+  std::uint64_t hash = a ^ b;
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccdULL;
+  hash ^= hash >> 33;
+  hash *= 0xc4ceb9fe1a85ec53ULL;
+  hash ^= hash >> 33;
+  return hash;
+#endif
+}
+
+// Hash |length| bytes at |data|, 8 or 16 bytes per step. Follows structure
+// of wyhash (https://github.com/wangyi-fudan/wyhash).
+inline std::uint64_t hash_bytes(const void* data, std::size_t length) {
+  constexpr std::uint64_t secret[4] = {
+      0x2d358dccaa6c78a5ULL, 0x8bb84b93962eacc9ULL, 0x4b33a62ed433d4a3ULL,
+      0x4d5a2da51de1aa47ULL};
+
+  auto read8 = [](const unsigned char* p) {
+    std::uint64_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+  };
+  auto read4 = [](const unsigned char* p) {
+    std::uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return static_cast<std::uint64_t>(value);
+  };
+
+  const unsigned char* p = static_cast<const unsigned char*>(data);
+  std::uint64_t seed = mix(secret[0], secret[1]);
+  std::uint64_t a = 0;
+  std::uint64_t b = 0;
+
+  if (length <= 16) {
+    if (length >= 4) {
+      std::size_t middle = (length >> 3) << 2;
+      a = (read4(p) << 32) | read4(p + middle);
+      b = (read4(p + length - 4) << 32) | read4(p + length - 4 - middle);
+    } else if (length > 0) {
+      a = (static_cast<std::uint64_t>(p[0]) << 16) |
+          (static_cast<std::uint64_t>(p[length >> 1]) << 8) | p[length - 1];
+    }
+  } else {
+    std::size_t remain = length;
+    if (remain > 48) {
+      std::uint64_t seed1 = seed;
+      std::uint64_t seed2 = seed;
+      do {
+        seed = mix(read8(p) ^ secret[1], read8(p + 8) ^ seed);
+        seed1 = mix(read8(p + 16) ^ secret[2], read8(p + 24) ^ seed1);
+        seed2 = mix(read8(p + 32) ^ secret[3], read8(p + 40) ^ seed2);
+        p += 48;
+        remain -= 48;
+      } while (remain > 48);
+      seed ^= seed1 ^ seed2;
+    }
+
+    while (remain > 16) {
+      seed = mix(read8(p) ^ secret[1], read8(p + 8) ^ seed);
+      p += 16;
+      remain -= 16;
+    }
+
+    a = read8(p + remain - 16);
+    b = read8(p + remain - 8);
+  }
+
+  return mix(secret[1] ^ length, mix(a ^ secret[1], b ^ seed));
+}
+
+// Hash of an integer key.
+inline std::uint64_t hash_integer(std::uint64_t key) {
+  return mix(key, 0x9e3779b97f4a7c15ULL);
+}
+
+// Hasher of string keys. It's transparent, so a table with std::string keys
+// can be searched by std::string_view or const char* without building a
+// temporary std::string.
+struct StringHash {
+  using is_transparent = void;
+
+  std::size_t operator()(std::string_view key) const {
+    return hash_bytes(key.data(), key.size());
+  }
+};
+
+}  // namespace hash_table
+
+template <typename Key, typename Enable>
+struct Hash {
+  std::size_t operator()(const Key& key) const {
+    return hash_table::hash_integer(std::hash<Key>()(key));
+  }
+};
+
+template <typename Key>
+struct Hash<Key,
+            std::enable_if_t<std::is_integral<Key>::value ||
+                             std::is_enum<Key>::value>> {
+  std::size_t operator()(Key key) const {
+    return hash_table::hash_integer(static_cast<std::uint64_t>(key));
+  }
+};
+
+template <>
+struct Hash<std::string> : hash_table::StringHash {};
+
+template <>
+struct Hash<std::string_view> : hash_table::StringHash {};
+
+}  // namespace td
@@ -1,85 +1,604 @@
 #pragma once
 
+#include <functional>
+#include <iterator>
+#include <new>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
+#include "hash_table/group.h"
+#include "hash_table/hash.h"
 #include "utils/macros.h"
 #include "utils/utils.h"
 
 namespace td {
 
 // Capacity of hash table after it's initialized
-constexpr int default_capacity = 11;
+constexpr int default_capacity = hash_table::group_width;
 
-// Key and value of the null node
-constexpr char null_node_key[] = "HashTable::Node::null::key";
+// Value returned by |HashTable::get| when key doesn't exist
 constexpr char null_node_value[] = "HashTable::Node::null::value";
 
-// Key and value of the dummy node
-constexpr char dummy_node_key[] = "HashTable::Node::dummy::key";
-constexpr char dummy_node_value[] = "HashTable::Node::dummy::value";
-
-constexpr float growth_factor = 0.5f;
+constexpr float growth_factor = 0.875f;
 constexpr float shrink_factor = 0.2f;
 
-// A hash table template with std::string key type.
+namespace hash_table {
+
+// Determine |T| declares |is_transparent| or not.
+template <typename T, typename = void>
+struct is_transparent : std::false_type {};
+
+template <typename T>
+struct is_transparent<T, std::void_t<typename T::is_transparent>>
+    : std::true_type {};
+
+// Value returned by |get| of hash tables when key doesn't exist:
+// |null_node_value| for string values, otherwise a value-initialized
+// |ValueType|. Other types made from const char*, like bool or pointers,
+// would read a missing key as a set one.
 template <typename ValueType>
+ValueType null_value() {
+  if constexpr (std::is_same<ValueType, std::string>::value ||
+                std::is_same<ValueType, std::string_view>::value) {
+    return ValueType(null_node_value);
+  } else {
+    return ValueType();
+  }
+}
+
+// Type of key accepted by lookups: |K| if lookups are heterogeneous,
+// otherwise |KeyType|. Being an alias, |K| stays deducible.
+template <bool heterogeneous>
+struct KeyArg {
+  template <typename K, typename KeyType>
+  using type = KeyType;
+};
+
+template <>
+struct KeyArg<true> {
+  template <typename K, typename KeyType>
+  using type = K;
+};
+
+// Specifies how nodes are moved when hash table is reallocated.
+enum class Rehash {
+  // Move all nodes to the new table at once. The operation which triggers
+  // reallocation pays for the whole table.
+  kAllAtOnce,
+
+  // Keep old table alive and move |rehash_step| groups of it on every
+  // modification. Lookups check both tables until old one is empty.
+  kIncremental
+};
+
+// Number of groups of old table moved by each modification in
+// |Rehash::kIncremental| mode.
+constexpr std::size_t rehash_step = 1;
+
+// Number of keys whose first group |HashTable::get_many| prefetches before
+// probing any of them.
+constexpr std::size_t prefetch_batch = 16;
+
+// Probing policies of |HashTable|.
+//
+// Probe groups of |group_width| control bytes in triangular order, matching
+// 7 bits of hash of all slots of a group at once. Removed slots may be left
+// as |deleted_ctrl| tombstones, which are cleared by rehashing.
+struct GroupProbing {};
+
+// Probe slot by slot with Robin Hood insertion: a new node takes the slot of
+// any node which is closer to its own home slot, so probe lengths stay even
+// and lookups of missing keys stop early. Removal shifts following nodes
+// back, no tombstones are ever left. Control byte of a full slot holds its
+// distance from home slot, saturated at |max_distance_ctrl|.
+struct RobinHoodProbing {};
+
+// Largest distance stored in a control byte by |RobinHoodProbing|, nodes
+// which are further away have their distance computed from their hash.
+constexpr ctrl_t max_distance_ctrl = 127;
+
+// Item visited by |HashTable| iterators. |V| is const for const iterators,
+// keys are never modifiable.
+template <typename K, typename V>
+struct Item {
+  const K& key;
+  V& value;
+};
+
+// Counters of a |HashTable|, see |HashTable::stats|.
+struct Stats {
+  // Number of items.
+  std::size_t size{0};
+
+  // Number of slots of the table where new items are added.
+  std::size_t capacity{0};
+
+  // Number of slots marked as |deleted_ctrl|.
+  std::size_t tombstones{0};
+
+  // Average and longest probe length of stored items, in the same units as
+  // |HashTable::probe_histogram|. Found items are never probed longer.
+  double average_probe_length{0};
+  std::size_t max_probe_length{0};
+
+  // Number of reallocations since table was created.
+  std::size_t rehash_count{0};
+
+  // Return share of slots which hold an item.
+  double load_factor() const {
+    return capacity ? static_cast<double>(size) / capacity : 0.0;
+  }
+};
+
+}  // namespace hash_table
+
+// A hash table template. |HashType| and |EqualType| hash and compare keys.
+// When both of them declare |is_transparent|, lookups accept any type they
+// can hash and compare with |KeyType|, e.g. std::string_view for std::string
+// keys.
+//
+// By default a reallocation moves every node at once. Tables which can't
+// afford such latency spike should use |Rehash::kIncremental|.
+//
+// |ProbingType| is |hash_table::GroupProbing| or
+// |hash_table::RobinHoodProbing|. Tables with heavy insert and remove churn
+// should prefer the latter, which never leaves tombstones.
+template <typename KeyType,
+          typename ValueType,
+          typename HashType = Hash<KeyType>,
+          typename EqualType = std::equal_to<>,
+          typename ProbingType = hash_table::GroupProbing>
 class HashTable {
+  // Type of key accepted by lookups.
+  template <typename K>
+  using key_arg = typename hash_table::KeyArg<
+      hash_table::is_transparent<HashType>::value &&
+      hash_table::is_transparent<EqualType>::value>::template type<K, KeyType>;
+
  public:
+  // Forward iterators over items, see |begin|.
+  template <bool is_const>
+  class Iterator;
+  using iterator = Iterator<false>;
+  using const_iterator = Iterator<true>;
+
   HashTable();
+  explicit HashTable(hash_table::Rehash rehash);
+  explicit HashTable(
+      const HashType& hasher,
+      const EqualType& equal = EqualType(),
+      hash_table::Rehash rehash = hash_table::Rehash::kAllAtOnce);
+
+  // Build hash table from pairs of key and value in [first, last). If range
+  // can be walked twice, table is sized once for all pairs and they are
+  // inserted without growth checks. A later pair replaces an earlier one with
+  // the same key.
+  template <
+      typename InputIt,
+      typename = typename std::iterator_traits<InputIt>::iterator_category>
+  HashTable(InputIt first,
+            InputIt last,
+            const HashType& hasher = HashType(),
+            const EqualType& equal = EqualType(),
+            hash_table::Rehash rehash = hash_table::Rehash::kAllAtOnce);
   ~HashTable();
 
+  // Make room for |count| items, so inserting up to |count| items in total
+  // never reallocates. Capacity never shrinks below it afterwards.
+  void reserve(std::size_t count);
+
   // Add the given key and value to hash table. If key exists, replace old value
-  // with given value
-  void set(const std::string& key, const ValueType& value);
+  // with given value. Rvalue arguments are moved into the table, a key is only
+  // copied or moved if it's inserted.
+  void set(const KeyType& key, const ValueType& value);
+  void set(const KeyType& key, ValueType&& value);
+  void set(KeyType&& key, ValueType&& value);
 
-  // Returns value at given key. If key doesn't exist, return value of null node
-  ValueType get(const std::string& key);
+  // Returns value at given key. If key doesn't exist, return
+  // |hash_table::null_value()|.
+  template <typename K = KeyType>
+  ValueType get(const key_arg<K>& key);
+
+  // Write value of every key of |keys| to |out| in order, same as |get|.
+  // Groups of keys are hashed and their slots prefetched before they are
+  // probed, so cache misses of a group overlap. |keys| is walked twice.
+  template <typename KeyRange, typename OutputIt>
+  void get_many(const KeyRange& keys, OutputIt out);
 
   // Removes value at given key. If key doesn't exist, does nothing
-  void remove(const std::string& key);
+  template <typename K = KeyType>
+  void remove(const key_arg<K>& key);
+
+  // Return pointer to value at given key, or nullptr if key doesn't exist.
+  // The pointer is valid until the table is modified.
+  template <typename K = KeyType>
+  ValueType* find(const key_arg<K>& key);
+
+  // If key doesn't exist, add it with value constructed from |args|. If it
+  // exists, does nothing and |args| are left untouched. Return pointer to
+  // value at given key and whether it was inserted.
+  template <typename... Args>
+  std::pair<ValueType*, bool> try_emplace(const KeyType& key, Args&&... args);
+  template <typename... Args>
+  std::pair<ValueType*, bool> try_emplace(KeyType&& key, Args&&... args);
+
+  // Same as |try_emplace|, but key is also constructed in place from |key|.
+  // If lookups are heterogeneous and |key| can be hashed directly, no
+  // |KeyType| is made unless key is inserted, e.g. a const char* for
+  // std::string keys. Otherwise a |KeyType| is made from |key| first.
+  template <typename K, typename... Args>
+  std::pair<ValueType*, bool> emplace(K&& key, Args&&... args);
+
+  // Add the given key and value to hash table, or assign |value| to existing
+  // key. Return pointer to value at given key and whether it was inserted.
+  template <typename V>
+  std::pair<ValueType*, bool> insert_or_assign(const KeyType& key, V&& value);
+  template <typename V>
+  std::pair<ValueType*, bool> insert_or_assign(KeyType&& key, V&& value);
+
+  // Removes value at given key. Return true if key existed.
+  template <typename K = KeyType>
+  bool erase(const key_arg<K>& key);
+
+  // Same as |find|, |set|, |insert_or_assign| and |erase|, but key isn't
+  // hashed again: |hash_value| must be what this table's hasher returns for
+  // it. Meant for containers which already hash the key with a copy of the
+  // hasher, e.g. to pick one of several tables or to check a filter.
+  template <typename K = KeyType>
+  ValueType* find(const key_arg<K>& key, std::size_t hash_value);
+  void set(const KeyType& key, const ValueType& value, std::size_t hash_value);
+  template <typename V>
+  std::pair<ValueType*, bool> insert_or_assign(const KeyType& key,
+                                               V&& value,
+                                               std::size_t hash_value);
+  template <typename V>
+  std::pair<ValueType*, bool> insert_or_assign(KeyType&& key,
+                                               V&& value,
+                                               std::size_t hash_value);
+  template <typename K = KeyType>
+  bool erase(const key_arg<K>& key, std::size_t hash_value);
+
+  // Call |function| with key and value of every item, in no particular
+  // order. |function| must not modify the table.
+  template <typename Function>
+  void for_each(Function&& function) const;
+
+  // Return iterator to first item. Items are visited in slot order, so
+  // consecutive items share cache lines and empty groups are skipped 16 slots
+  // at a time. Order of keys is unspecified. Any modification of the table
+  // invalidates iterators, assigning to values through them doesn't.
+  iterator begin();
+  const_iterator begin() const;
+  iterator end();
+  const_iterator end() const;
+
+  // Return number of items are currently stored in hash table.
+  std::size_t size() const;
+
+  // Return size, capacity, tombstones, probe lengths and rehash count.
+  // Probe lengths are kept up to date by every insert and removal, so this
+  // only sums counts of each length and is cheap enough to call often.
+  hash_table::Stats stats() const;
+
+  // Return number of items by probe length, item i is number of items found
+  // after probing i groups (|GroupProbing|) or i slots (|RobinHoodProbing|).
+  // Recounts from scratch by walking the whole table, meant for diagnostics.
+  std::vector<std::size_t> probe_histogram() const;
 
  private:
+  using ctrl_t = hash_table::ctrl_t;
+
+  static constexpr bool robin_hood =
+      std::is_same<ProbingType, hash_table::RobinHoodProbing>::value;
+
+  // Whether |K| can be hashed and compared with keys without making a
+  // |KeyType| first.
+  template <typename K>
+  using is_key_arg = std::integral_constant<
+      bool,
+      std::is_same<std::decay_t<K>, KeyType>::value ||
+          (hash_table::is_transparent<HashType>::value &&
+           hash_table::is_transparent<EqualType>::value &&
+           std::is_invocable<const HashType&, const K&>::value)>;
+
   // Node's data type
   struct Node {
-    std::string key;
+    KeyType key;
     ValueType value;
 
-    Node() = default;
-    Node(const std::string& k, const ValueType& v) : key(k), value(v) {}
+    // Nodes are only constructed in place and moved, never copied.
+    template <typename K, typename... Args>
+    Node(K&& k, Args&&... args)
+        : key(std::forward<K>(k)), value(std::forward<Args>(args)...) {}
+  };
+
+  // Control bytes and slots of one allocation.
+  struct Table {
+    // Control bytes of slots, |capacity| items.
+    ctrl_t* ctrl{nullptr};
+
+    // Raw array where items are stored. Only slots which have a full control
+    // byte hold a constructed node.
+    Node* slots{nullptr};
+
+    // Represent size of table, always a power of two and a multiple of
+    // |group_width|. It's 0 if nothing is allocated.
+    std::size_t capacity{0};
+
+    // Number of slots which hold a node.
+    std::size_t size{0};
 
-    static Node null();
-    bool is_null();
+    // Number of slots are marked as |deleted_ctrl|.
+    std::size_t deleted{0};
 
-    static Node dummy();
-    bool is_dummy();
+    // Item i is number of nodes whose probe length is i, see
+    // |probe_histogram|.
+    std::vector<std::size_t> probe_counts;
   };
 
-  // Bases on given key to return a non-negative number smaller than given
-  // capacity
-  std::size_t hash(const std::string& key, std::size_t capacity);
+  // Bases on given key to return a hash value. |probe_start(hash_value)|
+  // picks the first group to probe and |fragment(hash_value)| is stored in
+  // control byte of the slot.
+  template <typename K>
+  std::size_t hash(const K& key);
+
+  // Return smallest capacity which holds |count| items without growing.
+  static std::size_t capacity_for(std::size_t count);
+
+  // Upper bits of |hash_value|, used to pick the first probed group.
+  static std::size_t probe_start(std::size_t hash_value);
+
+  // Lower 7 bits of |hash_value|, stored in control byte of a full slot.
+  static ctrl_t fragment(std::size_t hash_value);
+
+  // Return index of slot of |table| which holds |key|. If key doesn't exist,
+  // return |index_not_found|.
+  template <typename K>
+  std::size_t find_index(const Table& table,
+                         const K& key,
+                         std::size_t hash_value);
+
+  // Return pointer to value at given key in either table, or nullptr.
+  template <typename K>
+  ValueType* find_value(const K& key, std::size_t hash_value);
+
+  // Load control bytes of first group of probe sequence of |hash_value| to
+  // cache.
+  static void prefetch_group(const Table& table, std::size_t hash_value);
+
+  // Load slot of first group of probe sequence of |hash_value| whose control
+  // byte matches to cache.
+  static void prefetch_slot(const Table& table, std::size_t hash_value);
+
+  // Return index of first empty or deleted slot in probe sequence of
+  // |hash_value|. Only used by |GroupProbing|.
+  static std::size_t find_free_index(const Table& table,
+                                     std::size_t hash_value);
+
+  // Return index of the slot where |RobinHoodProbing| starts probing.
+  static std::size_t home_index(const Table& table, std::size_t hash_value);
+
+  // Return distance of full slot at |index| of |table| from its home slot.
+  // Only used by |RobinHoodProbing|.
+  std::size_t distance(const Table& table, std::size_t index) const;
+
+  // Return control byte which stores |distance|.
+  static ctrl_t distance_ctrl(std::size_t distance);
+
+  // Return probe length of node with |hash_value| at |index| of |table|, see
+  // |probe_histogram|.
+  static std::size_t probe_length(const Table& table,
+                                  std::size_t index,
+                                  std::size_t hash_value);
+
+  // Add a node of probe |length| to or remove it from |table.probe_counts|.
+  static void count_probe(Table& table, std::size_t length);
+  static void uncount_probe(Table& table, std::size_t length);
+
+  // Reserve a slot of |table| for a new node with |hash_value|, mark it full
+  // and return its index. Caller must construct a node in that slot.
+  // |RobinHoodProbing| may shift other nodes to make room.
+  std::size_t prepare_insert(Table& table, std::size_t hash_value);
+
+  // Walk probe sequence of |hash_value| once. If |key| exists, return index
+  // of its slot in |table_| and true. Otherwise, mark a free slot of |table_|
+  // as full for |key| and return its index and false, caller must construct
+  // a node in that slot.
+  template <typename K>
+  std::pair<std::size_t, bool> find_or_prepare_insert(const K& key,
+                                                      std::size_t hash_value);
+
+  // Implementation of |try_emplace| and |emplace|, |key| must satisfy
+  // |is_key_arg|.
+  template <typename K, typename... Args>
+  std::pair<ValueType*, bool> emplace_key(K&& key, Args&&... args);
+
+  // Implementation of |insert_or_assign|, |hash_value| is hash of |key|.
+  template <typename K, typename V>
+  std::pair<ValueType*, bool> assign_key(K&& key,
+                                         V&& value,
+                                         std::size_t hash_value);
+
+  // Insert or assign |key| and |value| without migration or growth checks.
+  // Only valid when |reserve| made room for it and no rehash is in progress.
+  template <typename K, typename V>
+  void insert_reserved(K&& key, V&& value);
+
+  // Mark free slot at |index| of |table| as full for a node with
+  // |hash_value|.
+  static void mark_full(Table& table,
+                        std::size_t index,
+                        std::size_t hash_value);
+
+  // Construct a node from |args| in slot at |index| of |table_|, which
+  // |find_or_prepare_insert| or |prepare_insert| marked full for
+  // |hash_value|. If construction throws, slot is freed again.
+  template <typename... Args>
+  void construct_node(std::size_t index,
+                      std::size_t hash_value,
+                      Args&&... args);
+
+  // Destroy node with |hash_value| at |index| of |table| and mark its slot as
+  // free. With |RobinHoodProbing|, following nodes of |table_| are shifted
+  // back, while |old_table_| gets a tombstone so unmigrated nodes stay in
+  // place.
+  void erase_at(Table& table, std::size_t index, std::size_t hash_value);
+
+  // Same as |erase_at| for a slot whose node is already destroyed, or was
+  // never constructed.
+  void free_slot(Table& table, std::size_t index, std::size_t hash_value);
+
+  // Move node at |index| of |from| to a free slot of |table_|. Key and value
+  // are moved, not copied.
+  void move_to_table(Table& from, std::size_t index);
+
+  // Move nodes of next |group_count| groups of |old_table_| to |table_|.
+  // Release |old_table_| once all of its nodes are moved.
+  void migrate(std::size_t group_count);
 
-  // Growth: If |new_size| is greater than |capacity_ * growth_factor|, allocate
-  // |table_| with capacity is smallest prime which is greater or equal than
-  // double current capacity.
+  // Allocate control bytes and uninitialized slots for |capacity| nodes. All
+  // control bytes are |empty_ctrl|.
+  static Table allocate(std::size_t capacity);
+
+  // Destroy all nodes of |table| and release its memory.
+  static void deallocate(Table& table);
+
+  // Growth: If |new_size| is greater than |capacity * growth_factor|, allocate
+  // table with double capacity.
+  //
+  // Shink: If |new_size| is less than |capacity * shrink_factor|, allocate
+  // table with half of current capacity (new capacity is never less than
+  // |min_capacity_|).
   //
-  // Shink: If |new_size| is less than |capacity_ * shrink_factor|,  allocate
-  // |table_| with capacity is smallest prime which is greater or equal than
-  // half of current capacity (new capacity is always greater than
-  // default_capacity).
-  void reallocate_if_needed(std::size_t new_size);
+  // Deleted slots also lengthen probe sequences, so if they fill the table up
+  // to the growth threshold, table is rehashed with same capacity.
+  //
+  // Return true if table is reallocated.
+  bool reallocate_if_needed(std::size_t new_size);
+
+  // Allocate table with given capacity and move nodes to it, all at once or
+  // incrementally depending on |rehash_|. A pending migration is finished
+  // first.
+  void rehash(std::size_t new_capacity);
+
+  // Hash function of keys.
+  HashType hasher_;
+
+  // Determine two keys are equal or not.
+  EqualType equal_;
+
+  // How nodes are moved when table is reallocated.
+  hash_table::Rehash rehash_;
+
+  // Table where new nodes are added.
+  Table table_;
+
+  // Table whose nodes are being moved to |table_|. Only allocated while an
+  // incremental rehash is in progress.
+  Table old_table_;
 
-  // Represent size of |table_|, should be a prime
-  std::size_t capacity_{default_capacity};
+  // Number of slots of |old_table_| which are already migrated.
+  std::size_t migrated_{0};
 
-  // Number of items are currently stored in hash table.
-  std::size_t size_{0};
+  // Capacity which table never shrinks below, raised by |reserve|.
+  std::size_t min_capacity_{default_capacity};
 
-  // Raw array where items are stored.
-  Node* table_{new Node[capacity_]};
+  // Number of times table was reallocated.
+  std::size_t rehash_count_{0};
 
   DISALLOW_COPY_AND_ASSIGN(HashTable);
 };
 
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+template <bool is_const>
+class HashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::
+    Iterator {
+ public:
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = hash_table::
+      Item<KeyType, std::conditional_t<is_const, const ValueType, ValueType>>;
+  using difference_type = std::ptrdiff_t;
+  using reference = value_type;
+
+  // Holds the item, so |it->value| works although items are made on demand.
+  struct pointer {
+    value_type item;
+    const value_type* operator->() const { return &item; }
+  };
+
+  Iterator() = default;
+
+  reference operator*() const {
+    Node& node = table_->slots[index_];
+    return {node.key, node.value};
+  }
+
+  pointer operator->() const { return {**this}; }
+
+  Iterator& operator++() {
+    ++index_;
+    skip_free();
+    return *this;
+  }
+
+  Iterator operator++(int) {
+    Iterator result = *this;
+    ++*this;
+    return result;
+  }
+
+  bool operator==(const Iterator& other) const {
+    return table_ == other.table_ && index_ == other.index_;
+  }
+
+  bool operator!=(const Iterator& other) const { return !(*this == other); }
+
+ private:
+  friend class HashTable;
+
+  // Iterator to first item of |table|, then of |next| if it's not nullptr.
+  Iterator(const Table* table, const Table* next)
+      : table_(table), next_(next) {
+    skip_free();
+  }
+
+  // Move to first full slot from |index_| on. Past last slot of |table_|,
+  // continue with |next_|, or become end iterator.
+  void skip_free() {
+    while (table_) {
+      while (index_ < table_->capacity) {
+        if (index_ % hash_table::group_width == 0 &&
+            !hash_table::Group(table_->ctrl + index_).match_full().any()) {
+          index_ += hash_table::group_width;
+          continue;
+        }
+        if (hash_table::is_full(table_->ctrl[index_]))
+          return;
+        ++index_;
+      }
+
+      table_ = next_;
+      next_ = nullptr;
+      index_ = 0;
+    }
+  }
+
+  // Table being walked, nullptr for end iterator.
+  const Table* table_{nullptr};
+
+  // Table walked after |table_|.
+  const Table* next_{nullptr};
+
+  std::size_t index_{0};
+};
+
 }  // namespace td
 
 /****************  Hash table implementation ****************/
@@ -87,129 +606,1164 @@ namespace td {
 
 // Public
 
-template <typename ValueType>
-HashTable<ValueType>::HashTable() {
-  for (std::size_t i = 0; i < capacity_; ++i) {
-    table_[i] = Node::null();
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+HashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::HashTable()
+    : HashTable(HashType()) {}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+HashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::HashTable(
+    hash_table::Rehash rehash)
+    : HashTable(HashType(), EqualType(), rehash) {}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+HashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::HashTable(
+    const HashType& hasher,
+    const EqualType& equal,
+    hash_table::Rehash rehash)
+    : hasher_(hasher),
+      equal_(equal),
+      rehash_(rehash),
+      table_(allocate(default_capacity)) {}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+template <typename InputIt, typename>
+HashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::HashTable(
+    InputIt first,
+    InputIt last,
+    const HashType& hasher,
+    const EqualType& equal,
+    hash_table::Rehash rehash)
+    : HashTable(hasher, equal, rehash) {
+  using category = typename std::iterator_traits<InputIt>::iterator_category;
+
+  if constexpr (std::is_base_of<std::forward_iterator_tag, category>::value) {
+    reserve(static_cast<std::size_t>(std::distance(first, last)));
+    for (; first != last; ++first) {
+      auto&& item = *first;
+      insert_reserved(std::get<0>(std::forward<decltype(item)>(item)),
+                      std::get<1>(std::forward<decltype(item)>(item)));
+    }
+  } else {
+    for (; first != last; ++first) {
+      auto&& item = *first;
+      insert_or_assign(std::get<0>(std::forward<decltype(item)>(item)),
+                       std::get<1>(std::forward<decltype(item)>(item)));
+    }
   }
 }
 
-template <typename ValueType>
-HashTable<ValueType>::~HashTable() {
-  delete[] table_;
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+HashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::~HashTable() {
+  deallocate(table_);
+  deallocate(old_table_);
 }
 
-template <typename ValueType>
-void HashTable<ValueType>::set(const std::string& key, const ValueType& value) {
-  if (get(key) == null_node_value)
-    reallocate_if_needed(++size_);
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+void HashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::reserve(
+    std::size_t count) {
+  std::size_t capacity = capacity_for(count);
+  if (capacity > min_capacity_)
+    min_capacity_ = capacity;
+
+  // Reserving is done ahead of inserts, so finish the whole rehash now.
+  if (capacity > table_.capacity) {
+    rehash(capacity);
+    if (old_table_.capacity)
+      migrate(old_table_.capacity / hash_table::group_width);
+  }
+}
 
-  std::size_t hash_value = hash(key, capacity_);
-  while (!table_[hash_value].is_null() && !table_[hash_value].is_dummy() &&
-         table_[hash_value].key != key)
-    hash_value = (hash_value + 1) % capacity_;
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+void HashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::set(
+    const KeyType& key,
+    const ValueType& value) {
+  insert_or_assign(key, value);
+}
 
-  table_[hash_value] = Node(key, value);
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+void HashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::set(
+    const KeyType& key,
+    ValueType&& value) {
+  insert_or_assign(key, std::move(value));
 }
 
-template <typename ValueType>
-ValueType HashTable<ValueType>::get(const std::string& key) {
-  std::size_t hash_value = hash(key, capacity_);
-  while (table_[hash_value].is_dummy() ||
-         (!table_[hash_value].is_null() && table_[hash_value].key != key))
-    hash_value = (hash_value + 1) % capacity_;
-  return table_[hash_value].value;
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+void HashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::set(
+    KeyType&& key,
+    ValueType&& value) {
+  insert_or_assign(std::move(key), std::move(value));
 }
 
-template <typename ValueType>
-void HashTable<ValueType>::remove(const std::string& key) {
-  if (get(key) == null_node_value)
-    return;
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+template <typename K>
+ValueType HashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::get(
+    const key_arg<K>& key) {
+  ValueType* value = find<K>(key);
+  if (!value)
+    return hash_table::null_value<ValueType>();
+  return *value;
+}
 
-  reallocate_if_needed(--size_);
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+template <typename KeyRange, typename OutputIt>
+void HashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::get_many(
+    const KeyRange& keys,
+    OutputIt out) {
+  std::size_t hashes[hash_table::prefetch_batch];
 
-  std::size_t hash_value = hash(key, capacity_);
-  while (table_[hash_value].is_dummy() ||
-         (!table_[hash_value].is_null() && table_[hash_value].key != key))
-    hash_value = (hash_value + 1) % capacity_;
+  auto it = std::begin(keys);
+  auto end = std::end(keys);
+  while (it != end) {
+    auto batch_begin = it;
+    std::size_t count = 0;
+    for (; count < hash_table::prefetch_batch && it != end; ++count, ++it) {
+      hashes[count] = hash(*it);
+      prefetch_group(table_, hashes[count]);
+    }
 
-  if (!table_[hash_value].is_null())
-    table_[hash_value] = Node::dummy();
+    // Control bytes of the batch are on their way to cache. Prefetch slots
+    // they point at, then probe.
+    for (std::size_t i = 0; i < count; ++i)
+      prefetch_slot(table_, hashes[i]);
+    it = batch_begin;
+    for (std::size_t i = 0; i < count; ++i, ++it, ++out) {
+      ValueType* value = find_value(*it, hashes[i]);
+      *out = value ? *value : hash_table::null_value<ValueType>();
+    }
+  }
 }
 
-// Private
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+template <typename K>
+void HashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::remove(
+    const key_arg<K>& key) {
+  erase<K>(key);
+}
 
-// http://www.cse.yorku.ca/~oz/hash.html
-// djb2 algorithm
-template <typename ValueType>
-std::size_t HashTable<ValueType>::hash(const std::string& key,
-                                       std::size_t capacity) {
-  unsigned long hash = 5381;
-  for (std::size_t i = 0; i < key.length(); ++i)
-    hash = hash * 33 + key[i];
-  return hash % capacity;
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+template <typename K>
+ValueType*
+HashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::find(
+    const key_arg<K>& key) {
+  return find_value(key, hash(key));
 }
 
-template <typename ValueType>
-void HashTable<ValueType>::reallocate_if_needed(std::size_t new_size) {
-  std::size_t new_capacity = default_capacity;
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+template <typename... Args>
+std::pair<ValueType*, bool>
+HashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::try_emplace(
+    const KeyType& key,
+    Args&&... args) {
+  return emplace_key(key, std::forward<Args>(args)...);
+}
 
-  // Decide |table_| should be allocated or not
-  if (new_size > capacity_ * growth_factor) {
-    new_capacity = utils::next_prime(capacity_ * 2);
-  } else if (new_size < capacity_ * shrink_factor) {
-    new_capacity = utils::next_prime(capacity_ / 2);
-    new_capacity = new_capacity > default_capacity ? new_capacity : default_capacity;
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+template <typename... Args>
+std::pair<ValueType*, bool>
+HashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::try_emplace(
+    KeyType&& key,
+    Args&&... args) {
+  return emplace_key(std::move(key), std::forward<Args>(args)...);
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+template <typename K, typename... Args>
+std::pair<ValueType*, bool>
+HashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::emplace(
+    K&& key,
+    Args&&... args) {
+  if constexpr (is_key_arg<K>::value) {
+    return emplace_key(std::forward<K>(key), std::forward<Args>(args)...);
   } else {
+    return emplace_key(KeyType(std::forward<K>(key)),
+                       std::forward<Args>(args)...);
+  }
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+template <typename V>
+std::pair<ValueType*, bool>
+HashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::
+    insert_or_assign(const KeyType& key, V&& value) {
+  return assign_key(key, std::forward<V>(value), hash(key));
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+template <typename V>
+std::pair<ValueType*, bool>
+HashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::
+    insert_or_assign(KeyType&& key, V&& value) {
+  std::size_t hash_value = hash(key);
+  return assign_key(std::move(key), std::forward<V>(value), hash_value);
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+template <typename K>
+bool HashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::erase(
+    const key_arg<K>& key) {
+  return erase<K>(key, hash(key));
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+template <typename K>
+ValueType*
+HashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::find(
+    const key_arg<K>& key,
+    std::size_t hash_value) {
+  return find_value(key, hash_value);
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+void HashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::set(
+    const KeyType& key,
+    const ValueType& value,
+    std::size_t hash_value) {
+  assign_key(key, value, hash_value);
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+template <typename V>
+std::pair<ValueType*, bool>
+HashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::
+    insert_or_assign(const KeyType& key, V&& value, std::size_t hash_value) {
+  return assign_key(key, std::forward<V>(value), hash_value);
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+template <typename V>
+std::pair<ValueType*, bool>
+HashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::
+    insert_or_assign(KeyType&& key, V&& value, std::size_t hash_value) {
+  return assign_key(std::move(key), std::forward<V>(value), hash_value);
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+template <typename K>
+bool HashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::erase(
+    const key_arg<K>& key,
+    std::size_t hash_value) {
+  if (old_table_.capacity)
+    migrate(hash_table::rehash_step);
+
+  std::size_t index = find_index(table_, key, hash_value);
+  if (index != index_not_found) {
+    erase_at(table_, index, hash_value);
+  } else if (old_table_.capacity &&
+             (index = find_index(old_table_, key, hash_value)) !=
+                 index_not_found) {
+    erase_at(old_table_, index, hash_value);
+  } else {
+    return false;
+  }
+
+  reallocate_if_needed(table_.size + old_table_.size);
+  return true;
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+template <typename Function>
+void HashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::for_each(
+    Function&& function) const {
+  for (const Table* table : {&table_, &old_table_}) {
+    for (std::size_t i = 0; i < table->capacity; ++i) {
+      if (hash_table::is_full(table->ctrl[i]))
+        function(table->slots[i].key, table->slots[i].value);
+    }
+  }
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+typename HashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::
+    iterator
+    HashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::begin() {
+  return iterator(&table_, old_table_.capacity ? &old_table_ : nullptr);
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+typename HashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::
+    const_iterator
+    HashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::begin()
+        const {
+  return const_iterator(&table_,
+                        old_table_.capacity ? &old_table_ : nullptr);
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+typename HashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::
+    iterator
+    HashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::end() {
+  return iterator();
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+typename HashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::
+    const_iterator
+    HashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::end()
+        const {
+  return const_iterator();
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+std::size_t
+HashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::size() const {
+  return table_.size + old_table_.size;
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+hash_table::Stats
+HashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::stats() const {
+  hash_table::Stats stats;
+  stats.size = size();
+  stats.capacity = table_.capacity;
+  stats.tombstones = table_.deleted + old_table_.deleted;
+  stats.rehash_count = rehash_count_;
+
+  std::size_t total_length = 0;
+  for (const Table* table : {&table_, &old_table_}) {
+    const std::vector<std::size_t>& counts = table->probe_counts;
+    for (std::size_t length = 1; length < counts.size(); ++length) {
+      total_length += length * counts[length];
+      if (counts[length] && length > stats.max_probe_length)
+        stats.max_probe_length = length;
+    }
+  }
+  if (stats.size)
+    stats.average_probe_length =
+        static_cast<double>(total_length) / stats.size;
+  return stats;
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+std::vector<std::size_t>
+HashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::
+    probe_histogram() const {
+  std::vector<std::size_t> histogram;
+  for (const Table* table : {&table_, &old_table_}) {
+    for (std::size_t i = 0; i < table->capacity; ++i) {
+      if (!hash_table::is_full(table->ctrl[i]))
+        continue;
+
+      // Count probe steps from first probed slot or group to node's one.
+      std::size_t length = 1;
+      if constexpr (robin_hood) {
+        length += distance(*table, i);
+      } else {
+        hash_table::ProbeSequence sequence(
+            probe_start(hasher_(table->slots[i].key)),
+            table->capacity / hash_table::group_width);
+        for (; sequence.offset() != i - i % hash_table::group_width;
+             sequence.next())
+          ++length;
+      }
+
+      if (histogram.size() <= length)
+        histogram.resize(length + 1);
+      ++histogram[length];
+    }
+  }
+  return histogram;
+}
+
+// Private
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+template <typename K, typename... Args>
+std::pair<ValueType*, bool>
+HashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::emplace_key(
+    K&& key,
+    Args&&... args) {
+  std::size_t hash_value = hash(key);
+  std::pair<std::size_t, bool> result = find_or_prepare_insert(key, hash_value);
+  if (!result.second) {
+    construct_node(result.first, hash_value, std::forward<K>(key),
+                   std::forward<Args>(args)...);
+  }
+  return {&table_.slots[result.first].value, !result.second};
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+template <typename K, typename V>
+std::pair<ValueType*, bool>
+HashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::assign_key(
+    K&& key,
+    V&& value,
+    std::size_t hash_value) {
+  std::pair<std::size_t, bool> result = find_or_prepare_insert(key, hash_value);
+  if (result.second) {
+    table_.slots[result.first].value = std::forward<V>(value);
+  } else {
+    construct_node(result.first, hash_value, std::forward<K>(key),
+                   std::forward<V>(value));
+  }
+  return {&table_.slots[result.first].value, !result.second};
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+template <typename K>
+std::size_t
+HashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::hash(
+    const K& key) {
+  return hasher_(key);
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+std::size_t
+HashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::capacity_for(
+    std::size_t count) {
+  std::size_t capacity = default_capacity;
+  while (count > capacity * growth_factor)
+    capacity *= 2;
+  return capacity;
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+std::size_t
+HashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::probe_start(
+    std::size_t hash_value) {
+  return hash_value >> 7;
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+typename HashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::ctrl_t
+HashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::fragment(
+    std::size_t hash_value) {
+  return static_cast<ctrl_t>(hash_value & 0x7F);
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+template <typename K>
+std::size_t
+HashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::find_index(
+    const Table& table,
+    const K& key,
+    std::size_t hash_value) {
+  if constexpr (robin_hood) {
+    std::size_t mask = table.capacity - 1;
+    std::size_t index = home_index(table, hash_value);
+    for (std::size_t d = 0;; ++d, index = (index + 1) & mask) {
+      ctrl_t ctrl = table.ctrl[index];
+      if (ctrl == hash_table::empty_ctrl)
+        return index_not_found;
+
+      // Only |old_table_| has tombstones, nodes around them stay in place.
+      if (ctrl == hash_table::deleted_ctrl)
+        continue;
+
+      // Nodes are ordered by home slot, so a node closer to its home means
+      // key isn't in the table. Saturated distances can't tell.
+      ctrl_t expected = distance_ctrl(d);
+      if (ctrl < expected)
+        return index_not_found;
+      if (ctrl == expected && equal_(table.slots[index].key, key))
+        return index;
+    }
+  }
+
+  ctrl_t h2 = fragment(hash_value);
+  hash_table::ProbeSequence sequence(probe_start(hash_value),
+                                     table.capacity / hash_table::group_width);
+
+  // Deleted slots don't end the probe sequence, only a group which has an
+  // empty slot does.
+  while (true) {
+    hash_table::Group group(table.ctrl + sequence.offset());
+    for (hash_table::BitMask match = group.match(h2); match.any();
+         match.clear_lowest()) {
+      std::size_t index = sequence.offset() + match.lowest();
+      if (equal_(table.slots[index].key, key))
+        return index;
+    }
+
+    if (group.match_empty().any())
+      return index_not_found;
+    sequence.next();
+  }
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+template <typename K>
+ValueType*
+HashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::find_value(
+    const K& key,
+    std::size_t hash_value) {
+  std::size_t index = find_index(table_, key, hash_value);
+  if (index != index_not_found)
+    return &table_.slots[index].value;
+
+  if (old_table_.capacity) {
+    index = find_index(old_table_, key, hash_value);
+    if (index != index_not_found)
+      return &old_table_.slots[index].value;
+  }
+  return nullptr;
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+void
+HashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::prefetch_group(
+    const Table& table,
+    std::size_t hash_value) {
+  if constexpr (robin_hood) {
+    __builtin_prefetch(table.ctrl + home_index(table, hash_value));
     return;
   }
 
-  // Does nothing if capacity doesn't change
-  if (new_capacity == capacity_)
+  hash_table::ProbeSequence sequence(probe_start(hash_value),
+                                     table.capacity / hash_table::group_width);
+  __builtin_prefetch(table.ctrl + sequence.offset());
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+void
+HashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::prefetch_slot(
+    const Table& table,
+    std::size_t hash_value) {
+  if constexpr (robin_hood) {
+    __builtin_prefetch(table.slots + home_index(table, hash_value));
+    return;
+  }
+
+  hash_table::ProbeSequence sequence(probe_start(hash_value),
+                                     table.capacity / hash_table::group_width);
+  hash_table::BitMask match = hash_table::Group(table.ctrl + sequence.offset())
+                                  .match(fragment(hash_value));
+  if (match.any())
+    __builtin_prefetch(table.slots + sequence.offset() + match.lowest());
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+std::size_t
+HashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::
+    find_free_index(const Table& table, std::size_t hash_value) {
+  hash_table::ProbeSequence sequence(probe_start(hash_value),
+                                     table.capacity / hash_table::group_width);
+  while (true) {
+    hash_table::BitMask free =
+        hash_table::Group(table.ctrl + sequence.offset()).match_free();
+    if (free.any())
+      return sequence.offset() + free.lowest();
+    sequence.next();
+  }
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+std::size_t
+HashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::home_index(
+    const Table& table,
+    std::size_t hash_value) {
+  return probe_start(hash_value) & (table.capacity - 1);
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+std::size_t
+HashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::distance(
+    const Table& table,
+    std::size_t index) const {
+  if (table.ctrl[index] < hash_table::max_distance_ctrl)
+    return static_cast<std::size_t>(table.ctrl[index]);
+
+  std::size_t home = home_index(table, hasher_(table.slots[index].key));
+  return (index - home) & (table.capacity - 1);
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+typename HashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::ctrl_t
+HashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::distance_ctrl(
+    std::size_t distance) {
+  if (distance > static_cast<std::size_t>(hash_table::max_distance_ctrl))
+    return hash_table::max_distance_ctrl;
+  return static_cast<ctrl_t>(distance);
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+std::size_t
+HashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::probe_length(
+    const Table& table,
+    std::size_t index,
+    std::size_t hash_value) {
+  if constexpr (robin_hood) {
+    std::size_t home = home_index(table, hash_value);
+    return ((index - home) & (table.capacity - 1)) + 1;
+  }
+
+  std::size_t length = 1;
+  hash_table::ProbeSequence sequence(probe_start(hash_value),
+                                     table.capacity / hash_table::group_width);
+  for (; sequence.offset() != index - index % hash_table::group_width;
+       sequence.next())
+    ++length;
+  return length;
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+void HashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::
+    count_probe(Table& table, std::size_t length) {
+  if (table.probe_counts.size() <= length)
+    table.probe_counts.resize(length + 1);
+  ++table.probe_counts[length];
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+void HashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::
+    uncount_probe(Table& table, std::size_t length) {
+  --table.probe_counts[length];
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+std::size_t
+HashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::prepare_insert(
+    Table& table,
+    std::size_t hash_value) {
+  if constexpr (!robin_hood) {
+    std::size_t index = find_free_index(table, hash_value);
+    mark_full(table, index, hash_value);
+    return index;
+  }
+
+  // Walk until an empty slot or a node closer to its home than we'd be.
+  std::size_t mask = table.capacity - 1;
+  std::size_t index = home_index(table, hash_value);
+  std::size_t d = 0;
+  while (table.ctrl[index] != hash_table::empty_ctrl &&
+         distance(table, index) >= d) {
+    index = (index + 1) & mask;
+    ++d;
+  }
+
+  // Take its slot, shifting it and the rest of its run forward by one.
+  if (table.ctrl[index] != hash_table::empty_ctrl) {
+    std::size_t last = index;
+    while (table.ctrl[last] != hash_table::empty_ctrl)
+      last = (last + 1) & mask;
+
+    for (; last != index; last = (last - 1) & mask) {
+      std::size_t previous = (last - 1) & mask;
+      std::size_t previous_distance = distance(table, previous);
+      new (&table.slots[last]) Node(std::move(table.slots[previous]));
+      table.slots[previous].~Node();
+      table.ctrl[last] = distance_ctrl(previous_distance + 1);
+      uncount_probe(table, previous_distance + 1);
+      count_probe(table, previous_distance + 2);
+    }
+  }
+
+  table.ctrl[index] = distance_ctrl(d);
+  ++table.size;
+  count_probe(table, d + 1);
+  return index;
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+template <typename K>
+std::pair<std::size_t, bool>
+HashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::
+    find_or_prepare_insert(const K& key, std::size_t hash_value) {
+  if (old_table_.capacity)
+    migrate(hash_table::rehash_step);
+
+  // Robin Hood insertion may shift nodes, so it can't pick its slot while
+  // searching.
+  std::size_t free_index = index_not_found;
+  if constexpr (robin_hood) {
+    std::size_t index = find_index(table_, key, hash_value);
+    if (index != index_not_found)
+      return {index, true};
+  }
+
+  ctrl_t h2 = fragment(hash_value);
+  hash_table::ProbeSequence sequence(probe_start(hash_value),
+                                     table_.capacity / hash_table::group_width);
+
+  // Remember first free slot on the way, new node goes there if key doesn't
+  // exist.
+  if constexpr (!robin_hood) {
+    while (true) {
+      hash_table::Group group(table_.ctrl + sequence.offset());
+      for (hash_table::BitMask match = group.match(h2); match.any();
+           match.clear_lowest()) {
+        std::size_t index = sequence.offset() + match.lowest();
+        if (equal_(table_.slots[index].key, key))
+          return {index, true};
+      }
+
+      hash_table::BitMask free = group.match_free();
+      if (free_index == index_not_found && free.any())
+        free_index = sequence.offset() + free.lowest();
+
+      if (group.match_empty().any())
+        break;
+      sequence.next();
+    }
+  }
+
+  // Key may still wait in old table. Move it over, so returned index always
+  // refers to |table_|.
+  if (old_table_.capacity) {
+    std::size_t old_index = find_index(old_table_, key, hash_value);
+    if (old_index != index_not_found) {
+      if (free_index == index_not_found)
+        free_index = prepare_insert(table_, hash_value);
+      else
+        mark_full(table_, free_index, hash_value);
+      construct_node(free_index, hash_value,
+                     std::move(old_table_.slots[old_index]));
+      erase_at(old_table_, old_index, hash_value);
+      return {free_index, true};
+    }
+  }
+
+  // Positions change if table is reallocated.
+  if (reallocate_if_needed(table_.size + old_table_.size + 1) ||
+      free_index == index_not_found)
+    return {prepare_insert(table_, hash_value), false};
+
+  mark_full(table_, free_index, hash_value);
+  return {free_index, false};
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+template <typename K, typename V>
+void
+HashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::
+    insert_reserved(K&& key, V&& value) {
+  std::size_t hash_value = hash(key);
+  std::size_t index = find_index(table_, key, hash_value);
+  if (index != index_not_found) {
+    table_.slots[index].value = std::forward<V>(value);
     return;
+  }
+
+  index = prepare_insert(table_, hash_value);
+  construct_node(index, hash_value, std::forward<K>(key),
+                 std::forward<V>(value));
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+void HashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::mark_full(
+    Table& table,
+    std::size_t index,
+    std::size_t hash_value) {
+  if (table.ctrl[index] == hash_table::deleted_ctrl)
+    --table.deleted;
+  table.ctrl[index] = fragment(hash_value);
+  ++table.size;
+  count_probe(table, probe_length(table, index, hash_value));
+}
 
-  // Allocate a table with new capacity and fill it with null nodes
-  Node* new_table = new Node[new_capacity];
-  for (std::size_t i = 0; i < new_capacity; ++i) {
-    new_table[i] = Node::null();
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+template <typename... Args>
+void HashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::
+    construct_node(std::size_t index, std::size_t hash_value, Args&&... args) {
+  try {
+    new (&table_.slots[index]) Node(std::forward<Args>(args)...);
+  } catch (...) {
+    free_slot(table_, index, hash_value);
+    throw;
   }
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+void HashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::erase_at(
+    Table& table,
+    std::size_t index,
+    std::size_t hash_value) {
+  table.slots[index].~Node();
+  free_slot(table, index, hash_value);
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+void HashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::free_slot(
+    Table& table,
+    std::size_t index,
+    std::size_t hash_value) {
+  uncount_probe(table, probe_length(table, index, hash_value));
+  --table.size;
 
-  // Move valid nodes from current table to new table and rehash them.
-  for (std::size_t i = 0; i < capacity_; ++i) {
-    if (!table_[i].is_null() && !table_[i].is_dummy()) {
-      std::size_t hash_value = hash(table_[i].key, new_capacity);
-      while (!new_table[hash_value].is_null())
-        hash_value = (hash_value + 1) % new_capacity;
-      new_table[hash_value] = table_[i];
+  if constexpr (robin_hood) {
+    if (&table == &old_table_) {
+      table.ctrl[index] = hash_table::deleted_ctrl;
+      ++table.deleted;
+      return;
     }
+
+    // Shift following nodes which aren't in their home slot back by one.
+    std::size_t mask = table.capacity - 1;
+    std::size_t next = (index + 1) & mask;
+    while (hash_table::is_full(table.ctrl[next]) && table.ctrl[next] != 0) {
+      std::size_t d = distance(table, next);
+      new (&table.slots[index]) Node(std::move(table.slots[next]));
+      table.slots[next].~Node();
+      table.ctrl[index] = distance_ctrl(d - 1);
+      uncount_probe(table, d + 1);
+      count_probe(table, d);
+      index = next;
+      next = (next + 1) & mask;
+    }
+    table.ctrl[index] = hash_table::empty_ctrl;
+    return;
   }
 
-  // Clean up and finish
-  delete[] table_;
-  table_ = new_table;
-  capacity_ = new_capacity;
+  // A group which still has an empty slot never made a probe sequence move
+  // on to the next group, so the slot can become empty again.
+  std::size_t group_offset = index - index % hash_table::group_width;
+  if (hash_table::Group(table.ctrl + group_offset).match_empty().any()) {
+    table.ctrl[index] = hash_table::empty_ctrl;
+  } else {
+    table.ctrl[index] = hash_table::deleted_ctrl;
+    ++table.deleted;
+  }
 }
 
-// Node
-template <typename ValueType>
-typename HashTable<ValueType>::Node HashTable<ValueType>::Node::null() {
-  return HashTable::Node(null_node_key, null_node_value);
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+void
+HashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::move_to_table(
+    Table& from,
+    std::size_t index) {
+  std::size_t hash_value = hash(from.slots[index].key);
+  std::size_t new_index = prepare_insert(table_, hash_value);
+  new (&table_.slots[new_index]) Node(std::move(from.slots[index]));
+  from.slots[index].~Node();
+  uncount_probe(from, probe_length(from, index, hash_value));
+
+  // Lookups may still probe |from|, a deleted slot keeps their probe
+  // sequences intact.
+  from.ctrl[index] = hash_table::deleted_ctrl;
+  --from.size;
+  ++from.deleted;
 }
 
-template <typename ValueType>
-bool HashTable<ValueType>::Node::is_null() {
-  return key == null_node_key;
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+void HashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::migrate(
+    std::size_t group_count) {
+  std::size_t end = migrated_ + group_count * hash_table::group_width;
+  if (end > old_table_.capacity)
+    end = old_table_.capacity;
+
+  for (; migrated_ < end; ++migrated_) {
+    if (hash_table::is_full(old_table_.ctrl[migrated_]))
+      move_to_table(old_table_, migrated_);
+  }
+
+  if (migrated_ == old_table_.capacity) {
+    deallocate(old_table_);
+    old_table_ = Table();
+    migrated_ = 0;
+  }
 }
 
-template <typename ValueType>
-typename HashTable<ValueType>::Node HashTable<ValueType>::Node::dummy() {
-  return HashTable::Node(dummy_node_key, null_node_value);
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+typename HashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::Table
+HashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::allocate(
+    std::size_t capacity) {
+  Table table;
+  table.capacity = capacity;
+  table.ctrl = new ctrl_t[capacity];
+  for (std::size_t i = 0; i < capacity; ++i)
+    table.ctrl[i] = hash_table::empty_ctrl;
+
+  // Nodes are constructed on demand, so empty slots cost no allocation.
+  table.slots = static_cast<Node*>(::operator new(capacity * sizeof(Node)));
+  return table;
 }
 
-template <typename ValueType>
-bool HashTable<ValueType>::Node::is_dummy() {
-  return key == dummy_node_key;
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+void
+HashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::deallocate(
+    Table& table) {
+  for (std::size_t i = 0; i < table.capacity; ++i) {
+    if (hash_table::is_full(table.ctrl[i]))
+      table.slots[i].~Node();
+  }
+
+  delete[] table.ctrl;
+  ::operator delete(table.slots);
 }
 
-}  // namespace td
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+bool
+HashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::
+    reallocate_if_needed(std::size_t new_size) {
+  std::size_t capacity = table_.capacity;
+  std::size_t new_capacity = default_capacity;
 
+  // Decide table should be allocated or not
+  if (new_size > capacity * growth_factor) {
+    new_capacity = capacity * 2;
+  } else if (new_size < capacity * shrink_factor &&
+             capacity > min_capacity_) {
+    new_capacity = capacity / 2;
+  } else if (new_size + table_.deleted > capacity * growth_factor) {
+    new_capacity = capacity;
+  } else {
+    return false;
+  }
+
+  rehash(new_capacity);
+  return true;
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType,
+          typename ProbingType>
+void HashTable<KeyType, ValueType, HashType, EqualType, ProbingType>::rehash(
+    std::size_t new_capacity) {
+  // Only one old table is kept at a time.
+  if (old_table_.capacity)
+    migrate(old_table_.capacity / hash_table::group_width);
+
+  old_table_ = std::move(table_);
+  table_ = allocate(new_capacity);
+  ++rehash_count_;
+
+  std::size_t group_count = old_table_.capacity / hash_table::group_width;
+  migrate(rehash_ == hash_table::Rehash::kAllAtOnce ? group_count
+                                                   : hash_table::rehash_step);
+}
+
+}  // namespace td
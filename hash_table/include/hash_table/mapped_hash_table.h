@@ -0,0 +1,319 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "hash_table/group.h"
+#include "hash_table/hash.h"
+#include "hash_table/hash_table.h"
+#include "utils/macros.h"
+
+namespace td {
+
+namespace hash_table {
+
+// Version of snapshot layout written by |MappedHashTable::write|. Bump it
+// whenever layout or |StringHash| changes, older snapshots are rejected.
+constexpr std::uint32_t snapshot_version = 1;
+
+// Specifies how much of a snapshot is checked when it's opened.
+enum class Verify {
+  // Check header and section bounds only. Opening costs the same for any
+  // snapshot size, but slots are trusted, so only use it for files which
+  // were verified before.
+  kHeader,
+
+  // Also compare checksum of all sections and check every item lies in
+  // arena, which reads the whole file.
+  kChecksum
+};
+
+}  // namespace hash_table
+
+// A read-only hash table of string keys and values, mapped from a snapshot
+// file. Opening it doesn't rebuild anything: lookups read the mapped file
+// directly and returned values point into it.
+//
+// Snapshot layout, in native byte order:
+//   Header   magic, version, capacity, size, offsets and checksum.
+//   Control  |capacity| control bytes, probed in groups like |HashTable|.
+//   Slots    |capacity| slots of key offset and lengths in arena.
+//   Arena    key and value of every item, back to back.
+class MappedHashTable {
+ public:
+  // Write |table| to a snapshot file at |path|. Throw std::length_error if a
+  // key or value is 4 GiB or longer, or std::runtime_error if file can't be
+  // written.
+  template <typename HashType, typename EqualType, typename ProbingType>
+  static void write(const std::string& path,
+                    const HashTable<std::string,
+                                    std::string,
+                                    HashType,
+                                    EqualType,
+                                    ProbingType>& table);
+
+  // Map snapshot file at |path|. Throw std::runtime_error if it can't be
+  // read, or it's not a valid snapshot of |snapshot_version|.
+  explicit MappedHashTable(
+      const std::string& path,
+      hash_table::Verify verify = hash_table::Verify::kChecksum);
+  ~MappedHashTable();
+
+  // Returns value at given key, pointing into mapped file. If key doesn't
+  // exist, return |null_node_value|.
+  std::string_view get(std::string_view key) const;
+
+  // Return number of items are stored in snapshot.
+  std::size_t size() const;
+
+ private:
+  using ctrl_t = hash_table::ctrl_t;
+
+  static constexpr char magic[8] = {'T', 'D', 'H', 'T', 'S', 'N', 'A', 'P'};
+
+  struct Header {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t header_size;
+    std::uint64_t capacity;
+    std::uint64_t size;
+    std::uint64_t slots_offset;
+    std::uint64_t arena_offset;
+    std::uint64_t arena_size;
+    std::uint64_t checksum;
+  };
+
+  // Item of a full slot, its value directly follows its key in arena.
+  struct Slot {
+    std::uint64_t offset;
+    std::uint32_t key_length;
+    std::uint32_t value_length;
+  };
+
+  // Return checksum of control bytes, slots and arena.
+  static std::uint64_t checksum(const ctrl_t* ctrl,
+                                const Slot* slots,
+                                std::size_t capacity,
+                                const char* arena,
+                                std::size_t arena_size);
+
+  // Unmap file and throw std::runtime_error with |message|.
+  [[noreturn]] void fail(const std::string& message);
+
+  // Mapped file.
+  void* data_{nullptr};
+  std::size_t length_{0};
+
+  // Sections of mapped file.
+  const Header* header_{nullptr};
+  const ctrl_t* ctrl_{nullptr};
+  const Slot* slots_{nullptr};
+  const char* arena_{nullptr};
+
+  DISALLOW_COPY_AND_ASSIGN(MappedHashTable);
+};
+
+}  // namespace td
+
+/****************  Mapped hash table implementation ****************/
+namespace td {
+
+// Public
+
+template <typename HashType, typename EqualType, typename ProbingType>
+void MappedHashTable::write(
+    const std::string& path,
+    const HashTable<std::string, std::string, HashType, EqualType, ProbingType>&
+        table) {
+  // Same load limit as |HashTable|, capacity is a power of two and a
+  // multiple of group width.
+  std::size_t capacity = hash_table::group_width;
+  while (table.size() > capacity * growth_factor)
+    capacity *= 2;
+
+  std::vector<ctrl_t> ctrl(capacity, hash_table::empty_ctrl);
+  std::vector<Slot> slots(capacity, Slot{0, 0, 0});
+  std::string arena;
+
+  // Slots are placed with |hash_table::StringHash| no matter which hasher
+  // |table| uses, so lookups need no hasher state.
+  std::size_t group_count = capacity / hash_table::group_width;
+  table.for_each([&](const std::string& key, const std::string& value) {
+    if (key.size() > std::numeric_limits<std::uint32_t>::max() ||
+        value.size() > std::numeric_limits<std::uint32_t>::max())
+      throw std::length_error("MappedHashTable: item is too long");
+
+    std::size_t hash_value = hash_table::StringHash()(key);
+    hash_table::ProbeSequence sequence(hash_value >> 7, group_count);
+    hash_table::BitMask free = hash_table::Group(&ctrl[sequence.offset()])
+                                   .match_free();
+    while (!free.any()) {
+      sequence.next();
+      free = hash_table::Group(&ctrl[sequence.offset()]).match_free();
+    }
+
+    std::size_t index = sequence.offset() + free.lowest();
+    ctrl[index] = static_cast<ctrl_t>(hash_value & 0x7F);
+    slots[index] = Slot{arena.size(), static_cast<std::uint32_t>(key.size()),
+                        static_cast<std::uint32_t>(value.size())};
+    arena += key;
+    arena += value;
+  });
+
+  Header header;
+  std::memcpy(header.magic, magic, sizeof(magic));
+  header.version = hash_table::snapshot_version;
+  header.header_size = sizeof(Header);
+  header.capacity = capacity;
+  header.size = table.size();
+  header.slots_offset = sizeof(Header) + capacity;
+  header.arena_offset = header.slots_offset + capacity * sizeof(Slot);
+  header.arena_size = arena.size();
+  header.checksum = checksum(ctrl.data(), slots.data(), capacity, arena.data(),
+                             arena.size());
+
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  file.write(reinterpret_cast<const char*>(ctrl.data()), capacity);
+  file.write(reinterpret_cast<const char*>(slots.data()),
+             capacity * sizeof(Slot));
+  file.write(arena.data(), arena.size());
+  file.close();
+  if (!file)
+    throw std::runtime_error("MappedHashTable: can't write " + path);
+}
+
+inline MappedHashTable::MappedHashTable(const std::string& path,
+                                        hash_table::Verify verify) {
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    throw std::runtime_error("MappedHashTable: can't open " + path);
+
+  struct stat status;
+  if (::fstat(fd, &status) != 0 ||
+      static_cast<std::size_t>(status.st_size) < sizeof(Header)) {
+    ::close(fd);
+    throw std::runtime_error("MappedHashTable: " + path + " is too short");
+  }
+
+  length_ = static_cast<std::size_t>(status.st_size);
+  data_ = ::mmap(nullptr, length_, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (data_ == MAP_FAILED) {
+    data_ = nullptr;
+    throw std::runtime_error("MappedHashTable: can't map " + path);
+  }
+
+  header_ = static_cast<const Header*>(data_);
+  if (std::memcmp(header_->magic, magic, sizeof(magic)) != 0)
+    fail(path + " is not a snapshot");
+  if (header_->version != hash_table::snapshot_version ||
+      header_->header_size != sizeof(Header))
+    fail(path + " has unsupported version");
+
+  // Sections must be where writer puts them and fit in the file.
+  std::uint64_t capacity = header_->capacity;
+  std::uint64_t slots_end = header_->slots_offset + capacity * sizeof(Slot);
+  if (capacity < hash_table::group_width || (capacity & (capacity - 1)) ||
+      capacity > length_ || header_->size > capacity ||
+      header_->slots_offset != sizeof(Header) + capacity ||
+      header_->arena_offset != slots_end || header_->arena_offset > length_ ||
+      header_->arena_size != length_ - header_->arena_offset)
+    fail(path + " is corrupted");
+
+  const char* bytes = static_cast<const char*>(data_);
+  ctrl_ = reinterpret_cast<const ctrl_t*>(bytes + sizeof(Header));
+  slots_ = reinterpret_cast<const Slot*>(bytes + header_->slots_offset);
+  arena_ = bytes + header_->arena_offset;
+
+  if (verify == hash_table::Verify::kHeader)
+    return;
+
+  if (checksum(ctrl_, slots_, capacity, arena_, header_->arena_size) !=
+      header_->checksum)
+    fail(path + " has wrong checksum");
+
+  // A checksum can be recomputed for a tampered file, so items are checked
+  // too. Lengths are 32 bits, so their sum can't overflow. Item count must
+  // also be below the load limit of |write|, or lookups might find no empty
+  // slot.
+  std::uint64_t full_count = 0;
+  for (std::size_t i = 0; i < capacity; ++i) {
+    if (!hash_table::is_full(ctrl_[i]))
+      continue;
+    ++full_count;
+    const Slot& slot = slots_[i];
+    if (slot.offset > header_->arena_size ||
+        std::uint64_t{slot.key_length} + slot.value_length >
+            header_->arena_size - slot.offset)
+      fail(path + " is corrupted");
+  }
+  if (full_count != header_->size || full_count > capacity * growth_factor)
+    fail(path + " is corrupted");
+}
+
+inline MappedHashTable::~MappedHashTable() {
+  if (data_)
+    ::munmap(data_, length_);
+}
+
+inline std::string_view MappedHashTable::get(std::string_view key) const {
+  std::size_t hash_value = hash_table::StringHash()(key);
+  ctrl_t h2 = static_cast<ctrl_t>(hash_value & 0x7F);
+  std::size_t group_count = header_->capacity / hash_table::group_width;
+  hash_table::ProbeSequence sequence(hash_value >> 7, group_count);
+
+  // Probe sequence visits every group once, so a snapshot opened with
+  // |Verify::kHeader| can't make it loop forever, even with no empty slot.
+  for (std::size_t i = 0; i < group_count; ++i) {
+    hash_table::Group group(ctrl_ + sequence.offset());
+    for (hash_table::BitMask match = group.match(h2); match.any();
+         match.clear_lowest()) {
+      const Slot& slot = slots_[sequence.offset() + match.lowest()];
+      std::string_view slot_key(arena_ + slot.offset, slot.key_length);
+      if (slot_key == key)
+        return {arena_ + slot.offset + slot.key_length, slot.value_length};
+    }
+
+    if (group.match_empty().any())
+      return null_node_value;
+    sequence.next();
+  }
+  return null_node_value;
+}
+
+inline std::size_t MappedHashTable::size() const {
+  return header_->size;
+}
+
+// Private
+
+inline std::uint64_t MappedHashTable::checksum(const ctrl_t* ctrl,
+                                               const Slot* slots,
+                                               std::size_t capacity,
+                                               const char* arena,
+                                               std::size_t arena_size) {
+  std::uint64_t result = hash_table::hash_bytes(ctrl, capacity);
+  result = hash_table::mix(
+      result, hash_table::hash_bytes(slots, capacity * sizeof(Slot)));
+  return hash_table::mix(result, hash_table::hash_bytes(arena, arena_size));
+}
+
+inline void MappedHashTable::fail(const std::string& message) {
+  ::munmap(data_, length_);
+  data_ = nullptr;
+  throw std::runtime_error("MappedHashTable: " + message);
+}
+
+}  // namespace td
@@ -0,0 +1,366 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+#include "hash_table/epoch.h"
+#include "hash_table/hash_table.h"
+#include "utils/macros.h"
+#include "utils/utils.h"
+
+namespace td {
+
+// A thread-safe hash table for workloads which are mostly lookups.
+//
+// Readers never lock and never write memory shared with other threads: each
+// slot holds an atomic pointer to an immutable entry, so a lookup is a few
+// loads. Writers take one mutex, publish new entries and tables with release
+// stores and retire replaced ones through an |EpochDomain|, which frees them
+// once no reader can still hold them.
+//
+// Stores which unlink an entry or table, and reader loads of them, are
+// sequentially consistent, as are the epoch announcement of a reader and its
+// scan by a writer. Otherwise a reader could announce its epoch and still
+// load an entry which the writer, not seeing the announcement yet, frees.
+// Such loads are plain loads on x86 and ARMv8.
+template <typename KeyType,
+          typename ValueType,
+          typename HashType = Hash<KeyType>,
+          typename EqualType = std::equal_to<>>
+class ReadMostlyHashTable {
+  // Type of key accepted by lookups, see |HashTable|.
+  template <typename K>
+  using key_arg = typename hash_table::KeyArg<
+      hash_table::is_transparent<HashType>::value &&
+      hash_table::is_transparent<EqualType>::value>::template type<K, KeyType>;
+
+ public:
+  ReadMostlyHashTable();
+  explicit ReadMostlyHashTable(const HashType& hasher,
+                               const EqualType& equal = EqualType());
+
+  // No thread may use hash table while it's destroyed.
+  ~ReadMostlyHashTable();
+
+  // Add the given key and value to hash table. If key exists, replace old value
+  // with given value. Readers see either the old or the new value.
+  void set(const KeyType& key, const ValueType& value);
+
+  // Returns copy of value at given key. If key doesn't exist, return
+  // |hash_table::null_value()|. Never blocks.
+  template <typename K = KeyType>
+  ValueType get(const key_arg<K>& key);
+
+  // Removes value at given key. If key doesn't exist, does nothing
+  template <typename K = KeyType>
+  void remove(const key_arg<K>& key);
+
+  // Return number of items are currently stored in hash table.
+  std::size_t size();
+
+ private:
+  // An immutable key and value. Replacing a value publishes a new entry.
+  struct Entry {
+    std::size_t hash;
+    KeyType key;
+    ValueType value;
+  };
+
+  // Open addressing table with linear probing.
+  struct Table {
+    // Always a power of two.
+    std::size_t capacity;
+
+    // Null for an empty slot, |tombstone()| for a removed one.
+    std::unique_ptr<std::atomic<Entry*>[]> slots;
+
+    explicit Table(std::size_t c);
+  };
+
+  // Marks slot whose entry was removed. Never dereferenced.
+  static Entry* tombstone();
+
+  // Return index of slot of |table| which holds |key|, or |index_not_found|.
+  template <typename K>
+  std::size_t find_index(const Table& table,
+                         const K& key,
+                         std::size_t hash_value);
+
+  // Return index of first null or tombstone slot in probe sequence of
+  // |hash_value|.
+  static std::size_t find_free_index(const Table& table,
+                                     std::size_t hash_value);
+
+  // Publish a new table sized for |size_ + 1| entries, without tombstones,
+  // retire the old one and free retired objects which are safe to free.
+  void rehash();
+
+  // Retire |entry| and free retired objects which are safe to free.
+  void retire(Entry* entry);
+
+  // Hash function of keys.
+  HashType hasher_;
+
+  // Determine two keys are equal or not.
+  EqualType equal_;
+
+  // Current table. Readers load it once per lookup.
+  std::atomic<Table*> table_;
+
+  // Serializes writers.
+  std::mutex write_mutex_;
+
+  // Number of entries, only touched by writers.
+  std::size_t size_{0};
+
+  // Number of slots which aren't null, entries and tombstones. Only touched
+  // by writers.
+  std::size_t used_{0};
+
+  // Frees replaced entries and tables once readers are done with them.
+  hash_table::EpochDomain epoch_;
+
+  DISALLOW_COPY_AND_ASSIGN(ReadMostlyHashTable);
+};
+
+}  // namespace td
+
+/****************  Read mostly hash table implementation ****************/
+namespace td {
+
+// Public
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType>
+ReadMostlyHashTable<KeyType, ValueType, HashType, EqualType>::
+    ReadMostlyHashTable()
+    : ReadMostlyHashTable(HashType()) {}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType>
+ReadMostlyHashTable<KeyType, ValueType, HashType, EqualType>::
+    ReadMostlyHashTable(const HashType& hasher, const EqualType& equal)
+    : hasher_(hasher),
+      equal_(equal),
+      table_(new Table(default_capacity)) {}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType>
+ReadMostlyHashTable<KeyType, ValueType, HashType, EqualType>::
+    ~ReadMostlyHashTable() {
+  Table* table = table_.load(std::memory_order_relaxed);
+  for (std::size_t i = 0; i < table->capacity; ++i) {
+    Entry* entry = table->slots[i].load(std::memory_order_relaxed);
+    if (entry && entry != tombstone())
+      delete entry;
+  }
+  delete table;
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType>
+void ReadMostlyHashTable<KeyType, ValueType, HashType, EqualType>::set(
+    const KeyType& key,
+    const ValueType& value) {
+  std::size_t hash_value = hasher_(key);
+  Entry* entry = new Entry{hash_value, key, value};
+
+  std::lock_guard<std::mutex> lock(write_mutex_);
+  Table* table = table_.load(std::memory_order_relaxed);
+
+  std::size_t index = find_index(*table, key, hash_value);
+  if (index != index_not_found) {
+    Entry* old_entry = table->slots[index].load(std::memory_order_relaxed);
+    table->slots[index].store(entry, std::memory_order_seq_cst);
+    retire(old_entry);
+    return;
+  }
+
+  // Keep at least half of slots null so misses stop early.
+  index = find_free_index(*table, hash_value);
+  bool reuses_slot =
+      table->slots[index].load(std::memory_order_relaxed) == tombstone();
+  if (!reuses_slot && (used_ + 1) * 2 > table->capacity) {
+    rehash();
+    table = table_.load(std::memory_order_relaxed);
+    index = find_free_index(*table, hash_value);
+  }
+
+  if (!table->slots[index].load(std::memory_order_relaxed))
+    ++used_;
+  ++size_;
+  table->slots[index].store(entry, std::memory_order_release);
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType>
+template <typename K>
+ValueType ReadMostlyHashTable<KeyType, ValueType, HashType, EqualType>::get(
+    const key_arg<K>& key) {
+  std::size_t hash_value = hasher_(key);
+
+  hash_table::EpochDomain::Guard guard(epoch_);
+  Table* table = table_.load(std::memory_order_seq_cst);
+  std::size_t mask = table->capacity - 1;
+
+  for (std::size_t index = hash_value & mask;; index = (index + 1) & mask) {
+    Entry* entry = table->slots[index].load(std::memory_order_seq_cst);
+    if (!entry)
+      return hash_table::null_value<ValueType>();
+    if (entry != tombstone() && entry->hash == hash_value &&
+        equal_(entry->key, key))
+      return entry->value;
+  }
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType>
+template <typename K>
+void ReadMostlyHashTable<KeyType, ValueType, HashType, EqualType>::remove(
+    const key_arg<K>& key) {
+  std::size_t hash_value = hasher_(key);
+
+  std::lock_guard<std::mutex> lock(write_mutex_);
+  Table* table = table_.load(std::memory_order_relaxed);
+  std::size_t index = find_index(*table, key, hash_value);
+  if (index == index_not_found)
+    return;
+
+  Entry* entry = table->slots[index].load(std::memory_order_relaxed);
+  table->slots[index].store(tombstone(), std::memory_order_seq_cst);
+  --size_;
+  retire(entry);
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType>
+std::size_t
+ReadMostlyHashTable<KeyType, ValueType, HashType, EqualType>::size() {
+  std::lock_guard<std::mutex> lock(write_mutex_);
+  return size_;
+}
+
+// Private
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType>
+ReadMostlyHashTable<KeyType, ValueType, HashType, EqualType>::Table::Table(
+    std::size_t c)
+    : capacity(c), slots(new std::atomic<Entry*>[c]) {
+  for (std::size_t i = 0; i < capacity; ++i)
+    slots[i].store(nullptr, std::memory_order_relaxed);
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType>
+typename ReadMostlyHashTable<KeyType, ValueType, HashType, EqualType>::Entry*
+ReadMostlyHashTable<KeyType, ValueType, HashType, EqualType>::tombstone() {
+  static char marker;
+  return reinterpret_cast<Entry*>(&marker);
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType>
+template <typename K>
+std::size_t
+ReadMostlyHashTable<KeyType, ValueType, HashType, EqualType>::find_index(
+    const Table& table,
+    const K& key,
+    std::size_t hash_value) {
+  std::size_t mask = table.capacity - 1;
+  for (std::size_t index = hash_value & mask;; index = (index + 1) & mask) {
+    Entry* entry = table.slots[index].load(std::memory_order_relaxed);
+    if (!entry)
+      return index_not_found;
+    if (entry != tombstone() && entry->hash == hash_value &&
+        equal_(entry->key, key))
+      return index;
+  }
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType>
+std::size_t
+ReadMostlyHashTable<KeyType, ValueType, HashType, EqualType>::find_free_index(
+    const Table& table,
+    std::size_t hash_value) {
+  std::size_t mask = table.capacity - 1;
+  for (std::size_t index = hash_value & mask;; index = (index + 1) & mask) {
+    Entry* entry = table.slots[index].load(std::memory_order_relaxed);
+    if (!entry || entry == tombstone())
+      return index;
+  }
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType>
+void ReadMostlyHashTable<KeyType, ValueType, HashType, EqualType>::rehash() {
+  // New table is at most a quarter full, so it takes as many inserts as it
+  // holds entries before the next rehash.
+  std::size_t capacity = default_capacity;
+  while (capacity < (size_ + 1) * 4)
+    capacity *= 2;
+
+  Table* old_table = table_.load(std::memory_order_relaxed);
+  Table* new_table = new Table(capacity);
+
+  // Entries are shared by both tables, only pointers are copied.
+  for (std::size_t i = 0; i < old_table->capacity; ++i) {
+    Entry* entry = old_table->slots[i].load(std::memory_order_relaxed);
+    if (!entry || entry == tombstone())
+      continue;
+    std::size_t index = find_free_index(*new_table, entry->hash);
+    new_table->slots[index].store(entry, std::memory_order_relaxed);
+  }
+  used_ = size_;
+
+  table_.store(new_table, std::memory_order_seq_cst);
+  epoch_.retire(old_table, [](void* table) {
+    delete static_cast<Table*>(table);
+  });
+
+  // Unlike entries, tables aren't batched: a rehash already walks the whole
+  // table, and inserts alone might never retire enough entries to reclaim
+  // the old tables.
+  epoch_.reclaim();
+}
+
+template <typename KeyType,
+          typename ValueType,
+          typename HashType,
+          typename EqualType>
+void ReadMostlyHashTable<KeyType, ValueType, HashType, EqualType>::retire(
+    Entry* entry) {
+  epoch_.retire(entry, [](void* entry) { delete static_cast<Entry*>(entry); });
+
+  // Reclaiming walks every reader record, do it in batches.
+  if (epoch_.retired_count() >= 64)
+    epoch_.reclaim();
+}
+
+}  // namespace td
@@ -0,0 +1,151 @@
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "hash_table/arena_hash_table.h"
+#include "gtest/gtest.h"
+
+namespace {
+using namespace td;
+
+TEST(ArenaHashTableTest, SetGetRemove) {
+  ArenaHashTable<std::string> hash_table;
+  hash_table.set("1", "1v");
+  hash_table.set("2", "2v");
+
+  EXPECT_EQ("1v", hash_table.get("1"));
+  EXPECT_EQ("2v", hash_table.get("2"));
+  EXPECT_EQ(null_node_value, hash_table.get("3"));
+  EXPECT_EQ(2, hash_table.size());
+
+  hash_table.set("1", "11v");
+  EXPECT_EQ("11v", hash_table.get("1"));
+  EXPECT_EQ(2, hash_table.size());
+
+  hash_table.remove("1");
+  EXPECT_EQ(null_node_value, hash_table.get("1"));
+  EXPECT_EQ(nullptr, hash_table.find("1"));
+  EXPECT_EQ(1, hash_table.size());
+  EXPECT_FALSE(hash_table.erase("1"));
+
+  hash_table.set("1", "111v");
+  EXPECT_EQ("111v", hash_table.get("1"));
+  *hash_table.find("1") = "1111v";
+  EXPECT_EQ("1111v", hash_table.get("1"));
+}
+
+TEST(ArenaHashTableTest, EmptyAndLongKeys) {
+  ArenaHashTable<int> hash_table;
+  std::string long_key(1000, 'x');
+  hash_table.set("", 1);
+  hash_table.set(long_key, 2);
+  hash_table.set(long_key.substr(1), 3);
+
+  EXPECT_EQ(1, hash_table.get(""));
+  EXPECT_EQ(2, hash_table.get(long_key));
+  EXPECT_EQ(3, hash_table.get(std::string_view(long_key).substr(1)));
+  EXPECT_EQ(0, hash_table.get("x"));
+}
+
+// Value whose copy throws if |fails| is set.
+struct Fragile {
+  Fragile(int value, bool fails) : value(value), fails(fails) {}
+  Fragile(const Fragile& other) : value(other.value), fails(other.fails) {
+    if (fails)
+      throw std::runtime_error("copy failed");
+  }
+  Fragile& operator=(const Fragile&) = default;
+
+  int value;
+  bool fails;
+};
+
+TEST(ArenaHashTableTest, SetThatThrows) {
+  ArenaHashTable<Fragile> hash_table;
+  for (int i = 0; i < 100; ++i)
+    hash_table.set(std::to_string(i), Fragile(i, false));
+
+  Fragile fragile(-1, true);
+  EXPECT_THROW(hash_table.set("x", fragile), std::runtime_error);
+  EXPECT_EQ(100, hash_table.size());
+  EXPECT_EQ(nullptr, hash_table.find("x"));
+
+  std::size_t visited = 0;
+  hash_table.for_each([&](std::string_view, const Fragile&) { ++visited; });
+  EXPECT_EQ(100, visited);
+
+  hash_table.set("x", Fragile(1000, false));
+  EXPECT_EQ(1000, hash_table.find("x")->value);
+}
+
+TEST(ArenaHashTableTest, RandomOperations) {
+  ArenaHashTable<int> hash_table;
+  std::unordered_map<std::string, int> map;
+  std::mt19937 random(42);
+  for (int i = 0; i < 100000; ++i) {
+    std::string key = "key:" + std::to_string(random() % 2000);
+    if (random() % 2) {
+      hash_table.set(key, i);
+      map[key] = i;
+    } else {
+      ASSERT_EQ(map.erase(key) == 1, hash_table.erase(key));
+    }
+  }
+
+  ASSERT_EQ(map.size(), hash_table.size());
+  for (const auto& [key, value] : map) {
+    int* found = hash_table.find(key);
+    ASSERT_NE(nullptr, found);
+    ASSERT_EQ(value, *found);
+  }
+
+  std::size_t visited = 0;
+  hash_table.for_each([&](std::string_view key, int value) {
+    EXPECT_EQ(map.at(std::string(key)), value);
+    ++visited;
+  });
+  EXPECT_EQ(map.size(), visited);
+}
+
+TEST(ArenaHashTableTest, ArenaIsCompacted) {
+  ArenaHashTable<int> hash_table;
+  hash_table.reserve(100);
+  std::string key(100, 'k');
+  for (int i = 0; i < 100000; ++i) {
+    key[i % key.size()] = static_cast<char>('a' + i % 26);
+    hash_table.set(key, i);
+    hash_table.remove(key);
+  }
+
+  // Removed keys don't pile up, and reserved capacity isn't given back.
+  EXPECT_EQ(0, hash_table.size());
+  std::size_t usage = hash_table.memory_usage();
+  EXPECT_LT(usage, 100000);
+  for (int i = 0; i < 80; ++i)
+    hash_table.set(std::to_string(i), i);
+  EXPECT_LT(hash_table.memory_usage(), usage + 1000);
+}
+
+TEST(ArenaHashTableTest, MemoryUsage) {
+  ArenaHashTable<int> arena_table;
+  std::vector<std::string> keys;
+  std::size_t key_bytes = 0;
+  for (int i = 0; i < 10000; ++i) {
+    keys.push_back("key:" + std::to_string(i) + std::string(i % 30, 'k'));
+    key_bytes += keys.back().size();
+  }
+  arena_table.reserve(keys.size(), key_bytes);
+  std::size_t usage = arena_table.memory_usage();
+
+  // Nothing but slots and arena is allocated, both were reserved up front.
+  for (std::size_t i = 0; i < keys.size(); ++i)
+    arena_table.set(keys[i], static_cast<int>(i));
+  EXPECT_EQ(usage, arena_table.memory_usage());
+  for (std::size_t i = 0; i < keys.size(); ++i)
+    EXPECT_EQ(static_cast<int>(i), arena_table.get(keys[i]));
+}
+
+}  // namespace
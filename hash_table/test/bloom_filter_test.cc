@@ -0,0 +1,146 @@
+#include <cstdint>
+#include <random>
+#include <string>
+#include <unordered_map>
+
+#include "hash_table/bloom_filter.h"
+#include "hash_table/filtered_hash_table.h"
+#include "gtest/gtest.h"
+
+namespace {
+using namespace td;
+
+// Return fraction of |count| hashes, never inserted into |filter|, which it
+// may contain.
+double false_positive_rate(const BloomFilter& filter, std::size_t count) {
+  std::mt19937_64 generator(7);
+  std::size_t positives = 0;
+  for (std::size_t i = 0; i < count; ++i)
+    positives += filter.may_contain(generator());
+  return static_cast<double>(positives) / count;
+}
+
+TEST(BloomFilterTest, NoFalseNegatives) {
+  BloomFilter filter(10000);
+  std::mt19937_64 generator(1);
+  std::vector<std::uint64_t> hashes;
+  for (int i = 0; i < 10000; ++i) {
+    hashes.push_back(generator());
+    filter.insert(hashes.back());
+  }
+  for (std::uint64_t hash_value : hashes)
+    EXPECT_TRUE(filter.may_contain(hash_value));
+
+  filter.clear();
+  EXPECT_EQ(0, false_positive_rate(filter, 1000));
+}
+
+TEST(BloomFilterTest, FalsePositiveRate) {
+  const std::size_t count = 100000;
+  BloomFilter filter(count);
+  BloomFilter small_filter(count, 8);
+  EXPECT_EQ(count * 16 / 8, filter.memory_usage());
+  EXPECT_EQ(count * 8 / 8, small_filter.memory_usage());
+
+  std::mt19937_64 generator(2);
+  for (std::size_t i = 0; i < count; ++i) {
+    std::uint64_t hash_value = generator();
+    filter.insert(hash_value);
+    small_filter.insert(hash_value);
+  }
+
+  EXPECT_LT(false_positive_rate(filter, 1000000), 0.01);
+  EXPECT_LT(false_positive_rate(small_filter, 1000000), 0.05);
+}
+
+TEST(FilteredHashTableTest, SetGetRemove) {
+  FilteredHashTable<std::string, int> table;
+  EXPECT_EQ(0, table.get("a"));
+  EXPECT_FALSE(table.may_contain("a"));
+
+  table.set("a", 1);
+  table.set("b", 2);
+  table.set("a", 3);
+  EXPECT_EQ(2, table.size());
+  EXPECT_TRUE(table.may_contain("a"));
+  EXPECT_EQ(3, table.get("a"));
+  EXPECT_EQ(2, *table.find("b"));
+  EXPECT_EQ(nullptr, table.find("c"));
+
+  table.remove("a");
+  EXPECT_EQ(0, table.get("a"));
+  EXPECT_FALSE(table.erase("a"));
+  EXPECT_TRUE(table.erase("b"));
+  EXPECT_EQ(0, table.size());
+}
+
+TEST(FilteredHashTableTest, RandomOperations) {
+  FilteredHashTable<int, int> table;
+  std::unordered_map<int, int> map;
+  std::mt19937 generator(3);
+  std::uniform_int_distribution<int> keys(0, 5000);
+
+  for (int i = 0; i < 100000; ++i) {
+    int key = keys(generator);
+    switch (generator() % 3) {
+      case 0:
+        table.set(key, i);
+        map[key] = i;
+        break;
+      case 1:
+        EXPECT_EQ(map.erase(key) == 1, table.erase(key));
+        break;
+      default:
+        auto it = map.find(key);
+        EXPECT_EQ(it == map.end() ? 0 : it->second, table.get(key));
+        if (it != map.end())
+          EXPECT_TRUE(table.may_contain(key));
+    }
+  }
+  EXPECT_EQ(map.size(), table.size());
+}
+
+TEST(FilteredHashTableTest, RemovedKeysLeaveFilter) {
+  FilteredHashTable<int, int> table;
+  for (int i = 0; i < 10000; ++i)
+    table.set(i, i);
+  std::size_t memory_usage = table.filter_memory_usage();
+
+  // Once removed keys outnumber live ones, filter is rebuilt from live keys
+  // only, and sized for them.
+  for (int i = 0; i < 9000; ++i)
+    table.remove(i);
+  EXPECT_LT(table.filter_memory_usage(), memory_usage);
+
+  // Filter was last rebuilt after 8751 removals, when 1249 keys were left.
+  int positives = 0;
+  for (int i = 0; i < 8751; ++i)
+    positives += table.may_contain(i);
+  EXPECT_LT(positives, 88);
+  for (int i = 9000; i < 10000; ++i)
+    EXPECT_EQ(i, table.get(i));
+}
+
+// Hash of ints which counts its calls in |*calls|.
+struct CountingHash {
+  std::size_t* calls;
+
+  std::size_t operator()(int key) const {
+    ++*calls;
+    return Hash<int>()(key);
+  }
+};
+
+TEST(FilteredHashTableTest, KeysAreHashedOnce) {
+  std::size_t calls = 0;
+  FilteredHashTable<int, int, CountingHash> table(CountingHash{&calls});
+  table.set(1, 10);
+  table.set(2, 20);
+  table.set(2, 21);
+  EXPECT_EQ(21, table.get(2));
+  EXPECT_EQ(0, table.get(3));
+  EXPECT_NE(nullptr, table.find(1));
+  EXPECT_EQ(6, calls);
+}
+
+}  // namespace
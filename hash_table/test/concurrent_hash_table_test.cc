@@ -0,0 +1,94 @@
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "hash_table/concurrent_hash_table.h"
+#include "gtest/gtest.h"
+
+namespace {
+using namespace td;
+
+TEST(ConcurrentHashTableTest, SetGetRemove) {
+  ConcurrentHashTable<std::string, std::string> hash_table;
+  hash_table.set("1", "1v");
+  hash_table.set("2", "2v");
+
+  EXPECT_EQ("1v", hash_table.get("1"));
+  EXPECT_EQ("2v", hash_table.get("2"));
+  EXPECT_EQ(null_node_value, hash_table.get("3"));
+
+  hash_table.set("1", "11v");
+  EXPECT_EQ("11v", hash_table.get("1"));
+
+  hash_table.remove("1");
+  EXPECT_EQ(null_node_value, hash_table.get("1"));
+}
+
+TEST(ConcurrentHashTableTest, ShardCount) {
+  ConcurrentHashTable<int, int> one_shard(1);
+  EXPECT_EQ(1, one_shard.shard_count());
+
+  // Rounded up to a power of two
+  ConcurrentHashTable<int, int> hash_table(5);
+  EXPECT_EQ(8, hash_table.shard_count());
+
+  one_shard.set(1, 10);
+  EXPECT_EQ(10, one_shard.get(1));
+}
+
+TEST(ConcurrentHashTableTest, MissingBoolIsFalse) {
+  ConcurrentHashTable<int, bool> hash_table;
+  hash_table.set(1, true);
+  EXPECT_TRUE(hash_table.get(1));
+  EXPECT_FALSE(hash_table.get(2));
+}
+
+// Hash of ints which counts its calls in |*calls|.
+struct CountingHash {
+  std::size_t* calls;
+
+  std::size_t operator()(int key) const {
+    ++*calls;
+    return Hash<int>()(key);
+  }
+};
+
+TEST(ConcurrentHashTableTest, KeysAreHashedOnce) {
+  std::size_t calls = 0;
+  ConcurrentHashTable<int, int, CountingHash> hash_table(4,
+                                                         CountingHash{&calls});
+  hash_table.set(1, 10);
+  hash_table.set(2, 20);
+  EXPECT_EQ(20, hash_table.get(2));
+  EXPECT_EQ(0, hash_table.get(3));
+  hash_table.remove(1);
+  EXPECT_EQ(0, hash_table.get(1));
+  EXPECT_EQ(6, calls);
+}
+
+TEST(ConcurrentHashTableTest, ManyThreads) {
+  constexpr int thread_count = 8;
+  constexpr int keys_per_thread = 2000;
+  ConcurrentHashTable<int, int> hash_table(16);
+
+  // Each thread owns a key range, writes it while reading everyone's keys.
+  std::vector<std::thread> threads;
+  for (int t = 0; t < thread_count; ++t) {
+    threads.emplace_back([&hash_table, t] {
+      int first = t * keys_per_thread;
+      for (int i = first; i < first + keys_per_thread; ++i) {
+        hash_table.set(i, i);
+        hash_table.get((i * 7) % (thread_count * keys_per_thread));
+      }
+      for (int i = first; i < first + keys_per_thread; i += 2)
+        hash_table.remove(i);
+    });
+  }
+  for (std::thread& thread : threads)
+    thread.join();
+
+  for (int i = 0; i < thread_count * keys_per_thread; ++i)
+    EXPECT_EQ(i % 2 ? i : 0, hash_table.get(i));
+}
+
+}  // namespace
@@ -0,0 +1,120 @@
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "hash_table/flat_int_table.h"
+#include "gtest/gtest.h"
+
+namespace {
+using namespace td;
+
+static_assert(FlatIntSet<1>::capacity() == 16, "");
+static_assert(FlatIntSet<100>::capacity() == 256, "");
+static_assert(FlatIntMap<128, int>::capacity() == 256, "");
+static_assert(hash_table::FlatIntKeys<std::uint64_t, 8>::home_index(1) <
+                  hash_table::FlatIntKeys<std::uint64_t, 8>::capacity,
+              "");
+
+TEST(FlatIntTableTest, Set) {
+  FlatIntSet<4> set;
+  EXPECT_TRUE(set.insert(1));
+  EXPECT_TRUE(set.insert(2));
+  EXPECT_FALSE(set.insert(1));
+  EXPECT_TRUE(set.contains(1));
+  EXPECT_FALSE(set.contains(3));
+  EXPECT_EQ(2, set.size());
+
+  // Key 0 marks empty slots, but is still a valid key.
+  EXPECT_FALSE(set.contains(0));
+  EXPECT_TRUE(set.insert(0));
+  EXPECT_TRUE(set.contains(0));
+  EXPECT_TRUE(set.insert(3));
+  EXPECT_THROW(set.insert(4), std::length_error);
+  EXPECT_FALSE(set.insert(3));
+
+  EXPECT_TRUE(set.erase(0));
+  EXPECT_FALSE(set.erase(0));
+  EXPECT_FALSE(set.contains(0));
+  EXPECT_TRUE(set.insert(4));
+
+  std::uint64_t sum = 0;
+  set.for_each([&](std::uint64_t key) { sum += key; });
+  EXPECT_EQ(10, sum);
+
+  set.clear();
+  EXPECT_EQ(0, set.size());
+  EXPECT_FALSE(set.contains(1));
+}
+
+TEST(FlatIntTableTest, Map) {
+  FlatIntMap<8, int, int> map;
+  map.set(1, 10);
+  map.set(-1, -10);
+  map.set(0, 100);
+  EXPECT_EQ(10, map.get(1));
+  EXPECT_EQ(-10, map.get(-1));
+  EXPECT_EQ(100, map.get(0));
+  EXPECT_EQ(0, map.get(2));
+  EXPECT_EQ(nullptr, map.find(2));
+
+  map.set(1, 11);
+  *map.find(-1) = -11;
+  EXPECT_EQ(11, map.get(1));
+  EXPECT_EQ(-11, map.get(-1));
+  EXPECT_EQ(3, map.size());
+
+  EXPECT_TRUE(map.erase(1));
+  EXPECT_FALSE(map.contains(1));
+  EXPECT_EQ(2, map.size());
+
+  int sum = 0;
+  map.for_each([&](int key, int value) { sum += key + value; });
+  EXPECT_EQ(-1 - 11 + 100, sum);
+}
+
+TEST(FlatIntTableTest, RandomOperations) {
+  // Small key range makes long runs, so removal shifts keys across the end
+  // of the table.
+  FlatIntMap<1000, int, std::uint32_t> map;
+  FlatIntSet<1000, std::uint32_t> set;
+  std::unordered_map<std::uint32_t, int> expected;
+  std::mt19937 random(42);
+  for (int i = 0; i < 200000; ++i) {
+    std::uint32_t key = random() % 1000;
+    if (random() % 2) {
+      map.set(key, i);
+      set.insert(key);
+      expected[key] = i;
+    } else {
+      bool existed = expected.erase(key) == 1;
+      ASSERT_EQ(existed, map.erase(key));
+      ASSERT_EQ(existed, set.erase(key));
+    }
+  }
+
+  ASSERT_EQ(expected.size(), map.size());
+  ASSERT_EQ(expected.size(), set.size());
+  for (std::uint32_t key = 0; key < 1000; ++key) {
+    auto it = expected.find(key);
+    ASSERT_EQ(it != expected.end(), set.contains(key));
+    int* value = map.find(key);
+    ASSERT_EQ(it != expected.end(), value != nullptr);
+    if (value)
+      ASSERT_EQ(it->second, *value);
+  }
+}
+
+TEST(FlatIntTableTest, StaticStorage) {
+  // Storage is inline, a static table needs no construction at run time.
+  static FlatIntSet<1 << 16> set;
+  for (std::uint64_t key = 1; key <= (1 << 16); ++key)
+    EXPECT_TRUE(set.insert(key * 7919));
+  EXPECT_EQ(1 << 16, set.size());
+  EXPECT_THROW(set.insert(1), std::length_error);
+  for (std::uint64_t key = 1; key <= (1 << 16); ++key)
+    ASSERT_TRUE(set.contains(key * 7919));
+}
+
+}  // namespace
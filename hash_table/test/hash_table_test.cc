@@ -1,11 +1,133 @@
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
 #include "hash_table/hash_table.h"
 #include "gtest/gtest.h"
 
 namespace {
 using namespace td;
 
+// Hash every key to the same value, so all keys collide.
+struct ConstantHash {
+  std::size_t operator()(int) const { return 42; }
+};
+
+// Check probe lengths which |stats| keeps up to date match a recount.
+template <typename Table>
+void check_stats(const Table& hash_table) {
+  std::vector<std::size_t> histogram = hash_table.probe_histogram();
+  std::size_t total_length = 0;
+  std::size_t max_length = 0;
+  for (std::size_t length = 1; length < histogram.size(); ++length) {
+    total_length += length * histogram[length];
+    if (histogram[length])
+      max_length = length;
+  }
+
+  auto stats = hash_table.stats();
+  ASSERT_EQ(hash_table.size(), stats.size);
+  ASSERT_EQ(max_length, stats.max_probe_length);
+  ASSERT_DOUBLE_EQ(stats.size ? 1.0 * total_length / stats.size : 0.0,
+                   stats.average_probe_length);
+}
+
+// Apply random sets and erases to |hash_table| and a std::unordered_map, and
+// check they always agree.
+template <typename Table>
+void check_against_map(Table& hash_table, int operations, int key_range) {
+  std::unordered_map<int, int> map;
+  std::mt19937 random(42);
+  for (int i = 0; i < operations; ++i) {
+    int key = static_cast<int>(random() % key_range);
+    if (random() % 2) {
+      hash_table.set(key, i);
+      map[key] = i;
+    } else {
+      ASSERT_EQ(map.erase(key) == 1, hash_table.erase(key));
+    }
+
+    if (i % 1000 == 0)
+      check_stats(hash_table);
+  }
+
+  ASSERT_EQ(map.size(), hash_table.size());
+  for (int key = 0; key < key_range; ++key) {
+    auto it = map.find(key);
+    int* value = hash_table.find(key);
+    ASSERT_EQ(it != map.end(), value != nullptr);
+    if (value)
+      ASSERT_EQ(it->second, *value);
+  }
+
+  // Iteration visits exactly the items of |map|.
+  std::size_t visited = 0;
+  for (auto item : hash_table) {
+    ASSERT_EQ(map.at(item.key), item.value);
+    ++visited;
+  }
+  ASSERT_EQ(map.size(), visited);
+  check_stats(hash_table);
+}
+
+// Number of allocations made by every |CountingAllocator|.
+std::size_t allocation_count = 0;
+
+// Allocator which counts allocations, so tests can tell keys and values are
+// moved rather than copied.
+template <typename T>
+struct CountingAllocator {
+  using value_type = T;
+
+  CountingAllocator() = default;
+  template <typename U>
+  CountingAllocator(const CountingAllocator<U>&) {}
+
+  T* allocate(std::size_t n) {
+    ++allocation_count;
+    return std::allocator<T>().allocate(n);
+  }
+  void deallocate(T* p, std::size_t n) { std::allocator<T>().deallocate(p, n); }
+
+  template <typename U>
+  bool operator==(const CountingAllocator<U>&) const {
+    return true;
+  }
+  template <typename U>
+  bool operator!=(const CountingAllocator<U>&) const {
+    return false;
+  }
+};
+
+using CountedString =
+    std::basic_string<char, std::char_traits<char>, CountingAllocator<char>>;
+using CountedVector = std::vector<int, CountingAllocator<int>>;
+
+struct CountedStringHash {
+  std::size_t operator()(const CountedString& key) const {
+    return Hash<std::string_view>()(std::string_view(key));
+  }
+};
+
+// Make |count| keys long enough to be allocated, and |count| values.
+void make_counted(std::size_t count,
+                  std::vector<CountedString>& keys,
+                  std::vector<CountedVector>& values) {
+  for (std::size_t i = 0; i < count; ++i) {
+    std::string key = "a key longer than small string " + std::to_string(i);
+    keys.emplace_back(key.begin(), key.end());
+    values.emplace_back(64, static_cast<int>(i));
+  }
+}
+
 TEST(HashTableTest, SetGet) {
-  HashTable<std::string> hash_table;
+  HashTable<std::string, std::string> hash_table;
   hash_table.set("1", "1v");
   hash_table.set("2", "2v");
   hash_table.set("3", "3v");
@@ -55,8 +177,26 @@ TEST(HashTableTest, SetGet) {
   EXPECT_EQ("22v", hash_table.get("2"));
 }
 
+TEST(HashTableTest, MissingKeyValues) {
+  // Only string values read a missing key as |null_node_value|, other
+  // values made from const char* read it as a value-initialized one.
+  HashTable<int, bool> bools;
+  bools.set(1, true);
+  EXPECT_TRUE(bools.get(1));
+  EXPECT_FALSE(bools.get(2));
+
+  HashTable<int, const char*> pointers;
+  EXPECT_EQ(nullptr, pointers.get(1));
+
+  HashTable<int, std::optional<std::string>> optionals;
+  EXPECT_FALSE(optionals.get(1).has_value());
+
+  HashTable<int, std::string_view> views;
+  EXPECT_EQ(null_node_value, views.get(1));
+}
+
 TEST(HashTableTest, Remove) {
-  HashTable<std::string> hash_table;
+  HashTable<std::string, std::string> hash_table;
   hash_table.set("1", "1v");
   hash_table.set("2", "2v");
   hash_table.set("3", "3v");
@@ -121,5 +261,551 @@ TEST(HashTableTest, Remove) {
   EXPECT_EQ(null_node_value, hash_table.get("1"));
 }
 
-}  // namespace
+TEST(HashTableTest, RemoveAndReinsert) {
+  HashTable<std::string, std::string> hash_table;
+
+  // Deleted slots must not pile up and make lookups loop forever.
+  for (int round = 0; round < 100; ++round) {
+    for (int i = 0; i < 5; ++i)
+      hash_table.set(std::to_string(round * 5 + i), std::to_string(i));
+    for (int i = 0; i < 5; ++i)
+      hash_table.remove(std::to_string(round * 5 + i));
+  }
+
+  EXPECT_EQ(null_node_value, hash_table.get("0"));
+  EXPECT_EQ(null_node_value, hash_table.get("499"));
+
+  hash_table.set("0", "0v");
+  EXPECT_EQ("0v", hash_table.get("0"));
+}
+
+TEST(HashTableTest, ManyKeys) {
+  HashTable<std::string, std::string> hash_table;
+
+  // Fill many groups so probe sequences cross group boundaries, then shrink
+  // back down.
+  for (int i = 0; i < 10000; ++i)
+    hash_table.set(std::to_string(i), std::to_string(i) + "v");
+  for (int i = 0; i < 10000; ++i)
+    EXPECT_EQ(std::to_string(i) + "v", hash_table.get(std::to_string(i)));
+
+  for (int i = 0; i < 10000; i += 2)
+    hash_table.remove(std::to_string(i));
+  for (int i = 0; i < 10000; ++i) {
+    std::string expected = i % 2 ? std::to_string(i) + "v" : null_node_value;
+    EXPECT_EQ(expected, hash_table.get(std::to_string(i)));
+  }
+
+  for (int i = 1; i < 10000; i += 2)
+    hash_table.remove(std::to_string(i));
+  EXPECT_EQ(null_node_value, hash_table.get("1"));
+}
+
+TEST(HashTableTest, IntegerKeys) {
+  HashTable<std::uint64_t, int> hash_table;
+  for (std::uint64_t i = 0; i < 1000; ++i)
+    hash_table.set(i << 32, static_cast<int>(i));
+
+  EXPECT_EQ(0, hash_table.get(0));
+  EXPECT_EQ(500, hash_table.get(std::uint64_t{500} << 32));
+  EXPECT_EQ(999, hash_table.get(std::uint64_t{999} << 32));
+
+  // Missing key returns a value-initialized value
+  EXPECT_EQ(0, hash_table.get(1));
 
+  hash_table.remove(std::uint64_t{500} << 32);
+  EXPECT_EQ(0, hash_table.get(std::uint64_t{500} << 32));
+}
+
+TEST(HashTableTest, HeterogeneousLookup) {
+  HashTable<std::string, int> hash_table;
+  hash_table.set("apple", 1);
+  hash_table.set("banana", 2);
+
+  std::string_view banana = "banana";
+  EXPECT_EQ(2, hash_table.get(banana));
+  EXPECT_EQ(1, hash_table.get("apple"));
+  EXPECT_EQ(0, hash_table.get(std::string_view("cherry")));
+
+  hash_table.remove(banana);
+  EXPECT_EQ(0, hash_table.get(banana));
+}
+
+TEST(HashTableTest, CustomHasher) {
+  HashTable<int, int, ConstantHash> hash_table;
+  for (int i = 0; i < 100; ++i)
+    hash_table.set(i, i * 10);
+
+  for (int i = 0; i < 100; ++i)
+    EXPECT_EQ(i * 10, hash_table.get(i));
+
+  for (int i = 0; i < 100; i += 3)
+    hash_table.remove(i);
+  for (int i = 0; i < 100; ++i)
+    EXPECT_EQ(i % 3 ? i * 10 : 0, hash_table.get(i));
+}
+
+TEST(HashTableTest, StringHash) {
+  Hash<std::string> hasher;
+  EXPECT_EQ(hasher(std::string("hello")), hasher(std::string_view("hello")));
+  EXPECT_NE(hasher(std::string("hello")), hasher(std::string("hellp")));
+
+  // Every length takes its own path through |hash_bytes|
+  std::string key;
+  std::size_t previous = hasher(key);
+  for (int i = 0; i < 100; ++i) {
+    key.push_back('a');
+    std::size_t current = hasher(key);
+    EXPECT_NE(previous, current);
+    previous = current;
+  }
+}
+
+TEST(HashTableTest, Find) {
+  HashTable<std::string, int> hash_table;
+  EXPECT_EQ(nullptr, hash_table.find("1"));
+
+  hash_table.set("1", 1);
+  int* value = hash_table.find("1");
+  ASSERT_NE(nullptr, value);
+  EXPECT_EQ(1, *value);
+
+  *value = 10;
+  EXPECT_EQ(10, hash_table.get("1"));
+}
+
+TEST(HashTableTest, TryEmplace) {
+  HashTable<std::string, std::string> hash_table;
+
+  std::pair<std::string*, bool> result = hash_table.try_emplace("1", 3, 'a');
+  EXPECT_TRUE(result.second);
+  EXPECT_EQ("aaa", *result.first);
+
+  // Existing value is kept
+  result = hash_table.try_emplace("1", "b");
+  EXPECT_FALSE(result.second);
+  EXPECT_EQ("aaa", *result.first);
+  EXPECT_EQ("aaa", hash_table.get("1"));
+}
+
+TEST(HashTableTest, InsertOrAssign) {
+  HashTable<std::string, std::string> hash_table;
+
+  std::pair<std::string*, bool> result = hash_table.insert_or_assign("1", "a");
+  EXPECT_TRUE(result.second);
+  EXPECT_EQ("a", *result.first);
+
+  result = hash_table.insert_or_assign("1", "b");
+  EXPECT_FALSE(result.second);
+  EXPECT_EQ("b", *result.first);
+  EXPECT_EQ("b", hash_table.get("1"));
+}
+
+TEST(HashTableTest, Erase) {
+  HashTable<int, int> hash_table;
+  for (int i = 0; i < 100; ++i)
+    hash_table.set(i, i);
+
+  EXPECT_TRUE(hash_table.erase(50));
+  EXPECT_FALSE(hash_table.erase(50));
+  EXPECT_FALSE(hash_table.erase(100));
+  EXPECT_EQ(nullptr, hash_table.find(50));
+
+  // Insert reuses freed slots
+  EXPECT_TRUE(hash_table.try_emplace(50, 500).second);
+  EXPECT_EQ(500, hash_table.get(50));
+}
+
+TEST(HashTableTest, IncrementalRehash) {
+  HashTable<int, int> hash_table(hash_table::Rehash::kIncremental);
+
+  // Every key must stay reachable while nodes move between tables.
+  for (int i = 0; i < 5000; ++i) {
+    hash_table.set(i, i);
+    ASSERT_EQ(i, hash_table.get(i));
+    ASSERT_EQ(i / 2, hash_table.get(i / 2));
+  }
+  for (int i = 0; i < 5000; ++i)
+    EXPECT_EQ(i, hash_table.get(i));
+
+  // Overwrite and erase keys which may still be in old table.
+  for (int i = 0; i < 5000; i += 2)
+    EXPECT_FALSE(hash_table.insert_or_assign(i, -i).second);
+  for (int i = 1; i < 5000; i += 2)
+    EXPECT_TRUE(hash_table.erase(i));
+  for (int i = 0; i < 5000; ++i)
+    EXPECT_EQ(i % 2 ? 0 : -i, hash_table.get(i));
+
+  // Shrink back down
+  for (int i = 0; i < 5000; i += 2)
+    EXPECT_TRUE(hash_table.erase(i));
+  for (int i = 0; i < 5000; ++i)
+    EXPECT_EQ(nullptr, hash_table.find(i));
+}
+
+TEST(HashTableTest, Emplace) {
+  HashTable<std::string, std::string> hash_table;
+
+  // Key is made from const char* only when it's inserted.
+  std::pair<std::string*, bool> result = hash_table.emplace("1", 3, 'a');
+  EXPECT_TRUE(result.second);
+  EXPECT_EQ("aaa", *result.first);
+
+  result = hash_table.emplace("1", "b");
+  EXPECT_FALSE(result.second);
+  EXPECT_EQ("aaa", hash_table.get("1"));
+
+  // Keys which can't be hashed directly are converted first.
+  HashTable<std::string, int, std::hash<std::string>> custom;
+  EXPECT_TRUE(custom.emplace("2", 2).second);
+  EXPECT_EQ(2, custom.get("2"));
+}
+
+TEST(HashTableTest, MoveOnlyValues) {
+  HashTable<int, std::unique_ptr<int>> hash_table;
+  for (int i = 0; i < 1000; ++i)
+    hash_table.set(i, std::make_unique<int>(i));
+  for (int i = 0; i < 1000; i += 2)
+    hash_table.try_emplace(i + 1000, std::make_unique<int>(i));
+
+  // Growth moved every value.
+  for (int i = 0; i < 1000; ++i)
+    EXPECT_EQ(i, **hash_table.find(i));
+
+  auto value = std::make_unique<int>(-1);
+  EXPECT_FALSE(hash_table.insert_or_assign(0, std::move(value)).second);
+  EXPECT_EQ(-1, **hash_table.find(0));
+}
+
+// Value whose copy throws if |fails| is set.
+struct Fragile {
+  Fragile(int value, bool fails) : value(value), fails(fails) {}
+  Fragile(const Fragile& other) : value(other.value), fails(other.fails) {
+    if (fails)
+      throw std::runtime_error("copy failed");
+  }
+  Fragile& operator=(const Fragile&) = default;
+
+  int value;
+  bool fails;
+};
+
+template <typename Table>
+void check_insert_that_throws(Table& hash_table) {
+  for (int i = 0; i < 100; ++i)
+    hash_table.set(i, Fragile(i, false));
+
+  Fragile fragile(-1, true);
+  EXPECT_THROW(hash_table.set(1000, fragile), std::runtime_error);
+  EXPECT_THROW(hash_table.try_emplace(1000, fragile), std::runtime_error);
+  EXPECT_THROW(hash_table.insert_or_assign(1000, fragile), std::runtime_error);
+
+  // Failed inserts left no slot behind.
+  EXPECT_EQ(100u, hash_table.size());
+  EXPECT_EQ(nullptr, hash_table.find(1000));
+  check_stats(hash_table);
+  for (int i = 0; i < 100; ++i)
+    EXPECT_EQ(i, hash_table.find(i)->value);
+
+  hash_table.set(1000, Fragile(1000, false));
+  EXPECT_EQ(1000, hash_table.find(1000)->value);
+  for (int i = 0; i < 100; ++i)
+    EXPECT_TRUE(hash_table.erase(i));
+  EXPECT_EQ(1u, hash_table.size());
+}
+
+TEST(HashTableTest, InsertThatThrows) {
+  HashTable<int, Fragile> group;
+  check_insert_that_throws(group);
+
+  HashTable<int, Fragile, ConstantHash, std::equal_to<>,
+            hash_table::RobinHoodProbing>
+      robin_hood;
+  check_insert_that_throws(robin_hood);
+}
+
+// Count allocations of keys and values per insert. Slot arrays of table are
+// not counted, only deep copies of keys and values are.
+TEST(HashTableTest, AllocationsPerInsert) {
+  constexpr std::size_t count = 5000;
+
+  for (hash_table::Rehash rehash :
+       {hash_table::Rehash::kAllAtOnce, hash_table::Rehash::kIncremental}) {
+    std::vector<CountedString> keys;
+    std::vector<CountedVector> values;
+    make_counted(count, keys, values);
+
+    // Copying inserts allocate one key and one value, growth copies nothing.
+    HashTable<CountedString, CountedVector, CountedStringHash> copied(
+        CountedStringHash(), std::equal_to<>(), rehash);
+    allocation_count = 0;
+    for (std::size_t i = 0; i < count; ++i)
+      copied.set(keys[i], values[i]);
+    EXPECT_EQ(2 * count, allocation_count);
+    RecordProperty("copy_set_allocations_per_insert",
+                   std::to_string(1.0 * allocation_count / count));
+
+    CountedString existing_key = keys[0];
+
+    // Moving inserts and growth allocate nothing.
+    HashTable<CountedString, CountedVector, CountedStringHash> moved(
+        CountedStringHash(), std::equal_to<>(), rehash);
+    allocation_count = 0;
+    for (std::size_t i = 0; i < count; ++i)
+      moved.set(std::move(keys[i]), std::move(values[i]));
+    EXPECT_EQ(0, allocation_count);
+    RecordProperty("move_set_allocations_per_insert",
+                   std::to_string(1.0 * allocation_count / count));
+
+    // Overwriting an existing key doesn't copy it.
+    CountedVector value(64, -1);
+    allocation_count = 0;
+    copied.set(existing_key, std::move(value));
+    EXPECT_EQ(0, allocation_count);
+    EXPECT_EQ(-1, (*copied.find(existing_key))[0]);
+  }
+}
+
+TEST(HashTableTest, Reserve) {
+  HashTable<int, int> hash_table;
+  hash_table.reserve(1000);
+  for (int i = 0; i < 1000; ++i)
+    hash_table.set(i, i);
+
+  // Reserved capacity is kept when table is emptied.
+  for (int i = 0; i < 1000; ++i)
+    EXPECT_TRUE(hash_table.erase(i));
+  for (int i = 0; i < 1000; ++i)
+    hash_table.set(i, -i);
+  for (int i = 0; i < 1000; ++i)
+    EXPECT_EQ(-i, hash_table.get(i));
+}
+
+TEST(HashTableTest, BulkConstructor) {
+  std::vector<std::pair<std::string, int>> items;
+  for (int i = 0; i < 1000; ++i)
+    items.emplace_back(std::to_string(i), i);
+  items.emplace_back("7", 700);
+
+  HashTable<std::string, int> hash_table(items.begin(), items.end());
+  for (int i = 0; i < 1000; ++i)
+    EXPECT_EQ(i == 7 ? 700 : i, hash_table.get(std::to_string(i)));
+
+  // Keys and values are moved out of a range of rvalues.
+  HashTable<std::string, int> moved(std::make_move_iterator(items.begin()),
+                                    std::make_move_iterator(items.end()));
+  EXPECT_EQ(999, moved.get("999"));
+  EXPECT_EQ(700, moved.get("7"));
+}
+
+TEST(HashTableTest, GetMany) {
+  HashTable<int, int> hash_table;
+  for (int i = 0; i < 1000; ++i)
+    hash_table.set(i, i * 2);
+
+  std::vector<int> keys;
+  for (int i = 0; i < 1100; i += 3)
+    keys.push_back(i);
+  std::vector<int> values;
+  hash_table.get_many(keys, std::back_inserter(values));
+
+  ASSERT_EQ(keys.size(), values.size());
+  for (std::size_t i = 0; i < keys.size(); ++i)
+    EXPECT_EQ(keys[i] < 1000 ? keys[i] * 2 : 0, values[i]);
+
+  // Keys still in old table of an incremental rehash are found too.
+  HashTable<std::string, std::string> incremental(
+      hash_table::Rehash::kIncremental);
+  for (int i = 0; i < 100; ++i)
+    incremental.set(std::to_string(i), std::to_string(-i));
+  std::vector<std::string_view> string_keys{"0", "50", "99", "100"};
+  std::vector<std::string> string_values(string_keys.size());
+  incremental.get_many(string_keys, string_values.begin());
+  EXPECT_EQ("0", string_values[0]);
+  EXPECT_EQ("-50", string_values[1]);
+  EXPECT_EQ("-99", string_values[2]);
+  EXPECT_EQ(null_node_value, string_values[3]);
+}
+
+TEST(HashTableTest, ForEach) {
+  HashTable<int, int> hash_table(hash_table::Rehash::kIncremental);
+  for (int i = 0; i < 1000; ++i)
+    hash_table.set(i, i);
+  EXPECT_EQ(1000, hash_table.size());
+
+  // Items of both tables of an incremental rehash are visited once.
+  std::vector<int> seen(1000, 0);
+  hash_table.for_each([&](int key, int value) {
+    EXPECT_EQ(key, value);
+    ++seen[key];
+  });
+  for (int count : seen)
+    EXPECT_EQ(1, count);
+}
+
+TEST(HashTableTest, Iterators) {
+  HashTable<int, int> hash_table(hash_table::Rehash::kIncremental);
+  EXPECT_TRUE(hash_table.begin() == hash_table.end());
+
+  for (int i = 0; i < 1000; ++i)
+    hash_table.set(i, i);
+
+  // Items of both tables of an incremental rehash are visited once, values
+  // can be assigned through iterators.
+  std::vector<int> seen(1000, 0);
+  for (auto item : hash_table) {
+    EXPECT_EQ(item.key, item.value);
+    ++seen[item.key];
+    item.value = -item.key;
+  }
+  for (int count : seen)
+    EXPECT_EQ(1, count);
+  EXPECT_EQ(-10, hash_table.get(10));
+
+  const HashTable<int, int>& const_table = hash_table;
+  EXPECT_EQ(1000, std::distance(const_table.begin(), const_table.end()));
+  HashTable<int, int>::const_iterator it = const_table.begin();
+  EXPECT_EQ(-it->key, it->value);
+
+  // Removed items aren't visited, empty groups are skipped.
+  for (int i = 0; i < 1000; ++i) {
+    if (i % 100)
+      hash_table.remove(i);
+  }
+  int sum = 0;
+  for (auto item : hash_table)
+    sum += item.key;
+  EXPECT_EQ(4500, sum);
+}
+
+TEST(HashTableTest, PrecomputedHash) {
+  HashTable<std::string, std::string> hash_table;
+  Hash<std::string> hasher;
+  for (int i = 0; i < 100; ++i) {
+    std::string key = std::to_string(i);
+    hash_table.set(key, key + "v", hasher(key));
+  }
+
+  // Same slots as found by hashing again.
+  EXPECT_EQ("42v", hash_table.get("42"));
+  ASSERT_NE(nullptr, hash_table.find("42", hasher("42")));
+  EXPECT_EQ("42v", *hash_table.find("42", hasher("42")));
+  EXPECT_EQ(nullptr, hash_table.find("100", hasher("100")));
+
+  EXPECT_TRUE(hash_table.erase("42", hasher("42")));
+  EXPECT_FALSE(hash_table.erase("42", hasher("42")));
+  EXPECT_EQ(nullptr, hash_table.find("42"));
+  EXPECT_EQ(99, hash_table.size());
+}
+
+TEST(HashTableTest, Stats) {
+  HashTable<int, int, ConstantHash> colliding;
+  hash_table::Stats stats = colliding.stats();
+  EXPECT_EQ(0, stats.size);
+  EXPECT_EQ(default_capacity, stats.capacity);
+  EXPECT_EQ(0, stats.max_probe_length);
+  EXPECT_EQ(0, stats.average_probe_length);
+
+  // Same layout as in ProbeHistogram: 16, 16 and 8 keys found after probing
+  // 1, 2 and 3 groups. Table grew twice on the way.
+  for (int i = 0; i < 40; ++i)
+    colliding.set(i, i);
+  stats = colliding.stats();
+  EXPECT_EQ(40, stats.size);
+  EXPECT_EQ(64, stats.capacity);
+  EXPECT_EQ(0, stats.tombstones);
+  EXPECT_EQ(3, stats.max_probe_length);
+  EXPECT_DOUBLE_EQ(72.0 / 40, stats.average_probe_length);
+  EXPECT_EQ(2, stats.rehash_count);
+  EXPECT_DOUBLE_EQ(40.0 / 64, stats.load_factor());
+
+  // First group is full, so removing from it leaves a tombstone.
+  colliding.remove(0);
+  stats = colliding.stats();
+  EXPECT_EQ(39, stats.size);
+  EXPECT_EQ(1, stats.tombstones);
+  EXPECT_DOUBLE_EQ(71.0 / 39, stats.average_probe_length);
+
+  // Removing the last group's keys shortens the longest probe.
+  for (int i = 32; i < 40; ++i)
+    colliding.remove(i);
+  EXPECT_EQ(2, colliding.stats().max_probe_length);
+  check_stats(colliding);
+}
+
+TEST(HashTableTest, RobinHood) {
+  HashTable<std::string, std::string, Hash<std::string>, std::equal_to<>,
+            hash_table::RobinHoodProbing>
+      hash_table;
+  hash_table.set("1", "1v");
+  hash_table.set("2", "2v");
+  EXPECT_EQ("1v", hash_table.get("1"));
+  EXPECT_EQ("2v", hash_table.get("2"));
+  EXPECT_EQ(null_node_value, hash_table.get("3"));
+
+  hash_table.remove("1");
+  EXPECT_EQ(null_node_value, hash_table.get("1"));
+  EXPECT_EQ("2v", hash_table.get("2"));
+
+  for (int i = 0; i < 1000; ++i)
+    hash_table.set(std::to_string(i), std::to_string(i));
+  for (int i = 0; i < 1000; i += 2)
+    hash_table.remove(std::to_string(i));
+  for (int i = 0; i < 1000; ++i)
+    EXPECT_EQ(i % 2 ? std::to_string(i) : null_node_value,
+              hash_table.get(std::to_string(i)));
+}
+
+TEST(HashTableTest, RandomOperations) {
+  HashTable<int, int> group;
+  check_against_map(group, 100000, 2000);
+
+  HashTable<int, int, Hash<int>, std::equal_to<>,
+            hash_table::RobinHoodProbing>
+      robin_hood;
+  check_against_map(robin_hood, 100000, 2000);
+
+  HashTable<int, int, Hash<int>, std::equal_to<>,
+            hash_table::RobinHoodProbing>
+      incremental(hash_table::Rehash::kIncremental);
+  check_against_map(incremental, 100000, 2000);
+}
+
+TEST(HashTableTest, RobinHoodLongRuns) {
+  // All keys share a home slot, so distances pass what a control byte holds.
+  HashTable<int, int, ConstantHash, std::equal_to<>,
+            hash_table::RobinHoodProbing>
+      hash_table;
+  check_against_map(hash_table, 5000, 300);
+}
+
+TEST(HashTableTest, ProbeHistogram) {
+  HashTable<int, int, ConstantHash> colliding;
+  for (int i = 0; i < 40; ++i)
+    colliding.set(i, i);
+
+  // 40 colliding keys fill 2 groups and part of a third.
+  std::vector<std::size_t> histogram = colliding.probe_histogram();
+  ASSERT_EQ(4, histogram.size());
+  EXPECT_EQ(0, histogram[0]);
+  EXPECT_EQ(16, histogram[1]);
+  EXPECT_EQ(16, histogram[2]);
+  EXPECT_EQ(8, histogram[3]);
+
+  HashTable<int, int, ConstantHash, std::equal_to<>,
+            hash_table::RobinHoodProbing>
+      robin_hood;
+  for (int i = 0; i < 10; ++i)
+    robin_hood.set(i, i);
+  histogram = robin_hood.probe_histogram();
+  ASSERT_EQ(11, histogram.size());
+  for (std::size_t length = 1; length <= 10; ++length)
+    EXPECT_EQ(1, histogram[length]);
+
+  // Removal shifts the rest back, so no probe gets longer.
+  robin_hood.remove(0);
+  histogram = robin_hood.probe_histogram();
+  EXPECT_EQ(10, histogram.size());
+}
+
+}  // namespace
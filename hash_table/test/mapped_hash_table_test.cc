@@ -0,0 +1,216 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
+#include "hash_table/mapped_hash_table.h"
+#include "gtest/gtest.h"
+
+namespace {
+using namespace td;
+
+// Return path of a snapshot file in test temporary directory.
+std::string snapshot_path(const std::string& name) {
+  return testing::TempDir() + name + ".snapshot";
+}
+
+// Flip one byte of file at |path|, |offset| bytes from its end.
+void corrupt(const std::string& path, long offset) {
+  std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+  file.seekg(-offset, std::ios::end);
+  char byte = static_cast<char>(file.get());
+  file.seekp(-offset, std::ios::end);
+  file.put(static_cast<char>(byte ^ 1));
+}
+
+// Overwrite 8 bytes of file at |path|, |offset| bytes from its start.
+void overwrite(const std::string& path, long offset, std::uint64_t value) {
+  std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+  file.seekp(offset);
+  file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+// Read whole file at |path|.
+std::string read_file(const std::string& path) {
+  std::ifstream file(path, std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(file), {});
+}
+
+// Write |bytes| of a snapshot with |capacity| slots to |path|, with a
+// checksum which matches, as someone who tampered with the file could.
+void write_resealed(const std::string& path,
+                    std::string bytes,
+                    std::size_t capacity) {
+  const char* ctrl = bytes.data() + 64;
+  const char* slots = ctrl + capacity;
+  const char* arena = slots + capacity * 16;
+  std::uint64_t checksum = hash_table::mix(
+      hash_table::mix(hash_table::hash_bytes(ctrl, capacity),
+                      hash_table::hash_bytes(slots, capacity * 16)),
+      hash_table::hash_bytes(arena, bytes.data() + bytes.size() - arena));
+  std::memcpy(bytes.data() + 56, &checksum, sizeof(checksum));
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  file << bytes;
+}
+
+TEST(MappedHashTableTest, WriteAndOpen) {
+  HashTable<std::string, std::string> hash_table;
+  for (int i = 0; i < 1000; ++i)
+    hash_table.set("key" + std::to_string(i), "value" + std::to_string(i));
+  hash_table.set("", "empty key");
+  hash_table.set("empty value", "");
+
+  std::string path = snapshot_path("write_and_open");
+  MappedHashTable::write(path, hash_table);
+
+  MappedHashTable mapped(path);
+  EXPECT_EQ(1002, mapped.size());
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_EQ("value" + std::to_string(i),
+              mapped.get("key" + std::to_string(i)));
+  }
+  EXPECT_EQ("empty key", mapped.get(""));
+  EXPECT_EQ("", mapped.get("empty value"));
+  EXPECT_EQ(null_node_value, mapped.get("key1000"));
+  std::remove(path.c_str());
+}
+
+TEST(MappedHashTableTest, EmptyTable) {
+  HashTable<std::string, std::string> hash_table;
+  std::string path = snapshot_path("empty_table");
+  MappedHashTable::write(path, hash_table);
+
+  MappedHashTable mapped(path);
+  EXPECT_EQ(0, mapped.size());
+  EXPECT_EQ(null_node_value, mapped.get("1"));
+  std::remove(path.c_str());
+}
+
+TEST(MappedHashTableTest, InvalidFiles) {
+  EXPECT_THROW(MappedHashTable(snapshot_path("missing")), std::runtime_error);
+
+  HashTable<std::string, std::string> hash_table;
+  hash_table.set("1", "1v");
+  std::string path = snapshot_path("invalid_files");
+
+  // Data which doesn't match checksum is only caught by a full check.
+  MappedHashTable::write(path, hash_table);
+  corrupt(path, 1);
+  EXPECT_THROW(MappedHashTable(path, hash_table::Verify::kChecksum),
+               std::runtime_error);
+  EXPECT_NO_THROW(MappedHashTable(path, hash_table::Verify::kHeader));
+
+  // Truncated file
+  MappedHashTable::write(path, hash_table);
+  {
+    std::ofstream file(path, std::ios::binary | std::ios::app);
+    file.put('x');
+  }
+  EXPECT_THROW(MappedHashTable(path, hash_table::Verify::kHeader),
+               std::runtime_error);
+
+  // Unknown version, it directly follows 8 bytes of magic.
+  MappedHashTable::write(path, hash_table);
+  {
+    std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+    file.seekp(8);
+    file.put(static_cast<char>(hash_table::snapshot_version + 1));
+  }
+  EXPECT_THROW(MappedHashTable(path, hash_table::Verify::kHeader),
+               std::runtime_error);
+
+  // Sections which don't fit in the file. Capacity, slots offset and arena
+  // offset, at 16, 32 and 40, are consistent, and arena size, at 48, wraps
+  // around to end of the file.
+  MappedHashTable::write(path, hash_table);
+  {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    std::uint64_t length = file.tellg();
+    std::uint64_t capacity = 256;
+    std::uint64_t arena_offset = 64 + capacity + capacity * 16;
+    overwrite(path, 16, capacity);
+    overwrite(path, 32, 64 + capacity);
+    overwrite(path, 40, arena_offset);
+    overwrite(path, 48, length - arena_offset);
+  }
+  EXPECT_THROW(MappedHashTable(path, hash_table::Verify::kHeader),
+               std::runtime_error);
+
+  // Not a snapshot at all
+  {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file << std::string(100, 'x');
+  }
+  EXPECT_THROW(MappedHashTable(path, hash_table::Verify::kHeader),
+               std::runtime_error);
+  std::remove(path.c_str());
+}
+
+TEST(MappedHashTableTest, ItemOutsideArena) {
+  HashTable<std::string, std::string> hash_table;
+  hash_table.set("1", "1v");
+  std::string path = snapshot_path("item_outside_arena");
+  MappedHashTable::write(path, hash_table);
+
+  // Make key of the only item longer than arena.
+  std::string bytes = read_file(path);
+  std::size_t capacity = hash_table::group_width;
+  const char* ctrl = bytes.data() + 64;
+  char* slots = bytes.data() + 64 + capacity;
+  for (std::size_t i = 0; i < capacity; ++i) {
+    if (hash_table::is_full(ctrl[i])) {
+      std::uint32_t key_length = 1000;
+      std::memcpy(slots + i * 16 + 8, &key_length, sizeof(key_length));
+    }
+  }
+  write_resealed(path, bytes, capacity);
+
+  EXPECT_THROW(MappedHashTable(path, hash_table::Verify::kChecksum),
+               std::runtime_error);
+  std::remove(path.c_str());
+}
+
+TEST(MappedHashTableTest, NoEmptySlot) {
+  HashTable<std::string, std::string> hash_table;
+  hash_table.set("1", "1v");
+  std::string path = snapshot_path("no_empty_slot");
+  MappedHashTable::write(path, hash_table);
+  std::string bytes = read_file(path);
+  std::size_t capacity = hash_table::group_width;
+  char* ctrl = bytes.data() + 64;
+
+  // Every free slot is a tombstone, so lookups of missing keys meet no empty
+  // slot. Item count still matches, so the file opens.
+  for (std::size_t i = 0; i < capacity; ++i) {
+    if (!hash_table::is_full(ctrl[i]))
+      ctrl[i] = hash_table::deleted_ctrl;
+  }
+  write_resealed(path, bytes, capacity);
+  {
+    MappedHashTable mapped(path, hash_table::Verify::kChecksum);
+    EXPECT_EQ("1v", mapped.get("1"));
+    EXPECT_EQ(null_node_value, mapped.get("2"));
+  }
+
+  // Every slot is full, which only a header check lets through.
+  std::memset(ctrl, 1, capacity);
+  write_resealed(path, bytes, capacity);
+  EXPECT_THROW(MappedHashTable(path, hash_table::Verify::kChecksum),
+               std::runtime_error);
+  {
+    MappedHashTable mapped(path, hash_table::Verify::kHeader);
+    EXPECT_EQ(null_node_value, mapped.get("2"));
+  }
+
+  // Header size, which checksum doesn't cover, disagrees with items.
+  MappedHashTable::write(path, hash_table);
+  overwrite(path, 24, 2);
+  EXPECT_THROW(MappedHashTable(path, hash_table::Verify::kChecksum),
+               std::runtime_error);
+  std::remove(path.c_str());
+}
+
+}  // namespace
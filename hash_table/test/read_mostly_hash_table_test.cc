@@ -0,0 +1,108 @@
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "hash_table/read_mostly_hash_table.h"
+#include "gtest/gtest.h"
+
+namespace {
+using namespace td;
+
+TEST(ReadMostlyHashTableTest, SetGetRemove) {
+  ReadMostlyHashTable<std::string, std::string> hash_table;
+  hash_table.set("1", "1v");
+  hash_table.set("2", "2v");
+
+  EXPECT_EQ("1v", hash_table.get("1"));
+  EXPECT_EQ("2v", hash_table.get("2"));
+  EXPECT_EQ(null_node_value, hash_table.get("3"));
+  EXPECT_EQ(2, hash_table.size());
+
+  hash_table.set("1", "11v");
+  EXPECT_EQ("11v", hash_table.get("1"));
+  EXPECT_EQ(2, hash_table.size());
+
+  hash_table.remove("1");
+  EXPECT_EQ(null_node_value, hash_table.get("1"));
+  EXPECT_EQ(1, hash_table.size());
+
+  hash_table.set("1", "111v");
+  EXPECT_EQ("111v", hash_table.get("1"));
+}
+
+TEST(ReadMostlyHashTableTest, ManyKeys) {
+  ReadMostlyHashTable<int, int> hash_table;
+  for (int i = 0; i < 10000; ++i)
+    hash_table.set(i, i);
+  for (int i = 0; i < 10000; i += 2)
+    hash_table.remove(i);
+
+  EXPECT_EQ(5000, hash_table.size());
+  for (int i = 0; i < 10000; ++i)
+    EXPECT_EQ(i % 2 ? i : 0, hash_table.get(i));
+
+  // Tombstones are reused or cleared by rehash.
+  for (int round = 0; round < 10; ++round) {
+    for (int i = 0; i < 10000; i += 2)
+      hash_table.set(i, i);
+    for (int i = 0; i < 10000; i += 2)
+      hash_table.remove(i);
+  }
+  EXPECT_EQ(5000, hash_table.size());
+  EXPECT_EQ(9999, hash_table.get(9999));
+}
+
+TEST(ReadMostlyHashTableTest, HeterogeneousLookup) {
+  ReadMostlyHashTable<std::string, int> hash_table;
+  hash_table.set("key", 1);
+
+  std::string_view key = "key";
+  EXPECT_EQ(1, hash_table.get(key));
+  hash_table.remove(key);
+  EXPECT_EQ(0, hash_table.get(key));
+}
+
+// Readers check every value they see belongs to its key while one writer
+// replaces, removes and grows. Run under ThreadSanitizer with ENABLE_TSAN.
+TEST(ReadMostlyHashTableTest, ReadersWhileWriting) {
+  constexpr int reader_count = 4;
+  constexpr int key_count = 1000;
+  ReadMostlyHashTable<int, std::string> hash_table;
+  for (int i = 0; i < key_count; ++i)
+    hash_table.set(i, std::to_string(i));
+
+  std::atomic<bool> done{false};
+  std::atomic<int> bad_reads{0};
+  std::vector<std::thread> readers;
+  for (int t = 0; t < reader_count; ++t) {
+    readers.emplace_back([&hash_table, &done, &bad_reads, t] {
+      int i = t;
+      while (!done.load(std::memory_order_relaxed)) {
+        int key = i++ % (key_count * 4);
+        std::string value = hash_table.get(key);
+        if (value != null_node_value && value != std::to_string(key) &&
+            value != std::to_string(key) + "'")
+          bad_reads.fetch_add(1, std::memory_order_relaxed);
+      }
+    });
+  }
+
+  for (int round = 0; round < 20; ++round) {
+    for (int i = 0; i < key_count; ++i)
+      hash_table.set(i, std::to_string(i) + (round % 2 ? "'" : ""));
+    for (int i = key_count; i < key_count * 4; ++i)
+      hash_table.set(i, std::to_string(i));
+    for (int i = key_count; i < key_count * 4; ++i)
+      hash_table.remove(i);
+  }
+  done.store(true, std::memory_order_relaxed);
+  for (std::thread& reader : readers)
+    reader.join();
+
+  EXPECT_EQ(0, bad_reads.load());
+  EXPECT_EQ(key_count, hash_table.size());
+  EXPECT_EQ("7'", hash_table.get(7));
+}
+
+}  // namespace
@@ -0,0 +1,59 @@
+#include <cstdlib>
+#include <memory>
+
+#include "linked_list/linked_list.h"
+#include "utils/allocator.h"
+#include "utils/bench.h"
+
+namespace {
+
+using namespace td;
+
+// Build lists of |size| nodes |rounds| times, read every node once and
+// destroy the list. |reset| runs after each list is destroyed.
+template <typename Allocator, typename Reset>
+void bench_build_and_discard(const char* name,
+                             std::size_t size,
+                             std::size_t rounds,
+                             const Allocator& allocator,
+                             Reset&& reset) {
+  double total_ns = bench::elapsed_ns([&] {
+    for (std::size_t round = 0; round < rounds; ++round) {
+      {
+        LinkedList<int, Allocator> list(allocator);
+        for (std::size_t i = 0; i < size; ++i) {
+          list.push_front(static_cast<int>(i));
+        }
+        bench::do_not_optimize(list.value_at(size - 1));
+      }
+      reset();
+    }
+  });
+  bench::report(name, total_ns, size * rounds);
+}
+
+// Measure building and discarding lists with each allocator. Time is per
+// node and covers allocating, reading and freeing it.
+void bench_allocators(std::size_t size, std::size_t rounds) {
+  bench_build_and_discard("build and discard list, std::allocator", size,
+                          rounds, std::allocator<int>(), [] {});
+
+  MonotonicArena arena;
+  bench_build_and_discard("build and discard list, ArenaAllocator", size,
+                          rounds, ArenaAllocator<int>(arena),
+                          [&] { arena.reset(); });
+
+  // A node of int is an int and a pointer.
+  FixedSizePool pool(2 * sizeof(void*));
+  bench_build_and_discard("build and discard list, PoolAllocator", size,
+                          rounds, PoolAllocator<int>(pool), [] {});
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  std::size_t size = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+
+  bench_allocators(size, 20);
+  return 0;
+}
@@ -1,30 +1,38 @@
 #pragma once
 
 #include <iostream>
+#include <memory>
 
 #include "utils/utils.h"
 
 namespace td {
 
-template <typename DataType>
+template <typename DataType, typename Allocator = std::allocator<DataType>>
 class LinkedList;
 
-template <typename DataType>
-void swap(LinkedList<DataType>& rhs, LinkedList<DataType>& lhs);
+template <typename DataType, typename Allocator>
+void swap(LinkedList<DataType, Allocator>& rhs,
+          LinkedList<DataType, Allocator>& lhs);
 
-// A linked list template
-template <typename DataType>
+// A linked list template. Nodes are allocated by |Allocator|, a standard
+// allocator which is rebound to nodes, such as |ArenaAllocator| to free a
+// whole list with its arena. The allocator is copied, moved and swapped
+// along with nodes.
+template <typename DataType, typename Allocator>
 class LinkedList {
  public:
   LinkedList() = default;
+  explicit LinkedList(const Allocator& allocator);
   LinkedList(const DataType& value);
   LinkedList(std::initializer_list<DataType> il);
 
-  LinkedList(const LinkedList<DataType>& other);
-  LinkedList(LinkedList<DataType>&& other);
+  LinkedList(const LinkedList<DataType, Allocator>& other);
+  LinkedList(LinkedList<DataType, Allocator>&& other);
 
-  LinkedList<DataType>& operator=(const LinkedList<DataType>& other);
-  LinkedList<DataType>& operator=(LinkedList<DataType>&& other);
+  LinkedList<DataType, Allocator>& operator=(
+      const LinkedList<DataType, Allocator>& other);
+  LinkedList<DataType, Allocator>& operator=(
+      LinkedList<DataType, Allocator>&& other);
 
   ~LinkedList();
 
@@ -73,8 +81,8 @@ class LinkedList {
   // Swap values inside |lhs| and |rhs|.
   // Follow copy-and-swap idiom
   // https://stackoverflow.com/questions/3279543/what-is-the-copy-and-swap-idiom
-  friend void swap<DataType>(LinkedList<DataType>& lhs,
-                             LinkedList<DataType>& rhs);
+  friend void swap<DataType, Allocator>(LinkedList<DataType, Allocator>& lhs,
+                                        LinkedList<DataType, Allocator>& rhs);
 
  private:
   // Node's data type
@@ -86,6 +94,12 @@ class LinkedList {
     Node(const DataType& d, Node* n) : data(d), next(n) {}
   };
 
+  using NodeAllocator =
+      typename std::allocator_traits<Allocator>::template rebind_alloc<Node>;
+  using NodeAllocatorTraits = std::allocator_traits<NodeAllocator>;
+
+  NodeAllocator allocator_;
+
   // Pointer points to the first node in list.
   Node* head_{nullptr};
 
@@ -94,6 +108,13 @@ class LinkedList {
 
   // Release all nodes in list, assign nullptr to |head_|
   void release_head();
+
+  // Allocate a node and construct it from |args|.
+  template <typename... Args>
+  Node* create_node(Args&&... args);
+
+  // Destroy |node| and free its memory.
+  void destroy_node(Node* node);
 };
 
 }  // namespace td
@@ -101,84 +122,97 @@ class LinkedList {
 /****************  Linked List implmentation ****************/
 namespace td {
 
-template <typename DataType>
-void swap(LinkedList<DataType>& lhs, LinkedList<DataType>& rhs) {
+template <typename DataType, typename Allocator>
+void swap(LinkedList<DataType, Allocator>& lhs,
+          LinkedList<DataType, Allocator>& rhs) {
   using std::swap;
 
+  swap(lhs.allocator_, rhs.allocator_);
   swap(lhs.head_, rhs.head_);
   swap(lhs.size_, rhs.size_);
 }
 
 // Public
-template <typename DataType>
-LinkedList<DataType>::LinkedList(const DataType& value)
-    : head_(new Node(value)), size_(1) {}
+template <typename DataType, typename Allocator>
+LinkedList<DataType, Allocator>::LinkedList(const Allocator& allocator)
+    : allocator_(allocator) {}
+
+template <typename DataType, typename Allocator>
+LinkedList<DataType, Allocator>::LinkedList(const DataType& value)
+    : head_(create_node(value)), size_(1) {}
 
-template <typename DataType>
-LinkedList<DataType>::LinkedList(std::initializer_list<DataType> il) {
+template <typename DataType, typename Allocator>
+LinkedList<DataType, Allocator>::LinkedList(
+    std::initializer_list<DataType> il) {
   for (int i = il.size() - 1; i >= 0; --i) {
     push_front(il.begin()[i]);
   }
 }
 
-template <typename DataType>
-LinkedList<DataType>::LinkedList(const LinkedList<DataType>& other)
-    : size_(other.size_) {
+template <typename DataType, typename Allocator>
+LinkedList<DataType, Allocator>::LinkedList(
+    const LinkedList<DataType, Allocator>& other)
+    : allocator_(NodeAllocatorTraits::select_on_container_copy_construction(
+          other.allocator_)),
+      size_(other.size_) {
   release_head();
 
   Node* other_head = other.head_;
   Node** pp_tail = &head_;
 
   while (other_head) {
-    *pp_tail = new Node(other_head->data);
+    *pp_tail = create_node(other_head->data);
     pp_tail = &(*pp_tail)->next;
     other_head = other_head->next;
   }
 }
 
-template <typename DataType>
-LinkedList<DataType>::LinkedList(LinkedList<DataType>&& other)
-    : head_(other.head_), size_(other.size_) {
+template <typename DataType, typename Allocator>
+LinkedList<DataType, Allocator>::LinkedList(
+    LinkedList<DataType, Allocator>&& other)
+    : allocator_(std::move(other.allocator_)),
+      head_(other.head_),
+      size_(other.size_) {
   other.head_ = nullptr;
   other.size_ = 0;
 }
 
-template <typename DataType>
-LinkedList<DataType>& LinkedList<DataType>::operator=(
-    const LinkedList<DataType>& other) {
-  LinkedList<DataType> temp(other);
+template <typename DataType, typename Allocator>
+LinkedList<DataType, Allocator>& LinkedList<DataType, Allocator>::operator=(
+    const LinkedList<DataType, Allocator>& other) {
+  LinkedList<DataType, Allocator> temp(other);
   swap(*this, temp);
   return *this;
 }
 
-template <typename DataType>
-LinkedList<DataType>& LinkedList<DataType>::operator=(
-    LinkedList<DataType>&& other) {
+template <typename DataType, typename Allocator>
+LinkedList<DataType, Allocator>& LinkedList<DataType, Allocator>::operator=(
+    LinkedList<DataType, Allocator>&& other) {
   // Maybe shouldn't use |swap| method for move assignment operator
   // https://stackoverflow.com/questions/6687388/why-do-some-people-use-swap-for-move-assignments
-  LinkedList<DataType> temp = std::move(other);
+  LinkedList<DataType, Allocator> temp = std::move(other);
   swap(*this, temp);
   return *this;
 }
 
-template <typename DataType>
-LinkedList<DataType>::~LinkedList() {
+template <typename DataType, typename Allocator>
+LinkedList<DataType, Allocator>::~LinkedList() {
   size_ = 0;
   release_head();
 }
 
-template <typename DataType>
-std::size_t LinkedList<DataType>::size() {
+template <typename DataType, typename Allocator>
+std::size_t LinkedList<DataType, Allocator>::size() {
   return size_;
 }
 
-template <typename DataType>
-bool LinkedList<DataType>::is_empty() {
+template <typename DataType, typename Allocator>
+bool LinkedList<DataType, Allocator>::is_empty() {
   return size_ == 0;
 }
 
-template <typename DataType>
-DataType LinkedList<DataType>::value_at(std::size_t index) {
+template <typename DataType, typename Allocator>
+DataType LinkedList<DataType, Allocator>::value_at(std::size_t index) {
   utils::validate(index, size_, utils::Action::kNone);
 
   Node* target_node = head_;
@@ -188,17 +222,17 @@ DataType LinkedList<DataType>::value_at(std::size_t index) {
   return target_node->data;
 }
 
-template <typename DataType>
-void LinkedList<DataType>::push_front(const DataType& value) {
+template <typename DataType, typename Allocator>
+void LinkedList<DataType, Allocator>::push_front(const DataType& value) {
   ++size_;
 
   Node* current_head = head_;
-  head_ = new Node(value);
+  head_ = create_node(value);
   head_->next = current_head;
 }
 
-template <typename DataType>
-DataType LinkedList<DataType>::pop_front() {
+template <typename DataType, typename Allocator>
+DataType LinkedList<DataType, Allocator>::pop_front() {
   utils::validate(0, size_--, utils::Action::kRemove);
 
   // Get returned data
@@ -209,13 +243,13 @@ DataType LinkedList<DataType>::pop_front() {
   head_ = head_->next;
 
   // Clean up
-  delete removed_node;
+  destroy_node(removed_node);
 
   return data;
 }
 
-template <typename DataType>
-void LinkedList<DataType>::push_back(const DataType& value) {
+template <typename DataType, typename Allocator>
+void LinkedList<DataType, Allocator>::push_back(const DataType& value) {
   // Get last node
   Node** pp_node = &head_;
   while (*pp_node) {
@@ -223,12 +257,12 @@ void LinkedList<DataType>::push_back(const DataType& value) {
   }
 
   // Add new node to the end of list
-  *pp_node = new Node(value);
+  *pp_node = create_node(value);
   ++size_;
 }
 
-template <typename DataType>
-DataType LinkedList<DataType>::pop_back() {
+template <typename DataType, typename Allocator>
+DataType LinkedList<DataType, Allocator>::pop_back() {
   std::size_t last_index = size_ - 1;
   utils::validate(last_index, size_--, utils::Action::kRemove);
 
@@ -246,23 +280,24 @@ DataType LinkedList<DataType>::pop_back() {
   *pp_tail_node = nullptr;
 
   // Clean up
-  delete tail_node;
+  destroy_node(tail_node);
 
   return data;
 }
 
-template <typename DataType>
-DataType LinkedList<DataType>::front() {
+template <typename DataType, typename Allocator>
+DataType LinkedList<DataType, Allocator>::front() {
   return value_at(0);
 }
 
-template <typename DataType>
-DataType LinkedList<DataType>::back() {
+template <typename DataType, typename Allocator>
+DataType LinkedList<DataType, Allocator>::back() {
   return value_at(size_ - 1);
 }
 
-template <typename DataType>
-void LinkedList<DataType>::insert(const DataType& value, std::size_t index) {
+template <typename DataType, typename Allocator>
+void LinkedList<DataType, Allocator>::insert(const DataType& value,
+                                             std::size_t index) {
   utils::validate(index, size_++, utils::Action::kInsert);
 
   // Find node at given index
@@ -273,12 +308,12 @@ void LinkedList<DataType>::insert(const DataType& value, std::size_t index) {
   }
 
   // Insert new node to the list
-  Node* new_node = new Node(value, *pp_node);
+  Node* new_node = create_node(value, *pp_node);
   *pp_node = new_node;
 }
 
-template <typename DataType>
-void LinkedList<DataType>::remove_at(std::size_t index) {
+template <typename DataType, typename Allocator>
+void LinkedList<DataType, Allocator>::remove_at(std::size_t index) {
   utils::validate(index, size_--, utils::Action::kRemove);
 
   // Find removed node
@@ -293,18 +328,18 @@ void LinkedList<DataType>::remove_at(std::size_t index) {
   *pp_node = removed_node->next;
 
   // Clean up
-  delete removed_node;
+  destroy_node(removed_node);
 }
 
-template <typename DataType>
-void LinkedList<DataType>::remove(const DataType& value) {
+template <typename DataType, typename Allocator>
+void LinkedList<DataType, Allocator>::remove(const DataType& value) {
   Node** pp_node = &head_;
 
   while (*pp_node) {
     if ((*pp_node)->data == value) {
       Node* removed_node = *pp_node;
       *pp_node = removed_node->next;
-      delete removed_node;
+      destroy_node(removed_node);
       --size_;
       return;
     }
@@ -313,14 +348,14 @@ void LinkedList<DataType>::remove(const DataType& value) {
   }
 }
 
-template <typename DataType>
-DataType LinkedList<DataType>::value_from_back(std::size_t index) {
+template <typename DataType, typename Allocator>
+DataType LinkedList<DataType, Allocator>::value_from_back(std::size_t index) {
   std::size_t index_from_front = size_ - index - 1;
   return value_at(index_from_front);
 }
 
-template <typename DataType>
-void LinkedList<DataType>::reverse() {
+template <typename DataType, typename Allocator>
+void LinkedList<DataType, Allocator>::reverse() {
   Node* curr_node = head_;
   Node* prev_node = nullptr;
   Node* next_node = nullptr;
@@ -336,13 +371,34 @@ void LinkedList<DataType>::reverse() {
 }
 
 // Private
-template <typename DataType>
-void LinkedList<DataType>::release_head() {
+template <typename DataType, typename Allocator>
+void LinkedList<DataType, Allocator>::release_head() {
   while (head_) {
     Node* next_node = head_->next;
-    delete head_;
+    destroy_node(head_);
     head_ = next_node;
   }
 }
 
+template <typename DataType, typename Allocator>
+template <typename... Args>
+typename LinkedList<DataType, Allocator>::Node*
+LinkedList<DataType, Allocator>::create_node(Args&&... args) {
+  Node* node = NodeAllocatorTraits::allocate(allocator_, 1);
+  try {
+    NodeAllocatorTraits::construct(allocator_, node,
+                                   std::forward<Args>(args)...);
+  } catch (...) {
+    NodeAllocatorTraits::deallocate(allocator_, node, 1);
+    throw;
+  }
+  return node;
+}
+
+template <typename DataType, typename Allocator>
+void LinkedList<DataType, Allocator>::destroy_node(Node* node) {
+  NodeAllocatorTraits::destroy(allocator_, node);
+  NodeAllocatorTraits::deallocate(allocator_, node, 1);
+}
+
 }  // namespace td
@@ -1,5 +1,8 @@
 #include "linked_list/linked_list.h"
 #include "gtest/gtest.h"
+#include "utils/allocator.h"
+
+#include <string>
 
 namespace {
 using namespace td;
@@ -297,4 +300,39 @@ TEST(LinkedListTest, Reverse) {
   EXPECT_EQ(1, linked_list.value_at(4));
 }
 
+TEST(LinkedListTest, Allocators) {
+  MonotonicArena arena;
+  using ArenaList = LinkedList<std::string, ArenaAllocator<std::string>>;
+  ArenaList arena_list{ArenaAllocator<std::string>(arena)};
+  for (int i = 0; i < 100; ++i) {
+    arena_list.push_front(std::string(32, 'a' + i % 26));
+  }
+  arena_list.pop_back();
+  arena_list.insert("middle", 50);
+  EXPECT_EQ(100, arena_list.size());
+  EXPECT_EQ("middle", arena_list.value_at(50));
+  EXPECT_LE(100 * sizeof(std::string), arena.bytes_allocated());
+
+  // Copies and moves keep the arena.
+  std::size_t bytes_allocated = arena.bytes_allocated();
+  ArenaList copied_list = arena_list;
+  ArenaList moved_list = std::move(copied_list);
+  EXPECT_EQ(100, moved_list.size());
+  EXPECT_EQ("middle", moved_list.value_at(50));
+  EXPECT_LT(bytes_allocated, arena.bytes_allocated());
+
+  FixedSizePool pool(32);
+  LinkedList<int, PoolAllocator<int>> pool_list{PoolAllocator<int>(pool)};
+  for (int i = 0; i < 10000; ++i) {
+    pool_list.push_front(i);
+  }
+  for (int i = 0; i < 5000; ++i) {
+    pool_list.pop_front();
+  }
+  pool_list.remove(100);
+  EXPECT_EQ(4999, pool_list.size());
+  EXPECT_EQ(4999, pool_list.front());
+  EXPECT_EQ(0, pool_list.back());
+}
+
 }  // namespace
@@ -0,0 +1,276 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <limits>
+#include <memory>
+#include <new>
+#include <vector>
+
+#include "utils/macros.h"
+
+namespace td {
+
+// Memory resource which hands out memory by bumping a pointer through large
+// chunks and never frees single allocations. Everything is freed at once by
+// |reset| or on destruction, so structures which live for one request can be
+// built without a malloc per node and dropped in one step.
+class MonotonicArena {
+ public:
+  static constexpr std::size_t default_chunk_size = 1 << 20;
+
+  // New chunks hold at least |chunk_size| bytes.
+  explicit MonotonicArena(std::size_t chunk_size = default_chunk_size);
+  ~MonotonicArena();
+
+  // Return |bytes| bytes aligned to |alignment|, a power of two.
+  void* allocate(std::size_t bytes, std::size_t alignment);
+
+  // Free all allocations. The newest chunk is kept for reuse.
+  void reset();
+
+  // Return bytes handed out since construction or last |reset|.
+  std::size_t bytes_allocated() const;
+
+ private:
+  // Header at the start of each chunk, memory for allocations follows.
+  struct Chunk {
+    Chunk* next;
+    std::size_t size;
+  };
+
+  // Start a chunk with room for at least |bytes| bytes aligned to
+  // |alignment|.
+  void add_chunk(std::size_t bytes, std::size_t alignment);
+
+  // Newest chunk, which allocations are taken from, linked to older ones.
+  Chunk* chunks_{nullptr};
+
+  // Unused part of newest chunk.
+  char* current_{nullptr};
+  char* end_{nullptr};
+
+  std::size_t chunk_size_;
+  std::size_t bytes_allocated_{0};
+
+  DISALLOW_COPY_AND_ASSIGN(MonotonicArena);
+};
+
+// Memory resource of equally sized blocks, carved from large chunks and kept
+// on a free list when deallocated, so allocating and freeing a node are a few
+// pointer moves. Blocks are aligned for any type.
+class FixedSizePool {
+ public:
+  // Pool of blocks of at least |block_size| bytes, taken from the system
+  // |blocks_per_chunk| at a time.
+  explicit FixedSizePool(std::size_t block_size,
+                         std::size_t blocks_per_chunk = 4096);
+  ~FixedSizePool();
+
+  // Return a block.
+  void* allocate();
+
+  // Return |block| to pool.
+  void deallocate(void* block);
+
+  // Free all blocks, including ones which weren't deallocated.
+  void reset();
+
+  // Return size of blocks.
+  std::size_t block_size() const;
+
+ private:
+  // An unused block links to next one.
+  struct FreeBlock {
+    FreeBlock* next;
+  };
+
+  std::size_t block_size_;
+  std::size_t blocks_per_chunk_;
+
+  FreeBlock* free_blocks_{nullptr};
+
+  // Part of newest chunk which was never handed out.
+  char* unused_{nullptr};
+  char* unused_end_{nullptr};
+
+  std::vector<void*> chunks_;
+
+  DISALLOW_COPY_AND_ASSIGN(FixedSizePool);
+};
+
+// Return size of a memory page.
+std::size_t page_size();
+
+// Return |bytes| bytes of zeroed pages mapped from the system. Sizes are
+// rounded up to whole pages.
+void* map_pages(std::size_t bytes);
+
+// Resize |pages|, mapped by |map_pages| with |old_bytes| bytes, to
+// |new_bytes| bytes and return their new address. Contents are kept up to
+// the smaller size. On Linux, pages are extended in place when possible and
+// otherwise moved by remapping, never copied.
+void* remap_pages(void* pages, std::size_t old_bytes, std::size_t new_bytes);
+
+// Return |pages|, mapped by |map_pages| with |bytes| bytes, to the system.
+void unmap_pages(void* pages, std::size_t bytes);
+
+// Standard allocator which uses malloc and free. Containers can grow storage
+// of trivially copyable items allocated with it by realloc.
+template <typename T>
+class MallocAllocator {
+ public:
+  using value_type = T;
+
+  MallocAllocator() = default;
+
+  template <typename U>
+  MallocAllocator(const MallocAllocator<U>&) {}
+
+  T* allocate(std::size_t count);
+  void deallocate(T* items, std::size_t count);
+};
+
+// Standard allocator which takes memory from a |MonotonicArena|.
+// |deallocate| does nothing, memory comes back when arena is reset.
+template <typename T>
+class ArenaAllocator {
+ public:
+  using value_type = T;
+
+  explicit ArenaAllocator(MonotonicArena& arena) : arena_(&arena) {}
+
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U>& other) : arena_(other.arena_) {}
+
+  T* allocate(std::size_t count);
+  void deallocate(T*, std::size_t) {}
+
+  MonotonicArena* arena() const { return arena_; }
+
+ private:
+  template <typename U>
+  friend class ArenaAllocator;
+
+  MonotonicArena* arena_;
+};
+
+// Standard allocator which takes single items from a |FixedSizePool|, for
+// nodes of linked structures. Allocations larger than the pool's blocks go to
+// operator new.
+template <typename T>
+class PoolAllocator {
+ public:
+  using value_type = T;
+
+  explicit PoolAllocator(FixedSizePool& pool) : pool_(&pool) {}
+
+  template <typename U>
+  PoolAllocator(const PoolAllocator<U>& other) : pool_(other.pool_) {}
+
+  T* allocate(std::size_t count);
+  void deallocate(T* items, std::size_t count);
+
+  FixedSizePool* pool() const { return pool_; }
+
+ private:
+  template <typename U>
+  friend class PoolAllocator;
+
+  // Return true if |count| items fit in a block of pool.
+  bool fits_block(std::size_t count) const;
+
+  FixedSizePool* pool_;
+};
+
+template <typename T, typename U>
+bool operator==(const MallocAllocator<T>&, const MallocAllocator<U>&) {
+  return true;
+}
+
+template <typename T, typename U>
+bool operator!=(const MallocAllocator<T>&, const MallocAllocator<U>&) {
+  return false;
+}
+
+template <typename T, typename U>
+bool operator==(const ArenaAllocator<T>& lhs, const ArenaAllocator<U>& rhs) {
+  return lhs.arena() == rhs.arena();
+}
+
+template <typename T, typename U>
+bool operator!=(const ArenaAllocator<T>& lhs, const ArenaAllocator<U>& rhs) {
+  return lhs.arena() != rhs.arena();
+}
+
+template <typename T, typename U>
+bool operator==(const PoolAllocator<T>& lhs, const PoolAllocator<U>& rhs) {
+  return lhs.pool() == rhs.pool();
+}
+
+template <typename T, typename U>
+bool operator!=(const PoolAllocator<T>& lhs, const PoolAllocator<U>& rhs) {
+  return lhs.pool() != rhs.pool();
+}
+
+}  // namespace td
+
+/****************  Allocator implementation ****************/
+namespace td {
+
+// Malloc allocator
+
+template <typename T>
+T* MallocAllocator<T>::allocate(std::size_t count) {
+  if (count > std::numeric_limits<std::size_t>::max() / sizeof(T)) {
+    throw std::bad_alloc();
+  }
+
+  void* items = std::malloc(count * sizeof(T));
+  if (!items) {
+    throw std::bad_alloc();
+  }
+  return static_cast<T*>(items);
+}
+
+template <typename T>
+void MallocAllocator<T>::deallocate(T* items, std::size_t) {
+  std::free(items);
+}
+
+// Arena allocator
+
+template <typename T>
+T* ArenaAllocator<T>::allocate(std::size_t count) {
+  if (count > std::numeric_limits<std::size_t>::max() / sizeof(T)) {
+    throw std::bad_alloc();
+  }
+  return static_cast<T*>(arena_->allocate(count * sizeof(T), alignof(T)));
+}
+
+// Pool allocator
+
+template <typename T>
+T* PoolAllocator<T>::allocate(std::size_t count) {
+  if (fits_block(count)) {
+    return static_cast<T*>(pool_->allocate());
+  }
+  return std::allocator<T>().allocate(count);
+}
+
+template <typename T>
+void PoolAllocator<T>::deallocate(T* items, std::size_t count) {
+  if (fits_block(count)) {
+    pool_->deallocate(items);
+  } else {
+    std::allocator<T>().deallocate(items, count);
+  }
+}
+
+template <typename T>
+bool PoolAllocator<T>::fits_block(std::size_t count) const {
+  return count <= pool_->block_size() / sizeof(T) &&
+         alignof(T) <= alignof(std::max_align_t);
+}
+
+}  // namespace td
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+namespace td {
+namespace bench {
+
+// Prevent compiler from optimizing away computation of |value|.
+template <typename T>
+inline void do_not_optimize(const T& value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Run |function| once and return elapsed time in nanoseconds.
+template <typename Function>
+double elapsed_ns(Function&& function) {
+  auto start = std::chrono::steady_clock::now();
+  function();
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(end - start).count();
+}
+
+// Print one result line: |name|, time per operation and operations per second.
+inline void report(const char* name, double total_ns, std::size_t operations) {
+  double ns_per_op = total_ns / operations;
+  std::printf("%-48s %10.2f ns/op %14.0f ops/s\n", name, ns_per_op,
+              1e9 / ns_per_op);
+}
+
+// Print percentiles of per-operation |latencies_ns|. Sorts |latencies_ns|.
+inline void report_latency(const char* name,
+                           std::vector<double>& latencies_ns) {
+  std::sort(latencies_ns.begin(), latencies_ns.end());
+  auto percentile = [&](double p) {
+    std::size_t index = static_cast<std::size_t>(p * (latencies_ns.size() - 1));
+    return latencies_ns[index];
+  };
+  std::printf("%-48s p50 %8.0f  p99 %8.0f  p999 %10.0f  max %12.0f ns\n",
+              name, percentile(0.5), percentile(0.99), percentile(0.999),
+              latencies_ns.back());
+}
+
+}  // namespace bench
+}  // namespace td
@@ -7,6 +7,10 @@ namespace td {
 // A value indicating that a requested item couldn’t be found or doesn’t exist.
 constexpr std::size_t index_not_found = -1;
 
+// Size of a cache line. Data written by different threads is aligned to it so
+// the writes don't invalidate each other's cache lines.
+constexpr std::size_t cache_line_size = 64;
+
 namespace utils {
 
 // Specifies action which will be performed after `validate` method is called.
@@ -0,0 +1,193 @@
+#include "utils/allocator.h"
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+namespace td {
+
+namespace {
+
+// Return |pointer| rounded up to a multiple of |alignment|, a power of two.
+char* align_up(char* pointer, std::size_t alignment) {
+  std::uintptr_t address = reinterpret_cast<std::uintptr_t>(pointer);
+  std::uintptr_t aligned = (address + alignment - 1) & ~(alignment - 1);
+  return pointer + (aligned - address);
+}
+
+// Return |bytes| rounded up to whole pages.
+std::size_t page_bytes(std::size_t bytes) {
+  std::size_t size = page_size();
+  return (bytes + size - 1) / size * size;
+}
+
+}  // namespace
+
+// Page memory
+
+std::size_t page_size() {
+  static const std::size_t size =
+      static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+  return size;
+}
+
+void* map_pages(std::size_t bytes) {
+  void* pages = ::mmap(nullptr, page_bytes(bytes), PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (pages == MAP_FAILED) {
+    throw std::bad_alloc();
+  }
+  return pages;
+}
+
+void* remap_pages(void* pages, std::size_t old_bytes, std::size_t new_bytes) {
+  old_bytes = page_bytes(old_bytes);
+  new_bytes = page_bytes(new_bytes);
+  if (old_bytes == new_bytes) {
+    return pages;
+  }
+
+#if defined(__linux__)
+  void* new_pages = ::mremap(pages, old_bytes, new_bytes, MREMAP_MAYMOVE);
+  if (new_pages == MAP_FAILED) {
+    throw std::bad_alloc();
+  }
+  return new_pages;
+#else
+  void* new_pages = map_pages(new_bytes);
+  std::memcpy(new_pages, pages, std::min(old_bytes, new_bytes));
+  unmap_pages(pages, old_bytes);
+  return new_pages;
+#endif
+}
+
+void unmap_pages(void* pages, std::size_t bytes) {
+  ::munmap(pages, page_bytes(bytes));
+}
+
+// Monotonic arena
+
+MonotonicArena::MonotonicArena(std::size_t chunk_size)
+    : chunk_size_(chunk_size) {}
+
+MonotonicArena::~MonotonicArena() {
+  while (chunks_) {
+    Chunk* next = chunks_->next;
+    std::free(chunks_);
+    chunks_ = next;
+  }
+}
+
+void* MonotonicArena::allocate(std::size_t bytes, std::size_t alignment) {
+  char* result = current_ ? align_up(current_, alignment) : nullptr;
+  if (!result || result > end_ ||
+      static_cast<std::size_t>(end_ - result) < bytes) {
+    add_chunk(bytes, alignment);
+    result = align_up(current_, alignment);
+  }
+
+  current_ = result + bytes;
+  bytes_allocated_ += bytes;
+  return result;
+}
+
+void MonotonicArena::reset() {
+  if (!chunks_) {
+    return;
+  }
+
+  Chunk* older = chunks_->next;
+  while (older) {
+    Chunk* next = older->next;
+    std::free(older);
+    older = next;
+  }
+
+  chunks_->next = nullptr;
+  current_ = reinterpret_cast<char*>(chunks_ + 1);
+  end_ = reinterpret_cast<char*>(chunks_) + chunks_->size;
+  bytes_allocated_ = 0;
+}
+
+std::size_t MonotonicArena::bytes_allocated() const {
+  return bytes_allocated_;
+}
+
+void MonotonicArena::add_chunk(std::size_t bytes, std::size_t alignment) {
+  std::size_t size =
+      std::max(chunk_size_, sizeof(Chunk) + alignment - 1 + bytes);
+  Chunk* chunk = static_cast<Chunk*>(std::malloc(size));
+  if (!chunk) {
+    throw std::bad_alloc();
+  }
+
+  chunk->next = chunks_;
+  chunk->size = size;
+  chunks_ = chunk;
+  current_ = reinterpret_cast<char*>(chunk + 1);
+  end_ = reinterpret_cast<char*>(chunk) + size;
+}
+
+// Fixed size pool
+
+FixedSizePool::FixedSizePool(std::size_t block_size,
+                             std::size_t blocks_per_chunk)
+    : blocks_per_chunk_(std::max<std::size_t>(blocks_per_chunk, 1)) {
+  // Every block must hold a free list link and keep the next block aligned.
+  constexpr std::size_t alignment = alignof(std::max_align_t);
+  block_size = std::max(block_size, sizeof(FreeBlock));
+  block_size_ = (block_size + alignment - 1) / alignment * alignment;
+}
+
+FixedSizePool::~FixedSizePool() {
+  reset();
+}
+
+void* FixedSizePool::allocate() {
+  if (free_blocks_) {
+    FreeBlock* block = free_blocks_;
+    free_blocks_ = block->next;
+    return block;
+  }
+
+  if (unused_ == unused_end_) {
+    void* chunk = std::malloc(block_size_ * blocks_per_chunk_);
+    if (!chunk) {
+      throw std::bad_alloc();
+    }
+
+    chunks_.push_back(chunk);
+    unused_ = static_cast<char*>(chunk);
+    unused_end_ = unused_ + block_size_ * blocks_per_chunk_;
+  }
+
+  void* block = unused_;
+  unused_ += block_size_;
+  return block;
+}
+
+void FixedSizePool::deallocate(void* block) {
+  FreeBlock* free_block = static_cast<FreeBlock*>(block);
+  free_block->next = free_blocks_;
+  free_blocks_ = free_block;
+}
+
+void FixedSizePool::reset() {
+  for (void* chunk : chunks_) {
+    std::free(chunk);
+  }
+
+  chunks_.clear();
+  free_blocks_ = nullptr;
+  unused_ = nullptr;
+  unused_end_ = nullptr;
+}
+
+std::size_t FixedSizePool::block_size() const {
+  return block_size_;
+}
+
+}  // namespace td
@@ -0,0 +1,109 @@
+#include <algorithm>
+#include <cstdint>
+#include <list>
+#include <set>
+#include <vector>
+
+#include "utils/allocator.h"
+#include "gtest/gtest.h"
+
+namespace {
+
+using namespace td;
+
+bool is_aligned(const void* pointer, std::size_t alignment) {
+  return reinterpret_cast<std::uintptr_t>(pointer) % alignment == 0;
+}
+
+TEST(AllocatorTest, MonotonicArena) {
+  MonotonicArena arena(256);
+  char* first = static_cast<char*>(arena.allocate(3, 1));
+  void* second = arena.allocate(8, 8);
+  EXPECT_TRUE(is_aligned(second, 8));
+  EXPECT_GE(static_cast<char*>(second), first + 3);
+  EXPECT_EQ(11, arena.bytes_allocated());
+
+  // Larger than a chunk.
+  void* large = arena.allocate(1000, 64);
+  EXPECT_TRUE(is_aligned(large, 64));
+  std::fill_n(static_cast<char*>(large), 1000, 'x');
+
+  for (int i = 0; i < 100; ++i) {
+    arena.allocate(24, 8);
+  }
+
+  arena.reset();
+  EXPECT_EQ(0, arena.bytes_allocated());
+  EXPECT_TRUE(is_aligned(arena.allocate(16, 16), 16));
+}
+
+TEST(AllocatorTest, FixedSizePool) {
+  FixedSizePool pool(20, 4);
+  EXPECT_EQ(32, pool.block_size());
+
+  std::set<void*> blocks;
+  for (int i = 0; i < 10; ++i) {
+    void* block = pool.allocate();
+    EXPECT_TRUE(is_aligned(block, alignof(std::max_align_t)));
+    EXPECT_TRUE(blocks.insert(block).second);
+  }
+
+  // Freed blocks are reused first.
+  void* block = *blocks.begin();
+  pool.deallocate(block);
+  EXPECT_EQ(block, pool.allocate());
+
+  pool.reset();
+  pool.allocate();
+}
+
+TEST(AllocatorTest, StandardContainers) {
+  MonotonicArena arena;
+  {
+    std::vector<int, ArenaAllocator<int>> vector{ArenaAllocator<int>(arena)};
+    for (int i = 0; i < 1000; ++i) {
+      vector.push_back(i);
+    }
+    EXPECT_EQ(999, vector.back());
+  }
+  EXPECT_GE(arena.bytes_allocated(), 1000 * sizeof(int));
+
+  FixedSizePool pool(64);
+  std::list<int, PoolAllocator<int>> list{PoolAllocator<int>(pool)};
+  for (int i = 0; i < 1000; ++i) {
+    list.push_back(i);
+  }
+  list.remove_if([](int item) { return item % 2; });
+  EXPECT_EQ(500, list.size());
+
+  std::vector<int, MallocAllocator<int>> malloc_vector(100, 7);
+  EXPECT_EQ(7, malloc_vector[99]);
+
+  EXPECT_TRUE(ArenaAllocator<int>(arena) == ArenaAllocator<char>(arena));
+  FixedSizePool other_pool(64);
+  EXPECT_TRUE(PoolAllocator<int>(pool) != PoolAllocator<int>(other_pool));
+}
+
+TEST(AllocatorTest, PageMemory) {
+  std::size_t size = page_size();
+  EXPECT_EQ(0, size & (size - 1));
+
+  char* pages = static_cast<char*>(map_pages(size + 1));
+  EXPECT_EQ(0, reinterpret_cast<std::uintptr_t>(pages) % size);
+  EXPECT_EQ(0, pages[size]);
+  for (std::size_t i = 0; i < 2 * size; ++i) {
+    pages[i] = static_cast<char>(i);
+  }
+
+  pages = static_cast<char*>(remap_pages(pages, 2 * size, 64 * size));
+  for (std::size_t i = 0; i < 2 * size; ++i) {
+    EXPECT_EQ(static_cast<char>(i), pages[i]);
+  }
+  EXPECT_EQ(0, pages[64 * size - 1]);
+
+  pages = static_cast<char*>(remap_pages(pages, 64 * size, size));
+  EXPECT_EQ(static_cast<char>(size - 1), pages[size - 1]);
+  unmap_pages(pages, size);
+}
+
+}  // namespace